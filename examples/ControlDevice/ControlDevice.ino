@@ -81,4 +81,5 @@ void setup() {
 
 void loop() {
   server.handleClient();
+  root.doDevice();                     // Devices do a unit of work, and event subscribers are notified
 }
@@ -30,18 +30,36 @@ using namespace lsc;
 const char on_msg[]     PROGMEM = "<br><div align=\"center\">Control is ON</div>";
 const char off_msg[]    PROGMEM = "<br><div align=\"center\">Control is OFF</div>";
 
+/**
+ * When the page containing the iFrame follows the RootDevice event stream, the slider sets the state in the background
+ * and the new content arrives as an event; otherwise the link reloads the iFrame
+ */
+#define ASYNC_TOGGLE "onclick=\"if(parent.upnpEvents&&parent.upnpEvents.readyState==1){fetch(this.href+'&async=1');return false;}\""
+
 /**
  * Control Slider ON
  */
-const char relay_on[]   PROGMEM = "<div align=\"center\"><a href=\"./setState?STATE=OFF\" class=\"toggle\"><input class=\"toggle-checkbox\" type=\"checkbox\" checked>"
+const char relay_on[]   PROGMEM = "<div align=\"center\"><a href=\"./setState?STATE=OFF\" class=\"toggle\" " ASYNC_TOGGLE "><input class=\"toggle-checkbox\" type=\"checkbox\" checked>"
                                    "<span class=\"toggle-switch\"></span></a>&emsp;ON</div>";
 
 /**
  * Control Slider OFF
  */
-const char relay_off[]  PROGMEM = "<div align=\"center\">&ensp;<a href=\"./setState?STATE=ON\" class=\"toggle\"><input class=\"toggle-checkbox\" type=\"checkbox\">"
+const char relay_off[]  PROGMEM = "<div align=\"center\">&ensp;<a href=\"./setState?STATE=ON\" class=\"toggle\" " ASYNC_TOGGLE "><input class=\"toggle-checkbox\" type=\"checkbox\">"
                                    "<span class=\"toggle-switch\"></span></a>&emsp;OFF</div>";
 
+/**
+ *  setState arguments: STATE is OFF or ON (the ControlState), and async marks a background request
+ */
+struct StateArgs {
+  int      state;
+  boolean  async;
+};
+
+const char* const CustomControl_states[] = {"OFF","ON"};
+const Parameter   CustomControl_params[] = {Parameter::choice("STATE",offsetof(StateArgs,state),CustomControl_states,2),
+                                            Parameter::flag("async",offsetof(StateArgs,async))};
+
 /**
  *  Static RTT and UPnP Type initialization
  */
@@ -52,22 +70,35 @@ INITIALIZE_UPnP_TYPE(CustomControl,urn:LeelanauSoftware-com:device:CustomControl
  *  The only expected arguments are STATE=ON or STATE=OFF, all other arguments are ignored
  */
 void CustomControl::setState(WebContext* svr) {
-   int numArgs = svr->argCount();
-   if( numArgs > 0 ) {
-      for( int i=0; i<numArgs; i++ ) {
-         const String& argName = svr->argName(i);
-         const String& argVal = svr->arg(i);
-         if(argName.equalsIgnoreCase("STATE")) {
-            if( argVal.equalsIgnoreCase("ON")) setControlState(ON);
-            else if( argVal.equalsIgnoreCase("OFF") ) setControlState(OFF);
-            break;
-          }
-       }
-   }
-
-/** Control refresh is only within the iFrame
+   StateArgs args = {OFF,false};
+   uint32_t  bound = Parameter::bind(svr,CustomControl_params,&args);
+   if( Parameter::isBound(bound,0) ) setControlState((args.state == ON)?(ON):(OFF));
+
+/** A background request (async) needs no content, the event stream redraws the Control. 
+ *  Otherwise control refresh is only within the iFrame
+ */
+   if( args.async ) svr->send(204,"text/plain","");
+   else displayControl(svr);
+}
+
+/**
+ *  Content is cached, so mark it dirty, and notify event subscribers of the new state
+ */
+void CustomControl::setControlState(ControlState flag) {
+   if( flag == _state ) return;
+   _state = flag;
+   markDirty();
+   getConfiguration()->propertiesChanged();
+}
+
+/**
+ *  Subscribers to the getConfiguration service are sent the display name and control state
  */
-   displayControl(svr);
+void CustomControl::setEventProperties() {
+   getConfiguration()->setEventProperties([this](ResponseStream& out) {
+      UPnPService::formatProperty(out,"displayName",getDisplayName());
+      UPnPService::formatProperty(out,"controlState",controlState());
+   });
 }
 
 void  CustomControl::content(char buffer[], int size) {  
@@ -82,9 +113,17 @@ void  CustomControl::content(char buffer[], int size) {
   }         
 }
 
+/**
+ *  Register the setState handler at setup, and dispatch requests for it to setState(); 
+ *  all other handler names are dispatched by Control
+ */
 void CustomControl::setup(WebContext* svr) {
    Control::setup(svr);
-   char pathBuffer[100];
-   handlerPath(pathBuffer,100,"setState");
-   svr->on(pathBuffer,[this](WebContext* svr){this->setState(svr);});  
+   registerHandler(svr,"setState");
+}
+
+boolean CustomControl::dispatch(WebContext* svr, const char* handlerName) {
+   if( strcmp(handlerName,"setState") != 0 ) return Control::dispatch(svr,handlerName);
+   setState(svr);
+   return true;
 }
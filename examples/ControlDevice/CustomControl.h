@@ -41,9 +41,9 @@ using namespace lsc;
 class CustomControl : public Control {
 
   public: 
-      CustomControl() : Control("customControl") {setDisplayName("Custom Control");}
+      CustomControl() : Control("customControl") {setDisplayName("Custom Control"); setRenderCache(true); setEventProperties();}
 
-      CustomControl( const char* target ) : Control(target) {setDisplayName("Custom Control");}
+      CustomControl( const char* target ) : Control(target) {setDisplayName("Custom Control"); setRenderCache(true); setEventProperties();}
 
       virtual int     frameHeight()  {return 100;}       // Frame height from Control
 
@@ -62,12 +62,14 @@ class CustomControl : public Control {
  */
       void             content(char buffer[], int size);
       void             setup(WebContext* svr);
+      boolean          dispatch(WebContext* svr, const char* handlerName);
  
       DEFINE_RTTI;
       DERIVED_TYPE_CHECK(Control);
 
       protected:
-      void                 setControlState(ControlState flag) {_state = flag;}            
+      void                 setControlState(ControlState flag);
+      void                 setEventProperties();
 
 /**
  *    Control Variables
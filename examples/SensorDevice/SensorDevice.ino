@@ -70,6 +70,7 @@ void setup() {
   root.addDevices(&s);
   root.setDisplayName("Sensor Test");
   root.setTarget("root");  
+  root.configStore()->begin(&root);    // Restore names, targets, UUIDs and the sensor message saved before restart
   root.setup(&ctx);
   
 /**
@@ -84,6 +85,7 @@ void setup() {
 
 void loop() {
   server.handleClient();
+  root.doDevice();                     // Devices do a unit of work, and event subscribers are notified
 }
 
 void printInfo(UPnPDevice* d) {
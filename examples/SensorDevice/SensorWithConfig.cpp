@@ -23,25 +23,9 @@
 #include "SensorWithConfig.h"
 
 /**
- *   Config template defines a bit of XML to return device configuration. It MUST be of the following form:
- *      <?xml version=\"1.0\" encoding=\"UTF-8\"?>"
- *         <config>
- *            ...
- *         </config>
- *
- *   and SHOULD include 
- *         <displayName>Device Display Name</displayName>
- */
-const char  SensorWithConfig_config_template[]  PROGMEM = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
-                                                             "<config>"
-                                                                "<displayName>%s</displayName>"
-                                                                "<msg>%s</msg>"
-                                                               "</config>";
-
-/**
- *   Config Form template to allow input of Sensor message and display name
+ *   Config Form template to allow input of Sensor message and display name, split into literal text and slots at compile time
  */
-const char  SensorWithConfig_config_form[] PROGMEM = "<br><br><form action=\"%s\">"             // Form submit path 
+PAGE_TEMPLATE(SensorWithConfigForm, "<br><br><form action=\"%s\">"                        // Form submit path 
             "<div align=\"center\">"
               "<label for=\"displayName\">Sensor Name &nbsp &nbsp</label>"
               "<input type=\"text\" placeholder=\"%s\" name=\"displayName\"><br><br>"           // Sensor displayName  
@@ -49,13 +33,24 @@ const char  SensorWithConfig_config_form[] PROGMEM = "<br><br><form action=\"%s\
               "<input type=\"text\" placeholder=\"%s\" name=\"msg\">&nbsp<br><br>"              // Sensor Message     
               "<button class=\"fmButton\" type=\"submit\">Submit</button>&nbsp&nbsp"
               "<button class=\"fmButton\" type=\"button\" onclick=\"window.location.href=\'%s\';\">Cancel</button>"  
-            "</div></form>";
+            "</div></form>");
 
 /** Leelanau Software Company namespace 
 *  
 */
 using namespace lsc;
 
+/**
+ *   Configuration arguments, bound from the request by setConfiguration()
+ */
+struct SensorArgs {
+  char  displayName[NAME_SIZE];
+  char  msg[BUFF_SIZE];
+};
+
+const Parameter SensorWithConfig_params[] = {Parameter::text("displayName",offsetof(SensorArgs,displayName),NAME_SIZE,1),
+                                             Parameter::text("msg",offsetof(SensorArgs,msg),BUFF_SIZE)};
+
 /**
  *   UPnP required device type, defined as urn:CompanyName:device:deviceName:version where CompanyName 
  *   substitutes "." with "-". 
@@ -70,16 +65,16 @@ INITIALIZE_UPnP_TYPE(SensorWithConfig,urn:LeelanauSoftware-com:device:SensorWith
  */
 SensorWithConfig::SensorWithConfig() : SimpleSensor("sensorwc") {
   setDisplayName("Sensor With Config");
+  setMessage("Hello from Sensor with Config");
   Sensor::setConfiguration()->setHttpHandler([this](WebContext* svr){this->setConfiguration(svr);});
   Sensor::setConfiguration()->setFormHandler([this](WebContext* svr){this->configForm(svr);});
-  Sensor::getConfiguration()->setHttpHandler([this](WebContext* svr){this->getConfiguration(svr);});
 }
 
 SensorWithConfig::SensorWithConfig(const char* target) : SimpleSensor(target) {
   setDisplayName("Sensor With Config");
+  setMessage("Hello from Sensor with Config");
   Sensor::setConfiguration()->setHttpHandler([this](WebContext* svr){this->setConfiguration(svr);});
   Sensor::setConfiguration()->setFormHandler([this](WebContext* svr){this->configForm(svr);});
-  Sensor::getConfiguration()->setHttpHandler([this](WebContext* svr){this->getConfiguration(svr);});
 }
 
 /**
@@ -89,40 +84,25 @@ SensorWithConfig::SensorWithConfig(const char* target) : SimpleSensor(target) {
  *  These are set on the config form.
  */
 void SensorWithConfig::setConfiguration(WebContext* svr) {
-  int numArgs = svr->argCount();
-  for( int i=0; i<numArgs; i++) {
-     const String& argName = svr->argName(i);
-     const String& arg = svr->arg(i);
-     if( argName.equalsIgnoreCase("MSG") ) setMessage(arg.c_str());
-     else if( argName.equalsIgnoreCase("DISPLAYNAME") ) {if( arg.length() > 0 ) setDisplayName(arg.c_str());}
-  }
+  SensorArgs args;
+  uint32_t   bound = Parameter::bind(svr,SensorWithConfig_params,&args);
+  if( Parameter::isBound(bound,0) ) setDisplayName(args.displayName);
+  if( Parameter::isBound(bound,1) ) setMessage(args.msg);
   display(svr);
 }
 
-void SensorWithConfig::getConfiguration(WebContext* svr) {
-  char buffer[1000];
-  int size = sizeof(buffer);
-  snprintf_P(buffer,size,SensorWithConfig_config_template,getDisplayName(),getMessage());
-  svr->send(200, "text/xml", buffer);    
-}
-
 void SensorWithConfig::configForm(WebContext* svr) {
+  ResponseStream out(svr);
+  out.begin(200,"text/html");
+  out.formatHeader("Set Sensor Configuration");
+
 /**
- *    Config Form HTML Start with Title
+ *  Display name and message are escaped into the form placeholders; Cancel returns to the Sensor display
  */
-  char buffer[1500];
-  int size = sizeof(buffer);
-  int pos = formatHeader(buffer,size,"Set Sensor Configuration");
-
   char svcPath[100];
   Sensor::setConfiguration()->getPath(svcPath,100);     // Form submit path (service path)
-  pos = formatBuffer_P(buffer,size,pos,SensorWithConfig_config_form,svcPath,getDisplayName(),getMessage());
-
-/**
- *  Config Form HTML Tail
- */
-  formatTail(buffer,size,pos);
-  svr->send(200,"text/html",buffer); 
+  SensorWithConfigForm::render(out,svcPath,getDisplayName(),getMessage(),path());
+  out.formatTail();
 }
 
 void SensorWithConfig::setup(WebContext* svr) {
@@ -130,6 +110,17 @@ void SensorWithConfig::setup(WebContext* svr) {
  *   Make sure Sendor::setup() is called prior to any other required setup.
  */
   Sensor::setup(svr);
-  setMessage("Hello from Sensor with Config");
+}
+
+/**
+ *   The message is kept across restarts by the RootDevice ConfigStore, along with display name, target and UUID, and is
+ *   reported by the default getConfiguration handler, as XML or JSON, after the display name. It is put with its Parameter,
+ *   so a batch configuration value for it is checked as the setConfiguration handler checks it
+ */
+void SensorWithConfig::saveSettings(ConfigWriter& w) {w.put(SensorWithConfig_params[1],getMessage());}
+
+void SensorWithConfig::restoreSettings(const ConfigReader& r) {
+  const char* msg = r.get("msg");
+  if( msg != NULL ) setMessage(msg);
 }
 
@@ -50,8 +50,9 @@ class SensorWithConfig : public SimpleSensor {
  *    Methods to customize configuration
  */
       void           configForm(WebContext* svr);
-      void           getConfiguration(WebContext* svr);
       void           setConfiguration(WebContext* svr);
+      void           saveSettings(ConfigWriter& w);
+      void           restoreSettings(const ConfigReader& r);
 
 
 /**
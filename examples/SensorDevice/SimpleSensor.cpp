@@ -22,7 +22,10 @@
 
 #include "SimpleSensor.h"
 
-const char  sensor_msg[]  PROGMEM = "<p align=\"center\">Sensor Message is:  %s </p>";
+/**
+ *   The message is user supplied, so it is escaped into its slot
+ */
+PAGE_TEMPLATE(SensorMessage, "<p align=\"center\">Sensor Message is:  %s </p>");
 
 /** Leelanau Software Company namespace 
 *  
@@ -41,20 +44,33 @@ INITIALIZE_UPnP_TYPE(SimpleSensor,urn:LeelanauSoftware-com:device:SimpleSensor:1
  *      http://ip-address:port/rootTarget/sensor 
  *   where rootTarget is set on the RootDevice.
  */
-SimpleSensor::SimpleSensor() : Sensor("sensor") {setDisplayName("Simple Sensor");}
+/**
+ *   The message only changes through setMessage(), which marks the Sensor dirty, so content is rendered once per change
+ */
+SimpleSensor::SimpleSensor() : Sensor("sensor") {setDisplayName("Simple Sensor"); setRenderCache(true); setMessage("Hello from Simple Sensor");}
 
-SimpleSensor::SimpleSensor(const char* target) : Sensor(target) {setDisplayName("Simple Sensor");}
+SimpleSensor::SimpleSensor(const char* target) : Sensor(target) {setDisplayName("Simple Sensor"); setRenderCache(true); setMessage("Hello from Simple Sensor");}
+
+void SimpleSensor::content(ResponseStream& out) {SensorMessage::render(out,getMessage());}
 
 void SimpleSensor::content(char buffer[], int bufferSize) {
-/**
- *   Fill buffer with HTML
- */
-  snprintf_P(buffer,bufferSize,sensor_msg,getMessage());
+  if( bufferSize <= 0 ) return;
+  int     pos  = 0;
+  boolean fits = true;
+  {
+    ResponseStream out([&](const char* data, size_t len) {
+      if( fits && (pos + (int)len < bufferSize) ) {memcpy(buffer+pos,data,len); pos += len;}
+      else fits = false;
+    });
+    content(out);
+  }
+  buffer[((fits)?(pos):(0))] = '\0';
 }
 
 void SimpleSensor::setMessage(const char* m) {
   if( m != NULL ) {
       snprintf(_msg,BUFF_SIZE,"%s",m);
+      markDirty();
   }
 }
 
@@ -63,7 +79,6 @@ void SimpleSensor::setup(WebContext* svr) {
  *   Make sure Sendor::setup() is called prior to any other required setup.
  */
   Sensor::setup(svr);
-  setMessage("Hello from Simple Sensor");
 }
 
 
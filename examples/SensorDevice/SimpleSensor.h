@@ -49,9 +49,11 @@ class SimpleSensor : public Sensor {
       void           setup(WebContext* svr);
 
 /**
- *   Virtual Functions required by Sensor
+ *   Virtual Functions required by Sensor. The message is streamed, escaped, by content(ResponseStream&); the buffer 
+ *   form renders the same HTML, and leaves buffer empty rather than cutting it off if it does not fit.
  */
       void           content(char buffer[], int bufferSize);
+      void           content(ResponseStream& out);
 
 /**
  *   Macros to define the following Runtime Type Info:
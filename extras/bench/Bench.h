@@ -0,0 +1,65 @@
+/**
+ *
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or any
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  The author can be contacted at dan@leelanausoftware.com
+ *
+ */
+
+/**
+ *  Minimal host benchmark harness. A case is a callable timed in batches until the configured run time has
+ *  elapsed; one result row is printed per case:
+ *     case  devices  ns/op  bytes  truncated
+ *  where bytes is the response size produced by a single run (as captured by the host WebContext) and truncated
+ *  is the number of bytes dropped by snprintf_P/formatBuffer_P in a single run.
+ */
+
+#ifndef UPNP_BENCH_H
+#define UPNP_BENCH_H
+
+#include <Arduino.h>
+#include <WebContext.h>
+#include <chrono>
+
+namespace bench {
+
+typedef std::function<void(void)>   BenchFunction;
+typedef std::function<size_t(void)> RawBenchFunction;        // Returns the number of bytes produced
+
+/**
+ *  Run time per case in milliseconds, set from the command line (--quick shortens it for CI)
+ */
+extern long runMillis;
+
+void header(const char* suite);
+void run(const char* name, int devices, lsc::WebContext* ctx, BenchFunction fn);
+void runRaw(const char* name, int devices, RawBenchFunction fn);
+
+/**
+ *  Suites
+ */
+void renderBenchmarks();
+void rttiBenchmarks();
+void lookupBenchmarks();
+void schedulerBenchmarks();
+void parameterBenchmarks();
+void templateBenchmarks();
+void layoutBenchmarks();
+
+}
+
+#endif
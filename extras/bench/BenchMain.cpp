@@ -0,0 +1,94 @@
+/**
+ *
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or any
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  The author can be contacted at dan@leelanausoftware.com
+ *
+ */
+
+/**
+ *  upnp_bench [--quick] [--ms N]
+ *     --quick  := 20ms per case, for smoke runs in CI
+ *     --ms N   := N ms per case (default 200)
+ */
+
+#include "Bench.h"
+
+namespace bench {
+
+long runMillis = 200;
+
+void header(const char* suite) {
+  Serial.printf("\n%s\n",suite);
+  Serial.printf("%-44s %7s %12s %8s %10s\n","case","devices","ns/op","bytes","truncated");
+}
+
+static void report(const char* name, int devices, double ns, size_t bytes, size_t truncated) {
+  Serial.printf("%-44s %7d %12.1f %8zu %10zu\n",name,devices,ns,bytes,truncated);
+}
+
+/**
+ *  Time fn in doubling batches until runMillis has elapsed
+ */
+static double timeIt(BenchFunction fn) {
+  typedef std::chrono::steady_clock clock;
+  long          batch   = 1;
+  long          total   = 0;
+  double        elapsed = 0;
+  while( elapsed < runMillis * 1e6 ) {
+    clock::time_point start = clock::now();
+    for( long i=0; i<batch; i++ ) fn();
+    elapsed += std::chrono::duration<double,std::nano>(clock::now()-start).count();
+    total   += batch;
+    if( batch < (1L<<20) ) batch *= 2;
+  }
+  return elapsed/total;
+}
+
+void run(const char* name, int devices, lsc::WebContext* ctx, BenchFunction fn) {
+  ctx->clearResponse();
+  hostResetTruncation();
+  fn();
+  size_t bytes     = ctx->responseBody().length();
+  size_t truncated = hostTruncatedBytes();
+  double ns = timeIt([ctx,fn](){ctx->clearResponse(); fn();});
+  report(name,devices,ns,bytes,truncated);
+}
+
+void runRaw(const char* name, int devices, RawBenchFunction fn) {
+  hostResetTruncation();
+  size_t bytes     = fn();
+  size_t truncated = hostTruncatedBytes();
+  report(name,devices,timeIt([fn](){fn();}),bytes,truncated);
+}
+
+}
+
+int main(int argc, char** argv) {
+  for( int i=1; i<argc; i++ ) {
+    if( strcmp(argv[i],"--quick") == 0 ) bench::runMillis = 20;
+    else if( (strcmp(argv[i],"--ms") == 0) && (i+1 < argc) ) bench::runMillis = atol(argv[++i]);
+  }
+  bench::renderBenchmarks();
+  bench::rttiBenchmarks();
+  bench::lookupBenchmarks();
+  bench::schedulerBenchmarks();
+  bench::parameterBenchmarks();
+  bench::templateBenchmarks();
+  bench::layoutBenchmarks();
+  return 0;
+}
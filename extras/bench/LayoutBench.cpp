@@ -0,0 +1,92 @@
+/**
+ *
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or any
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  The author can be contacted at dan@leelanausoftware.com
+ *
+ */
+
+/**
+ *  Object layout benchmarks: building and renaming a hierarchy whose targets and display names are interned in the
+ *  StringTable. bytes reports the heap held by the table once the hierarchy is built, for all of its devices and 
+ *  their embedded configuration services.
+ */
+
+#include "Bench.h"
+#include "SimpleSensor.h"
+#include "SensorWithConfig.h"
+#include "CustomControl.h"
+#include "CustomDevice.h"
+
+using namespace lsc;
+
+namespace bench {
+
+static const int numDevices = 32;
+
+/**
+ *  Builds a RootDevice of numDevices devices, cycling through the example devices, and returns the bytes held by
+ *  the StringTable before it is torn down
+ */
+static size_t build() {
+  size_t bytes = 0;
+  {
+    RootDevice root;
+    char       target[TARGET_SIZE];
+    for( int i=0; i<numDevices; i++ ) {
+      snprintf(target,sizeof(target),"device%d",i);
+      switch( i%4 ) {
+        case 0:  root.addDevice(new SimpleSensor(target));     break;
+        case 1:  root.addDevice(new CustomControl(target));    break;
+        case 2:  root.addDevice(new SensorWithConfig(target)); break;
+        default: root.addDevice(new CustomDevice(target));
+      }
+    }
+    bytes = StringTable::bytes();
+    for( int i=0; i<numDevices; i++ ) delete root.device(i);
+  }
+  return bytes;
+}
+
+void layoutBenchmarks() {
+  header("Layout");
+
+  runRaw("build and tear down hierarchy",numDevices,[](){return build();});
+
+/**
+ *  Renaming to a name another device holds takes a reference; a new name is added to the table and the old one freed
+ */
+  static RootDevice root;
+  static char       names[2][NAME_SIZE] = {"Shared Name","Another Name"};
+  for( int i=0; i<numDevices; i++ ) root.addDevice(new SimpleSensor());
+  root.device(1)->setDisplayName(names[0]);
+  root.device(2)->setDisplayName(names[1]);
+  runRaw("setDisplayName (held name)",numDevices,[](){
+    static int k = 0;
+    root.device(0)->setDisplayName(names[(k++)&1]);
+    return StringTable::bytes();
+  });
+  runRaw("setDisplayName (new name)",numDevices,[](){
+    static int  k = 0;
+    char        name[NAME_SIZE];
+    snprintf(name,sizeof(name),"Sensor %d",(k++)&1023);
+    root.device(0)->setDisplayName(name);
+    return StringTable::bytes();
+  });
+}
+
+}
@@ -0,0 +1,86 @@
+/**
+ *
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or any
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  The author can be contacted at dan@leelanausoftware.com
+ *
+ */
+
+/**
+ *  Discovery lookup benchmarks: UUID and UPnP type lookups through the RootDevice index, compared with a scan of the
+ *  hierarchy that string compares every device and service, as SSDP search handling did. bytes reports the number
+ *  of matches.
+ */
+
+#include "Bench.h"
+#include "SimpleSensor.h"
+#include "SensorWithConfig.h"
+#include "CustomControl.h"
+#include "CustomDevice.h"
+
+using namespace lsc;
+
+namespace bench {
+
+static const int numDevices = 32;
+
+/**
+ *  Scan of the hierarchy, counting the devices and services whose UUID or type is key
+ */
+static size_t scan(RootDevice* root, const char* key) {
+  size_t  count  = 0;
+  UUID    id;
+  boolean isUUID = id.parse(key);
+  for( int i=-1; i<root->numDevices(); i++ ) {
+    UPnPDevice* d = ((i<0)?(root):(root->device(i)));
+    if( (isUUID && d->isDevice(id)) || d->isType(key) ) count++;
+    for( int j=0; j<d->numServices(); j++ ) {if( d->service(j)->isType(key) ) count++;}
+  }
+  return count;
+}
+
+void lookupBenchmarks() {
+  header("Lookup");
+  static RootDevice root;
+  char target[TARGET_SIZE];
+  for( int i=0; i<numDevices; i++ ) {
+    snprintf(target,sizeof(target),"device%d",i);
+    switch( i%4 ) {
+      case 0:  root.addDevice(new SimpleSensor(target));     break;
+      case 1:  root.addDevice(new CustomControl(target));    break;
+      case 2:  root.addDevice(new SensorWithConfig(target)); break;
+      default: {
+        CustomDevice* d = new CustomDevice(target);
+        d->addService(new CustomService("customService"));
+        root.addDevice(d);
+      }
+    }
+  }
+  static char uuid[UUID_SIZE];
+  strlcpy(uuid,root.device(numDevices-1)->uuid(),sizeof(uuid));
+
+  runRaw("getDevice(uuid) last device (scan)",numDevices,[](){return scan(&root,uuid);});
+  runRaw("getDevice(uuid) last device",numDevices,[](){return (size_t)((root.getDevice(uuid) != NULL)?(1):(0));});
+  runRaw("device type, all matches (scan)",numDevices,[](){return scan(&root,SimpleSensor::upnpType());});
+  runRaw("device type, all matches",numDevices,[](){return (size_t)root.forEachObject(SimpleSensor::upnpType(),[](UPnPObject*){});});
+  runRaw("service type, all matches (scan)",numDevices,[](){return scan(&root,GetConfiguration::upnpType());});
+  runRaw("service type, all matches",numDevices,[](){return (size_t)root.forEachObject(GetConfiguration::upnpType(),[](UPnPObject*){});});
+  runRaw("unknown type (scan)",numDevices,[](){return scan(&root,"urn:schemas-upnp-org:device:Unknown:1");});
+  runRaw("unknown type",numDevices,[](){return (size_t)root.forEachObject("urn:schemas-upnp-org:device:Unknown:1",[](UPnPObject*){});});
+}
+
+}
@@ -0,0 +1,99 @@
+/**
+ *
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or any
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  The author can be contacted at dan@leelanausoftware.com
+ *
+ */
+
+/**
+ *  Parameter binding benchmarks: decoding the arguments of a configuration request, as SensorWithConfig::setConfiguration()
+ *  and CustomControl::setState() do, with the original loop over argName()/arg() that tests every known name with 
+ *  String::equalsIgnoreCase(), and with Parameter::bind(). The arguments are parsed once by a request no handler takes, 
+ *  so only decoding is measured. bytes reports the number of arguments bound.
+ */
+
+#include "Bench.h"
+#include "UPnPDevice.h"
+
+using namespace lsc;
+
+namespace bench {
+
+struct BenchArgs {
+  char     displayName[NAME_SIZE];
+  char     msg[100];
+  int32_t  level;
+  int      state;
+  boolean  async;
+};
+
+static const char* const states[] = {"OFF","ON"};
+static const Parameter   params[] = {Parameter::text("displayName",offsetof(BenchArgs,displayName),NAME_SIZE,1),
+                                     Parameter::text("msg",offsetof(BenchArgs,msg),100),
+                                     Parameter::integer("level",offsetof(BenchArgs,level),0,100),
+                                     Parameter::choice("STATE",offsetof(BenchArgs,state),states,2),
+                                     Parameter::flag("async",offsetof(BenchArgs,async))};
+
+/**
+ *  The original decoding: every argument is compared with every known name
+ */
+static size_t legacy(WebContext* svr, BenchArgs& args) {
+  size_t bound = 0;
+  int numArgs = svr->argCount();
+  for( int i=0; i<numArgs; i++ ) {
+    const String& argName = svr->argName(i);
+    const String& arg = svr->arg(i);
+    if( argName.equalsIgnoreCase("DISPLAYNAME") ) {if( arg.length() > 0 ) {strlcpy(args.displayName,arg.c_str(),sizeof(args.displayName)); bound++;}}
+    else if( argName.equalsIgnoreCase("MSG") ) {strlcpy(args.msg,arg.c_str(),sizeof(args.msg)); bound++;}
+    else if( argName.equalsIgnoreCase("LEVEL") ) {
+      long v = arg.toInt();
+      if( (v >= 0) && (v <= 100) ) {args.level = v; bound++;}
+    }
+    else if( argName.equalsIgnoreCase("STATE") ) {
+      if( arg.equalsIgnoreCase("ON") )       {args.state = 1; bound++;}
+      else if( arg.equalsIgnoreCase("OFF") ) {args.state = 0; bound++;}
+    }
+    else if( argName.equalsIgnoreCase("ASYNC") ) {args.async = true; bound++;}
+  }
+  return bound;
+}
+
+static size_t bound(uint32_t mask) {
+  size_t count = 0;
+  for( ; mask != 0; mask &= mask-1 ) count++;
+  return count;
+}
+
+void parameterBenchmarks() {
+  header("Parameters");
+  static WebContext ctx;
+  static BenchArgs  args;
+  ctx.setup(NULL,WiFi.localIP(),8080);
+
+  ctx.request("/bench?STATE=ON");
+  runRaw("setState STATE (equalsIgnoreCase)",1,[](){return legacy(&ctx,args);});
+  runRaw("setState STATE (bind)",1,[](){return bound(Parameter::bind(&ctx,params,&args));});
+  ctx.request("/bench?STATE=off&async=1");
+  runRaw("setState STATE, async (equalsIgnoreCase)",1,[](){return legacy(&ctx,args);});
+  runRaw("setState STATE, async (bind)",1,[](){return bound(Parameter::bind(&ctx,params,&args));});
+  ctx.request("/bench?displayName=Kitchen%20Light&msg=Hello%20from%20the%20kitchen&level=42&submit=1");
+  runRaw("setConfiguration 4 args (equalsIgnoreCase)",1,[](){return legacy(&ctx,args);});
+  runRaw("setConfiguration 4 args (bind)",1,[](){return bound(Parameter::bind(&ctx,params,&args));});
+}
+
+}
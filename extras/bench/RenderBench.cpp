@@ -0,0 +1,192 @@
+/**
+ *
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or any
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  The author can be contacted at dan@leelanausoftware.com
+ *
+ */
+
+/**
+ *  Rendering benchmarks: every display() path and configuration form handler, with RootDevice pages
+ *  measured over hierarchies of increasing size. Devices cycle through SimpleSensor, CustomControl,
+ *  SensorWithConfig and CustomDevice (with a CustomService), so root pages mix inline Sensor content,
+ *  Control iFrames and app buttons the way a real device tree does.
+ */
+
+#include "Bench.h"
+#include "SimpleSensor.h"
+#include "SensorWithConfig.h"
+#include "CustomControl.h"
+#include "CustomDevice.h"
+
+using namespace lsc;
+
+/**
+ *  RootDevice with formatContent() exposed
+ */
+class BenchRoot : public RootDevice {
+  public:
+    BenchRoot() : RootDevice("root") {}
+    void renderContent(char buffer[], int size) {formatContent(buffer,size);}
+};
+
+/**
+ *  A RootDevice with n devices set up on its own WebContext, optionally in router mode or with request metrics on
+ */
+struct Hierarchy {
+  WebContext        ctx;
+  BenchRoot         root;
+  SimpleSensor*     sensor  = NULL;
+  CustomControl*    control = NULL;
+  SensorWithConfig* swc     = NULL;
+  CustomDevice*     device  = NULL;
+
+  Hierarchy(int n, boolean longNames = false, boolean router = false, boolean metrics = false) {
+    char target[TARGET_SIZE];
+    char name[NAME_SIZE];
+    ctx.setup(NULL,IPAddress(192,168,1,10),80);
+    root.setDisplayName(((longNames)?("Benchmark Root With A Long Name"):("Benchmark Root")));
+    for( int i=0; i<n; i++ ) {
+      snprintf(target,sizeof(target),"device%d",i);
+      UPnPDevice* d = NULL;
+      switch( i%4 ) {
+        case 0:  d = new SimpleSensor(target);     if( sensor  == NULL ) sensor  = (SimpleSensor*)d;     break;
+        case 1:  d = new CustomControl(target);    if( control == NULL ) control = (CustomControl*)d;    break;
+        case 2:  d = new SensorWithConfig(target); if( swc     == NULL ) swc     = (SensorWithConfig*)d; break;
+        default: {
+          CustomDevice* cd = new CustomDevice(target);
+          cd->addService(new CustomService("customService"));
+          if( device == NULL ) device = cd;
+          d = cd;
+        }
+      }
+      snprintf(name,sizeof(name),((longNames)?("Device %d With A Very Long Name"):("Device Number %d")),i);
+      d->setDisplayName(name);
+      root.addDevice(d);
+    }
+    root.setRouterMode(router);
+    root.metrics()->setEnabled(metrics);
+    root.setup(&ctx);
+  }
+};
+
+namespace bench {
+
+void renderBenchmarks() {
+  static const int sizes[] = {1,2,4,8,16,32};
+  header("Rendering");
+
+/**
+ *  RootDevice pages over hierarchies of increasing size, then the largest hierarchy with display
+ *  names at the NAME_SIZE limit
+ */
+  for( unsigned k=0; k<=sizeof(sizes)/sizeof(sizes[0]); k++ ) {
+    boolean    longNames = (k == sizeof(sizes)/sizeof(sizes[0]));
+    int        n = ((longNames)?(sizes[k-1]):(sizes[k]));
+    Hierarchy* h = new Hierarchy(n,longNames);
+    BenchRoot* r = &h->root;
+    run(((longNames)?("RootDevice::displayRoot (long names)"):("RootDevice::displayRoot")),n,&h->ctx,[h,r](){r->displayRoot(&h->ctx);});
+    run(((longNames)?("RootDevice::display (long names)"):("RootDevice::display")),n,&h->ctx,[h,r](){r->display(&h->ctx);});
+    runRaw(((longNames)?("RootDevice::formatContent (long names)"):("RootDevice::formatContent")),n,[r](){
+      char buffer[DISPLAY_SIZE];
+      buffer[0] = '\0';
+      r->renderContent(buffer,sizeof(buffer));
+      return strlen(buffer);
+    });
+  }
+
+/**
+ *  Device pages and configuration handlers
+ */
+  Hierarchy* h = new Hierarchy(4);
+  WebContext* ctx = &h->ctx;
+  run("UPnPDevice::display",1,ctx,[h,ctx](){h->device->display(ctx);});
+  run("Sensor::display",1,ctx,[h,ctx](){h->sensor->display(ctx);});
+  run("Sensor::display (SensorWithConfig)",1,ctx,[h,ctx](){h->swc->display(ctx);});
+  run("Control::display",1,ctx,[h,ctx](){h->control->display(ctx);});
+  run("Control::displayControl",1,ctx,[h,ctx](){h->control->displayControl(ctx);});
+  h->sensor->setRenderCache(false);
+  h->control->setRenderCache(false);
+  run("Sensor::display (no render cache)",1,ctx,[h,ctx](){h->sensor->display(ctx);});
+  run("Control::displayControl (no render cache)",1,ctx,[h,ctx](){h->control->displayControl(ctx);});
+  h->sensor->setRenderCache(true);
+  h->control->setRenderCache(true);
+  run("SetConfiguration::defaultFormHandler",1,ctx,[h,ctx](){h->sensor->setConfiguration()->defaultFormHandler(ctx);});
+  run("GetConfiguration::defaultHandler",1,ctx,[h,ctx](){h->sensor->getConfiguration()->defaultHandler(ctx);});
+  run("SensorWithConfig::configForm",1,ctx,[h,ctx](){h->swc->configForm(ctx);});
+  run("GetConfiguration::defaultHandler (settings)",1,ctx,[h,ctx](){h->swc->getConfiguration()->defaultHandler(ctx);});
+  String json = String(h->swc->getConfiguration()->path()) + "?format=json";
+  run("request getConfiguration?format=json",1,ctx,[ctx,json](){ctx->request(json.c_str());});
+  run("RootDevice::styles",1,ctx,[h,ctx](){h->root.styles(ctx);});
+  run("request /styles.css (gzip)",1,ctx,[ctx](){
+    ctx->addRequestHeader("Accept-Encoding","gzip, deflate");
+    ctx->request("/styles.css");
+  });
+  ctx->request("/styles.css");
+  String etag = ctx->responseHeader("ETag");
+  run("request /styles.css (If-None-Match)",1,ctx,[ctx,etag](){
+    ctx->addRequestHeader("If-None-Match",etag.c_str());
+    ctx->request("/styles.css");
+  });
+  runRaw("UPnPService::location",1,[h](){
+    char buffer[128];
+    h->sensor->setConfiguration()->location(buffer,sizeof(buffer),IPAddress(192,168,1,10));
+    return strlen(buffer);
+  });
+
+/**
+ *  Full request dispatch through the WebContext route table, and through RootDevice::route() in router mode,
+ *  for the first devices and the last configurable device of the largest hierarchy
+ */
+  int n = sizes[sizeof(sizes)/sizeof(sizes[0])-1];
+  Hierarchy* table  = new Hierarchy(n);
+  Hierarchy* router = new Hierarchy(n,false,true);
+  char last[64];
+  snprintf(last,sizeof(last),"/root/device%d/setConfiguration/configForm",n-2);
+  run("request /root/device0",n,&table->ctx,[table](){table->ctx.request("/root/device0");});
+  run("request /root/device1/displayControl",n,&table->ctx,[table](){table->ctx.request("/root/device1/displayControl");});
+  run("request (last configurable) configForm",n,&table->ctx,[table,last](){table->ctx.request(last);});
+  run("route /root/device0",n,&router->ctx,[router](){router->ctx.request("/root/device0");});
+  run("route /root/device1/displayControl",n,&router->ctx,[router](){router->ctx.request("/root/device1/displayControl");});
+  run("route (last configurable) configForm",n,&router->ctx,[router,last](){router->ctx.request(last);});
+
+/**
+ *  The same requests with request metrics on, for their overhead
+ */
+  Hierarchy* tableMetrics  = new Hierarchy(n,false,false,true);
+  Hierarchy* routerMetrics = new Hierarchy(n,false,true,true);
+  run("request /root/device0 (metrics)",n,&tableMetrics->ctx,[tableMetrics](){tableMetrics->ctx.request("/root/device0");});
+  run("request /root/device1/displayControl (metrics)",n,&tableMetrics->ctx,[tableMetrics](){tableMetrics->ctx.request("/root/device1/displayControl");});
+  run("route /root/device0 (metrics)",n,&routerMetrics->ctx,[routerMetrics](){routerMetrics->ctx.request("/root/device0");});
+  run("request /root/metrics",n,&tableMetrics->ctx,[tableMetrics](){tableMetrics->ctx.request("/root/metrics");});
+
+/**
+ *  Description document: served from the cache, revalidated with a matching ETag (304, no body), and 
+ *  re-rendered after a display name change
+ */
+  run("request description.xml",n,&table->ctx,[table](){table->ctx.request("/root/description.xml");});
+  run("request description.xml (If-None-Match)",n,&table->ctx,[table](){
+    table->ctx.addRequestHeader("If-None-Match",table->root.descriptionETag());
+    table->ctx.request("/root/description.xml");
+  });
+  runRaw("RootDevice::getDescription (rebuild)",n,[table](){
+    table->root.setDisplayName("Benchmark Root");
+    return strlen(table->root.getDescription());
+  });
+}
+
+}
@@ -0,0 +1,184 @@
+/**
+ *
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or any
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  The author can be contacted at dan@leelanausoftware.com
+ *
+ */
+
+/**
+ *  RTTI benchmarks: the as() casts RootDevice::formatContent() makes for every device (Sensor, then Control), and
+ *  RootDevice::getDevice(ClassType). The current macros are compared with a copy of the original RTTI macros, where 
+ *  ClassType IDs were assigned by static constructors and isClassType() walked a virtual call up the class hierarchy,
+ *  over identical object hierarchies; the library devices themselves are then measured for reference.
+ */
+
+#include "Bench.h"
+#include "SimpleSensor.h"
+#include "SensorWithConfig.h"
+#include "CustomControl.h"
+#include "CustomDevice.h"
+
+using namespace lsc;
+
+namespace legacy {
+
+class ClassType {
+  public:
+    ClassType() {_typeID=++_numTypes;}
+    int         typeID() const                         {return _typeID;}
+    boolean     isClassType( const ClassType* t) const {return ((t!=NULL)?(this->typeID() == t->typeID()):(false));}
+  private:
+    static int   _numTypes;
+    int          _typeID;
+};
+
+int ClassType::_numTypes = 0;
+
+#define LEGACY_RTTI     private: static const ClassType  _classType;                                                           \
+                        public:  static const ClassType* classType()                 {return &_classType;}                     \
+                        public:  virtual void*           as(const ClassType* t)      {return((isClassType(t))?(this):(NULL));}
+
+#define LEGACY_DERIVED_TYPE_CHECK(BaseClass) public: virtual boolean isClassType( const ClassType* t) {return (_classType.isClassType(t) || BaseClass::isClassType(t));}
+#define LEGACY_BASE_TYPE_CHECK               public: virtual boolean isClassType( const ClassType* t) {return _classType.isClassType(t);}
+#define LEGACY_INITIALIZE_STATIC_TYPE(className)  const ClassType className::_classType = ClassType()
+
+/**
+ *  The library class hierarchy, with the original macros
+ */
+class Object        {public: virtual ~Object() {}  LEGACY_RTTI; LEGACY_BASE_TYPE_CHECK;};
+class Device        : public Object  {LEGACY_RTTI; LEGACY_DERIVED_TYPE_CHECK(Object);};
+class Sensor        : public Device  {LEGACY_RTTI; LEGACY_DERIVED_TYPE_CHECK(Device);};
+class Control       : public Device  {LEGACY_RTTI; LEGACY_DERIVED_TYPE_CHECK(Device);};
+class Root          : public Device  {LEGACY_RTTI; LEGACY_DERIVED_TYPE_CHECK(Device);};
+class SimpleSensor  : public Sensor  {LEGACY_RTTI; LEGACY_DERIVED_TYPE_CHECK(Sensor);};
+class SensorConfig  : public Sensor  {LEGACY_RTTI; LEGACY_DERIVED_TYPE_CHECK(Sensor);};
+class CustomControl : public Control {LEGACY_RTTI; LEGACY_DERIVED_TYPE_CHECK(Control);};
+class CustomDevice  : public Device  {LEGACY_RTTI; LEGACY_DERIVED_TYPE_CHECK(Device);};
+
+LEGACY_INITIALIZE_STATIC_TYPE(Object);
+LEGACY_INITIALIZE_STATIC_TYPE(Device);
+LEGACY_INITIALIZE_STATIC_TYPE(Sensor);
+LEGACY_INITIALIZE_STATIC_TYPE(Control);
+LEGACY_INITIALIZE_STATIC_TYPE(Root);
+LEGACY_INITIALIZE_STATIC_TYPE(SimpleSensor);
+LEGACY_INITIALIZE_STATIC_TYPE(SensorConfig);
+LEGACY_INITIALIZE_STATIC_TYPE(CustomControl);
+LEGACY_INITIALIZE_STATIC_TYPE(CustomDevice);
+
+}
+
+/**
+ *  The same hierarchy with the current macros, so both are measured over identical objects
+ */
+namespace current {
+
+class Object        {public: virtual ~Object() {}  DEFINE_RTTI; BASE_TYPE_CHECK;};
+class Device        : public Object  {DEFINE_RTTI; DERIVED_TYPE_CHECK(Object);};
+class Sensor        : public Device  {DEFINE_RTTI; DERIVED_TYPE_CHECK(Device);};
+class Control       : public Device  {DEFINE_RTTI; DERIVED_TYPE_CHECK(Device);};
+class Root          : public Device  {DEFINE_RTTI; DERIVED_TYPE_CHECK(Device);};
+class SimpleSensor  : public Sensor  {DEFINE_RTTI; DERIVED_TYPE_CHECK(Sensor);};
+class SensorConfig  : public Sensor  {DEFINE_RTTI; DERIVED_TYPE_CHECK(Sensor);};
+class CustomControl : public Control {DEFINE_RTTI; DERIVED_TYPE_CHECK(Control);};
+class CustomDevice  : public Device  {DEFINE_RTTI; DERIVED_TYPE_CHECK(Device);};
+
+#define CURRENT_TYPE(className) INITIALIZE_STATIC_TYPE(className); INITIALIZE_UPnP_TYPE(className,urn:bench:device:className:1)
+CURRENT_TYPE(Object);
+CURRENT_TYPE(Device);
+CURRENT_TYPE(Sensor);
+CURRENT_TYPE(Control);
+CURRENT_TYPE(Root);
+CURRENT_TYPE(SimpleSensor);
+CURRENT_TYPE(SensorConfig);
+CURRENT_TYPE(CustomControl);
+CURRENT_TYPE(CustomDevice);
+
+}
+
+namespace bench {
+
+static const int numDevices = 32;
+
+void rttiBenchmarks() {
+  header("RTTI");
+
+/**
+ *  Library devices, cycling through SimpleSensor, CustomControl, SensorWithConfig and CustomDevice as
+ *  in the rendering benchmarks, and the same sequence of legacy objects
+ */
+  static RootDevice       root;
+  static legacy::Object*  objects[numDevices];
+  static current::Object* currentObjects[numDevices];
+  char target[TARGET_SIZE];
+  for( int i=0; i<numDevices; i++ ) {
+    snprintf(target,sizeof(target),"device%d",i);
+    switch( i%4 ) {
+      case 0:  root.addDevice(new SimpleSensor(target));     objects[i] = new legacy::SimpleSensor();  currentObjects[i] = new current::SimpleSensor();  break;
+      case 1:  root.addDevice(new CustomControl(target));    objects[i] = new legacy::CustomControl(); currentObjects[i] = new current::CustomControl(); break;
+      case 2:  root.addDevice(new SensorWithConfig(target)); objects[i] = new legacy::SensorConfig();  currentObjects[i] = new current::SensorConfig();  break;
+      default: root.addDevice(new CustomDevice(target));     objects[i] = new legacy::CustomDevice();  currentObjects[i] = new current::CustomDevice();
+    }
+  }
+
+/**
+ *  Sensor and Control casts per device, as in RootDevice::formatContent(); bytes reports the number of hits
+ */
+  runRaw("as() Sensor/Control per device (legacy)",numDevices,[](){
+    size_t hits = 0;
+    for( int i=0; i<numDevices; i++ ) {
+      if( objects[i]->as(legacy::Sensor::classType()) != NULL )       hits++;
+      else if( objects[i]->as(legacy::Control::classType()) != NULL ) hits++;
+    }
+    return hits;
+  });
+  runRaw("as() Sensor/Control per device (current)",numDevices,[](){
+    size_t hits = 0;
+    for( int i=0; i<numDevices; i++ ) {
+      if( currentObjects[i]->as(current::Sensor::classType()) != NULL )       hits++;
+      else if( currentObjects[i]->as(current::Control::classType()) != NULL ) hits++;
+    }
+    return hits;
+  });
+  runRaw("as() Sensor/Control, library devices",numDevices,[](){
+    size_t hits = 0;
+    for( int i=0; i<numDevices; i++ ) {
+      if( root.device(i)->as(Sensor::classType()) != NULL )       hits++;
+      else if( root.device(i)->as(Control::classType()) != NULL ) hits++;
+    }
+    return hits;
+  });
+
+/**
+ *  Search for a type no device matches, so every device is tested, as in RootDevice::getDevice(ClassType)
+ */
+  runRaw("getDevice(ClassType) no match (legacy)",numDevices,[](){
+    size_t hits = 0;
+    for( int i=0; i<numDevices; i++ ) {if( objects[i]->as(legacy::Root::classType()) != NULL ) hits++;}
+    return hits;
+  });
+  runRaw("getDevice(ClassType) no match (current)",numDevices,[](){
+    size_t hits = 0;
+    for( int i=0; i<numDevices; i++ ) {if( currentObjects[i]->as(current::Root::classType()) != NULL ) hits++;}
+    return hits;
+  });
+  runRaw("RootDevice::getDevice(ClassType) no match",numDevices,[](){
+    return (size_t)((root.getDevice(RootDevice::classType()) != NULL)?(1):(0));
+  });
+}
+
+}
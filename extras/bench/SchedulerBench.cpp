@@ -0,0 +1,68 @@
+/**
+ * 
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+/**
+ *  Scheduler benchmarks: the cost of RootDevice::doDevice() for devices run on every loop, as before devices had
+ *  schedules, compared with the same devices on periods, where a loop with nothing due only steps the timer wheel.
+ *  The GENA and Server-Sent event queues are empty, so neither adds to the loop. bytes is always 0.
+ */
+
+#include "Bench.h"
+#include "SimpleSensor.h"
+#include "SensorWithConfig.h"
+#include "CustomControl.h"
+#include "CustomDevice.h"
+
+using namespace lsc;
+
+namespace bench {
+
+static const int numDevices = 32;
+
+static void addDevices(RootDevice* root, uint32_t period) {
+  char target[TARGET_SIZE];
+  for( int i=0; i<numDevices; i++ ) {
+    UPnPDevice* d;
+    snprintf(target,sizeof(target),"device%d",i);
+    switch( i%4 ) {
+      case 0:  d = new SimpleSensor(target);     break;
+      case 1:  d = new CustomControl(target);    break;
+      case 2:  d = new SensorWithConfig(target); break;
+      default: d = new CustomDevice(target);
+    }
+    d->setSchedule(period);
+    root->addDevice(d);
+  }
+}
+
+void schedulerBenchmarks() {
+  header("Scheduler");
+  static RootDevice everyLoop;
+  static RootDevice periodic;
+  addDevices(&everyLoop,0);
+  addDevices(&periodic,1000);
+
+  runRaw("doDevice(), every device every loop",numDevices,[](){everyLoop.doDevice(); return (size_t)0;});
+  runRaw("doDevice(), 1s periods",numDevices,[](){periodic.doDevice(); return (size_t)0;});
+}
+
+}
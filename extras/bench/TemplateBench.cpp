@@ -0,0 +1,141 @@
+/**
+ *
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or any
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  The author can be contacted at dan@leelanausoftware.com
+ *
+ */
+
+/**
+ *  Template benchmarks: filling the page templates that carry display names and messages with snprintf_P into a
+ *  buffer, as the handlers did, with ResponseStream::printf_P, with ResponseStream::printHtml_P, which escapes its
+ *  values, and with the compile time split of a PageTemplate, which escapes them too. Escaping itself is measured with a copy of the original character at a time printEscaped() and the
+ *  current run at a time version. bytes reports the size of the output.
+ */
+
+#include "Bench.h"
+#include "UPnPDevice.h"
+
+using namespace lsc;
+
+namespace bench {
+
+/**
+ *  A copy of the configuration form template, as a PageTemplate and its text
+ */
+PAGE_TEMPLATE(BenchForm,                 "<form action=\"%s\"><div align=\"center\">"
+                                               "<label for=\"displayName\">Device Name &nbsp &nbsp</label>"
+                                               "<input type=\"text\" placeholder=\"%s\" name=\"displayName\"><br><br>"
+                                               "<button class=\"fmButton\" type=\"submit\">Submit</button>&nbsp&nbsp"
+                                               "<button class=\"fmButton\" type=\"button\" onclick=\"window.location.href=\'%s\';\">Cancel</button>"
+                                          "</div></form>");
+static const char* form_template = BenchForm_text;
+
+static const char* path       = "/root/device2/setConfiguration";
+static const char* parentPath = "/root/device2";
+static const char* plainName  = "Device Number 2 With A Long Name";
+static const char* markupName = "Tom's \"Lab\" <Sensors> & Relays";
+
+/**
+ *  The original printEscaped(), one write per character
+ */
+static void legacyEscaped(ResponseStream& out, const char* s) {
+  for( ; *s != '\0'; s++ ) {
+    switch( *s ) {
+      case '&':  out.write("&amp;",5);  break;
+      case '<':  out.write("&lt;",4);   break;
+      case '>':  out.write("&gt;",4);   break;
+      case '"':  out.write("&quot;",6); break;
+      case '\'': out.write("&#39;",5);  break;
+      default:   out.write(*s);
+    }
+  }
+}
+
+/**
+ *  Renders into a ResponseStream that only counts what it is sent
+ */
+static size_t stream(RenderFunction render) {
+  size_t bytes = 0;
+  {
+    ResponseStream out([&bytes](const char* data, size_t len){bytes += len;});
+    render(out);
+  }
+  return bytes;
+}
+
+void templateBenchmarks() {
+  header("Templates");
+
+  runRaw("snprintf_P app_button",1,[](){
+    char buffer[STREAM_BUFFER_SIZE];
+    return (size_t)snprintf_P(buffer,sizeof(buffer),app_button,parentPath,plainName);
+  });
+  runRaw("ResponseStream::printf_P app_button",1,[](){
+    return stream([](ResponseStream& out){out.printf_P(app_button,parentPath,plainName);});
+  });
+  runRaw("ResponseStream::printHtml_P app_button",1,[](){
+    return stream([](ResponseStream& out){out.printHtml_P(app_button,parentPath,plainName);});
+  });
+  runRaw("PageTemplate AppButton",1,[](){
+    return stream([](ResponseStream& out){AppButton::render(out,parentPath,plainName);});
+  });
+  runRaw("snprintf_P iframe_html",1,[](){
+    char buffer[STREAM_BUFFER_SIZE];
+    return (size_t)snprintf_P(buffer,sizeof(buffer),iframe_html,path,100,400);
+  });
+  runRaw("ResponseStream::printHtml_P iframe_html",1,[](){
+    return stream([](ResponseStream& out){out.printHtml_P(iframe_html,path,100,400);});
+  });
+  runRaw("PageTemplate IFrame",1,[](){
+    return stream([](ResponseStream& out){IFrame::render(out,path,100,400);});
+  });
+  runRaw("snprintf_P config form",1,[](){
+    char buffer[STREAM_BUFFER_SIZE];
+    return (size_t)snprintf_P(buffer,sizeof(buffer),form_template,path,plainName,parentPath);
+  });
+  runRaw("ResponseStream::printf_P config form",1,[](){
+    return stream([](ResponseStream& out){out.printf_P(form_template,path,plainName,parentPath);});
+  });
+  runRaw("ResponseStream::printHtml_P config form",1,[](){
+    return stream([](ResponseStream& out){out.printHtml_P(form_template,path,plainName,parentPath);});
+  });
+  runRaw("ResponseStream::printHtml_P form (markup)",1,[](){
+    return stream([](ResponseStream& out){out.printHtml_P(form_template,path,markupName,parentPath);});
+  });
+  runRaw("PageTemplate config form",1,[](){
+    return stream([](ResponseStream& out){BenchForm::render(out,path,plainName,parentPath);});
+  });
+  runRaw("PageTemplate config form (markup)",1,[](){
+    return stream([](ResponseStream& out){BenchForm::render(out,path,markupName,parentPath);});
+  });
+
+  runRaw("printEscaped plain name (legacy)",1,[](){
+    return stream([](ResponseStream& out){legacyEscaped(out,plainName);});
+  });
+  runRaw("printEscaped plain name",1,[](){
+    return stream([](ResponseStream& out){out.printEscaped(plainName);});
+  });
+  runRaw("printEscaped markup name (legacy)",1,[](){
+    return stream([](ResponseStream& out){legacyEscaped(out,markupName);});
+  });
+  runRaw("printEscaped markup name",1,[](){
+    return stream([](ResponseStream& out){out.printEscaped(markupName);});
+  });
+}
+
+}
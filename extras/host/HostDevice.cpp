@@ -0,0 +1,238 @@
+/**
+ *
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or any
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  The author can be contacted at dan@leelanausoftware.com
+ *
+ */
+
+/**
+ *  Host equivalent of the example sketches: builds a RootDevice with the example Sensors and Control,
+ *  registers handlers on the stand-in WebContext, and requests every registered URL (or the URLs given
+ *  on the command line), printing status, content type and size of each response.
+ *     upnp_host            := Request every registered handler
+ *     upnp_host -v url...  := Request the given urls and print response bodies
+ *     upnp_host -r ...     := As above, with the RootDevice in router mode
+ *     upnp_host -e port    := Subscribe to CustomControl events with callback http://127.0.0.1:port/, toggle the control
+ *                             and run the loop, so NOTIFY messages can be inspected with any local HTTP server on port
+ *     upnp_host -s         := Open the RootDevice event stream, toggle the control and rename a sensor, run the loop and
+ *                             print what the browser would receive
+ *     upnp_host -t ms      := Give the sensors periods, run the loop for ms and print scheduling statistics
+ *     upnp_host -m ...     := With request metrics on; /root/metrics is printed after the other requests
+ *     upnp_host -w ...     := As -m, with stack and heap watermarks; the watermark table is printed as well
+ *     upnp_host -c file ...:= Restore configuration from file before setup, and save it there after the requests, so that
+ *                             a setConfiguration request in one run is seen in the next
+ */
+
+#include "SimpleSensor.h"
+#include "SensorWithConfig.h"
+#include "CustomControl.h"
+
+using namespace lsc;
+
+WebContext       ctx;
+RootDevice       root;
+SimpleSensor     s;
+SensorWithConfig swc;
+CustomControl    c;
+
+void request(const char* url, boolean verbose) {
+  boolean handled = ctx.request(url);
+  String  stream  = ctx.clientOutput();
+  if( stream.length() > 0 ) {
+    Serial.printf("%-48s stream         %6u bytes\n",url,stream.length());
+    if( verbose ) Serial.printf("%s\n",stream.c_str());
+    return;
+  }
+  Serial.printf("%-48s %3d %-10s %6u bytes%s\n",url,ctx.responseCode(),ctx.responseType().c_str(),ctx.responseBody().length(),
+                ((handled)?(""):("  (not handled)")));
+  if( verbose ) Serial.printf("%s\n\n",ctx.responseBody().c_str());
+}
+
+void printResponse(const char* method, const char* url) {
+  Serial.printf("%-12s %-40s %3d SID: %s TIMEOUT: %s\n",method,url,ctx.responseCode(),ctx.responseHeader("SID").c_str(),
+                ctx.responseHeader("TIMEOUT").c_str());
+}
+
+/**
+ *  Replies to NOTIFY messages are read by later loop iterations, so the loop is run until they are in
+ */
+void deliver() {
+  unsigned long start = millis();
+  root.doDevice();
+  while( root.events()->pending() && (millis()-start < 2*NOTIFY_TIMEOUT) ) {
+    delay(1);
+    root.doDevice();
+  }
+}
+
+/**
+ *  Subscribe, make several changes between loop iterations (delivered as one NOTIFY), then unsubscribe
+ */
+void events(int port) {
+  const char* url = "/root/customControl/getConfiguration/event";
+  char callback[64];
+  snprintf(callback,sizeof(callback),"<http://127.0.0.1:%d/>",port);
+  ctx.addRequestHeader("NT","upnp:event");
+  ctx.addRequestHeader("CALLBACK",callback);
+  ctx.addRequestHeader("TIMEOUT","Second-300");
+  ctx.request(url,HTTP_SUBSCRIBE);
+  printResponse("SUBSCRIBE",url);
+  String sid = ctx.responseHeader("SID");
+  deliver();
+  Serial.printf("Initial event sent, %s pending\n",((root.events()->pending())?("still"):("none")));
+
+  ctx.request("/root/customControl/setState?STATE=ON");
+  ctx.request("/root/customControl/setConfiguration?displayName=Porch%20Light");
+  ctx.request("/root/customControl/setState?STATE=OFF");
+  ctx.request("/root/customControl/setState?STATE=ON");
+  deliver();
+  Serial.printf("4 changes sent, %s pending\n",((root.events()->pending())?("still"):("none")));
+
+  ctx.addRequestHeader("SID",sid.c_str());
+  ctx.addRequestHeader("TIMEOUT","Second-600");
+  ctx.request(url,HTTP_SUBSCRIBE);
+  printResponse("RENEW",url);
+  ctx.addRequestHeader("SID",sid.c_str());
+  ctx.request(url,HTTP_UNSUBSCRIBE);
+  printResponse("UNSUBSCRIBE",url);
+  Serial.printf("%d subscriptions\n",root.events()->numSubscriptions());
+}
+
+/**
+ *  Several changes between loop iterations are streamed as one event per changed device
+ */
+void stream() {
+  ctx.request("/root/events");
+  Serial.printf("%s",ctx.clientOutput().c_str());
+  ctx.request("/root/customControl/setState?STATE=ON&async=1");
+  Serial.printf("setState (async) %d\n",ctx.responseCode());
+  ctx.request("/root/customControl/setState?STATE=OFF&async=1");
+  ctx.request("/root/sensor/setConfiguration?displayName=Hall");
+  root.doDevice();
+  Serial.printf("%s",ctx.clientOutput().c_str());
+  root.doDevice();
+  Serial.printf("Unchanged loop: %u bytes\n",ctx.clientOutput().length());
+  ctx.closeClient();
+  ctx.request("/root/customControl/setState?STATE=ON&async=1");
+  root.doDevice();
+  Serial.printf("%d event streams after the browser left\n",root.eventStream()->numStreams());
+}
+
+/**
+ *  The sensors run on periods spread over two wheel levels, the control on every loop
+ */
+void schedule(unsigned long ms) {
+  s.setSchedule(100);
+  swc.setSchedule(1000,50);
+  unsigned long start = millis();
+  while( millis()-start < ms ) {
+    root.doDevice();
+    delay(1);
+  }
+  Scheduler* sch = root.scheduler();
+  Serial.printf("%-20s %6s %6s %6s %8s %8s %8s %8s\n","device","period","runs","missed","deferred","mean ms","max ms","max us");
+  for( int i=0; i<root.numDevices(); i++ ) {
+    UPnPDevice*          d  = root.device(i);
+    const ScheduleStats* st = sch->stats(d);
+    if( st == NULL ) continue;
+    Serial.printf("%-20s %6u %6u %6u %8u %8u %8u %8u\n",d->getDisplayName(),(unsigned int)d->period(),(unsigned int)st->runs,
+                  (unsigned int)st->missed,(unsigned int)st->deferred,(unsigned int)st->meanLateness(),(unsigned int)st->maxLateness,
+                  (unsigned int)st->maxRuntime);
+  }
+  Serial.printf("%u loops, %u overruns, longest loop %u us\n",(unsigned int)sch->loops(),(unsigned int)sch->overruns(),
+                (unsigned int)sch->maxLoopTime());
+}
+
+int main(int argc, char** argv) {
+  boolean verbose = false;
+  boolean router  = false;
+  boolean sse     = false;
+  long    runFor  = 0;
+  boolean metrics = false;
+  boolean marks   = false;
+  int     port    = 0;
+  const char* config = NULL;
+  int     first   = 1;
+  for( ; (first < argc) && (argv[first][0] == '-'); first++ ) {
+    if( strcmp(argv[first],"-v") == 0 )      verbose = true;
+    else if( strcmp(argv[first],"-r") == 0 ) router  = true;
+    else if( strcmp(argv[first],"-s") == 0 ) sse     = true;
+    else if( strcmp(argv[first],"-m") == 0 ) metrics = true;
+    else if( strcmp(argv[first],"-w") == 0 ) metrics = marks = true;
+    else if( (strcmp(argv[first],"-t") == 0) && (first+1 < argc) ) runFor = atol(argv[++first]);
+    else if( (strcmp(argv[first],"-e") == 0) && (first+1 < argc) ) port = atoi(argv[++first]);
+    else if( (strcmp(argv[first],"-c") == 0) && (first+1 < argc) ) config = argv[++first];
+  }
+
+  root.setDisplayName("Host Device");
+  root.setTarget("root");
+  root.addDevices(&s,&swc,&c);
+
+/**
+ *  The URLs to request are those registered on a Web server in the default mode. In router mode nothing
+ *  but the catch-all is registered, so collect them from a separate WebContext first.
+ */
+  if( (config != NULL) && root.configStore()->begin(&root,config) ) Serial.printf("Restored %u byte configuration from %s\n",(unsigned)root.configStore()->recordSize(),config);
+  root.metrics()->setEnabled(metrics);
+  root.metrics()->setWatermarks(marks);
+  WebContext probe;
+  probe.setup(NULL,WiFi.localIP(),8080);
+  root.setup(&probe);
+  ctx.setup(NULL,WiFi.localIP(),8080);
+  root.setRouterMode(router);
+  root.setup(&ctx);
+  RootDevice::printInfo(&root);
+  Serial.println();
+  if( port > 0 ) {
+    events(port);
+    return 0;
+  }
+  if( sse ) {
+    stream();
+    return 0;
+  }
+  if( runFor > 0 ) {
+    schedule(runFor);
+    return 0;
+  }
+
+  if( argc > first ) {
+    for( int i=first; i<argc; i++ ) request(argv[i],verbose);
+  }
+  else {
+    for( int i=0; i<probe.numHandlers(); i++ ) {
+      String url = probe.handlerURI(i);
+      request(url.c_str(),verbose);
+    }
+  }
+  if( metrics ) {
+    ctx.request("/root/metrics");
+    Serial.printf("\n%s",ctx.responseBody().c_str());
+  }
+  if( config != NULL ) {
+    ConfigStore* store = root.configStore();
+    if( !store->save(&root) )      Serial.printf("\nConfiguration not saved to %s\n",config);
+    else if( store->writes() > 0 ) Serial.printf("\nSaved %u byte configuration to %s\n",(unsigned)store->recordSize(),config);
+    else                           Serial.printf("\nConfiguration unchanged\n");
+  }
+  if( marks ) {
+    Serial.println();
+    Metrics::printInfo(root.metrics());
+  }
+  return 0;
+}
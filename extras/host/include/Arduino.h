@@ -0,0 +1,209 @@
+/**
+ *
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or any
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  The author can be contacted at dan@leelanausoftware.com
+ *
+ */
+
+/**
+ *  Host (Linux) stand-in for the parts of the Arduino core used by this library. Only what src/ and the
+ *  examples actually touch is provided: basic types, PROGMEM access, a std::string backed String, IPAddress,
+ *  Serial, and millis()/micros(). This file is NOT compiled by the Arduino IDE (everything under extras/ is ignored).
+ */
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <functional>
+#include <string>
+
+typedef bool     boolean;
+typedef uint8_t  byte;
+
+/**
+ *  PROGMEM is ordinary memory on the host
+ */
+#define PROGMEM
+#define PGM_P                         const char*
+#define PSTR(s)                       (s)
+#define FPSTR(p)                      ((const char*)(p))
+#define pgm_read_byte(addr)           (*(const uint8_t*)(addr))
+#define memcpy_P                      memcpy
+#define strlen_P                      strlen
+#define strcpy_P                      strcpy
+#define strncpy_P                     strncpy
+#define strcmp_P                      strcmp
+#define strncmp_P                     strncmp
+#define sprintf_P                     sprintf
+#define snprintf_P                    host_snprintf_P
+#define vsnprintf_P                   host_vsnprintf_P
+
+/**
+ *  Host instrumentation: snprintf_P/vsnprintf_P behave as snprintf/vsnprintf but tally the bytes dropped
+ *  when output does not fit the destination, so silent truncation of fixed size buffers can be measured.
+ *    hostTruncatedBytes()    := Bytes dropped since the last hostResetTruncation()
+ *    hostAddTruncation(n)    := Record n dropped bytes (for formatting functions that drop output themselves)
+ */
+int     host_vsnprintf_P(char* buffer, size_t size, PGM_P format, va_list args);
+int     host_snprintf_P(char* buffer, size_t size, PGM_P format, ...) __attribute__((format(printf,3,4)));
+size_t  hostTruncatedBytes();
+void    hostResetTruncation();
+void    hostAddTruncation(size_t n);
+
+/**
+ *  glibc only supplies strlcpy/strlcat from 2.38 on
+ */
+#if !defined(__GLIBC__) || !__GLIBC_PREREQ(2,38)
+inline size_t strlcpy(char* dst, const char* src, size_t size) {
+  size_t len = strlen(src);
+  if( size > 0 ) {
+    size_t n = ((len < size)?(len):(size-1));
+    memcpy(dst,src,n);
+    dst[n] = '\0';
+  }
+  return len;
+}
+
+inline size_t strlcat(char* dst, const char* src, size_t size) {
+  size_t len = strnlen(dst,size);
+  if( len == size ) return len + strlen(src);
+  return len + strlcpy(dst+len,src,size-len);
+}
+#endif
+
+/**
+ *  Arduino String, backed by std::string
+ */
+class String {
+  public:
+    String()                           {}
+    String(const char* s)              : _s((s!=NULL)?(s):("")) {}
+    String(const char* s, size_t len)  : _s(s,len) {}
+    String(const std::string& s)       : _s(s) {}
+    String(char c)                     : _s(1,c) {}
+    String(int n)                      : _s(std::to_string(n)) {}
+    String(unsigned int n)             : _s(std::to_string(n)) {}
+    String(long n)                     : _s(std::to_string(n)) {}
+    String(unsigned long n)            : _s(std::to_string(n)) {}
+
+    const char*   c_str()                           const {return _s.c_str();}
+    unsigned int  length()                          const {return (unsigned int)_s.length();}
+    bool          isEmpty()                         const {return _s.empty();}
+    void          reserve(unsigned int size)              {_s.reserve(size);}
+    char          charAt(unsigned int i)            const {return ((i<_s.length())?(_s[i]):('\0'));}
+    char          operator[](unsigned int i)        const {return charAt(i);}
+
+    bool          equals(const String& s)           const {return _s == s._s;}
+    bool          equals(const char* s)             const {return _s == ((s!=NULL)?(s):(""));}
+    bool          equalsIgnoreCase(const String& s) const {return (_s.length() == s._s.length()) && (strcasecmp(_s.c_str(),s.c_str()) == 0);}
+    bool          startsWith(const String& s)       const {return _s.compare(0,s._s.length(),s._s) == 0;}
+    bool          endsWith(const String& s)         const {return (_s.length() >= s._s.length()) && (_s.compare(_s.length()-s._s.length(),s._s.length(),s._s) == 0);}
+    int           indexOf(char c, unsigned int from = 0)            const {size_t i = _s.find(c,from); return ((i==std::string::npos)?(-1):((int)i));}
+    int           indexOf(const String& s, unsigned int from = 0)   const {size_t i = _s.find(s._s,from); return ((i==std::string::npos)?(-1):((int)i));}
+    String        substring(unsigned int from)                      const {return ((from<_s.length())?(String(_s.substr(from))):(String()));}
+    String        substring(unsigned int from, unsigned int to)     const {return ((from<to && from<_s.length())?(String(_s.substr(from,to-from))):(String()));}
+    long          toInt()                           const {return strtol(_s.c_str(),NULL,10);}
+    void          toLowerCase()                           {for(size_t i=0; i<_s.length(); i++) _s[i] = (char)tolower((unsigned char)_s[i]);}
+    void          toUpperCase()                           {for(size_t i=0; i<_s.length(); i++) _s[i] = (char)toupper((unsigned char)_s[i]);}
+
+    bool          concat(const String& s)                 {_s += s._s; return true;}
+    bool          concat(const char* s)                   {if( s != NULL ) _s += s; return true;}
+    bool          concat(const char* s, size_t len)       {_s.append(s,len); return true;}
+    bool          concat(char c)                          {_s += c; return true;}
+    String&       operator+=(const String& s)             {concat(s); return *this;}
+    String&       operator+=(const char* s)               {concat(s); return *this;}
+    String&       operator+=(char c)                      {concat(c); return *this;}
+
+    bool          operator==(const String& s)       const {return equals(s);}
+    bool          operator==(const char* s)         const {return equals(s);}
+    bool          operator!=(const String& s)       const {return !equals(s);}
+    bool          operator!=(const char* s)         const {return !equals(s);}
+
+    const std::string& str()                        const {return _s;}
+
+  private:
+    std::string   _s;
+};
+
+inline String operator+(const String& a, const String& b) {String r(a); r += b; return r;}
+inline String operator+(const String& a, const char* b)   {String r(a); r += b; return r;}
+inline String operator+(const char* a, const String& b)   {String r(a); r += b; return r;}
+
+/**
+ *  IPv4 address
+ */
+class IPAddress {
+  public:
+    IPAddress()                                        {_addr[0]=_addr[1]=_addr[2]=_addr[3]=0;}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {_addr[0]=a;_addr[1]=b;_addr[2]=c;_addr[3]=d;}
+    IPAddress(uint32_t addr)                           {memcpy(_addr,&addr,4);}
+
+    operator      uint32_t()                     const {uint32_t a; memcpy(&a,_addr,4); return a;}
+    uint8_t       operator[](int i)              const {return _addr[i];}
+    uint8_t&      operator[](int i)                    {return _addr[i];}
+    bool          operator==(const IPAddress& a) const {return memcmp(_addr,a._addr,4) == 0;}
+    bool          operator!=(const IPAddress& a) const {return !(*this == a);}
+    bool          isSet()                        const {return (uint32_t)(*this) != 0;}
+
+    String        toString()                     const {
+      char buffer[16];
+      snprintf(buffer,sizeof(buffer),"%u.%u.%u.%u",_addr[0],_addr[1],_addr[2],_addr[3]);
+      return String(buffer);
+    }
+
+  private:
+    uint8_t       _addr[4];
+};
+
+/**
+ *  Serial writes to stdout
+ */
+class HardwareSerial {
+  public:
+    void    begin(unsigned long)                 {}
+    operator bool()                        const {return true;}
+    size_t  printf(const char* format, ...)      __attribute__((format(printf,2,3)));
+    size_t  print(const char* s)                 {return fputs(s,stdout), strlen(s);}
+    size_t  print(const String& s)               {return print(s.c_str());}
+    size_t  print(long n)                        {return (size_t)::printf("%ld",n);}
+    size_t  println()                            {return print("\n");}
+    size_t  println(const char* s)               {return print(s) + println();}
+    size_t  println(const String& s)             {return println(s.c_str());}
+    size_t  println(long n)                      {return print(n) + println();}
+    void    flush()                              {fflush(stdout);}
+};
+
+extern HardwareSerial Serial;
+
+/**
+ *  Timing
+ */
+unsigned long millis();
+unsigned long micros();
+void          delay(unsigned long ms);
+void          yield();
+
+#endif
@@ -0,0 +1,68 @@
+/**
+ *
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or any
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  The author can be contacted at dan@leelanausoftware.com
+ *
+ */
+
+/**
+ *  Host stand-in for CommonUtil's CommonProgmem.h: the HTML fragments, stylesheet and buffer formatting
+ *  functions used by UPnPDevice. Fragments follow the CommonUtil layout and class names closely enough
+ *  that rendered pages are representative in size and shape.
+ */
+
+#ifndef HOST_COMMON_PROGMEM_H
+#define HOST_COMMON_PROGMEM_H
+
+#include <Arduino.h>
+
+/** Leelanau Software Company namespace
+*
+*/
+namespace lsc {
+
+typedef enum controlState {OFF=0, ON=1} ControlState;
+
+extern const char TEXT_HTML[]      PROGMEM;
+extern const char TEXT_CSS[]       PROGMEM;
+extern const char TEXT_XML[]       PROGMEM;
+extern const char TEXT_PLAIN[]     PROGMEM;
+
+extern const char html_header[]    PROGMEM;        // Document head with /styles.css link, opens body
+extern const char html_title[]     PROGMEM;        // Level 1 title; takes title
+extern const char html_L3_title[]  PROGMEM;        // Level 3 title; takes title
+extern const char html_tail[]      PROGMEM;        // Closes body and document
+extern const char app_button[]     PROGMEM;        // Takes href, label
+extern const char config_button[]  PROGMEM;        // Takes href, label
+extern const char iframe_html[]    PROGMEM;        // Takes src, height, width
+extern const char styles_css[]     PROGMEM;
+
+/**
+ *  Buffer formatting. Each returns the position of the terminating null in buffer; output that does not fit
+ *  is dropped and buffer is left null terminated.
+ *    formatHeader()    := html_header followed by html_title with title
+ *    formatBuffer_P()  := Appends the PROGMEM printf format at pos
+ *    formatTail()      := Appends html_tail at pos
+ */
+int  formatHeader(char buffer[], int size, const char* title);
+int  formatBuffer_P(char buffer[], int size, int pos, PGM_P format, ...);
+int  formatTail(char buffer[], int size, int pos);
+
+} // End of namespace lsc
+
+#endif
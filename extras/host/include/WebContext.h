@@ -0,0 +1,157 @@
+/**
+ *
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or any
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  The author can be contacted at dan@leelanausoftware.com
+ *
+ */
+
+/**
+ *  Host stand-in for the CommonUtil WebContext. The server facing half mirrors the subset of the ESP web server
+ *  API that WebContext passes through; the host half lets a test or benchmark issue requests in-process and
+ *  inspect exactly what a handler sent back.
+ */
+
+#ifndef HOST_WEBCONTEXT_H
+#define HOST_WEBCONTEXT_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiClient.h>
+#include <vector>
+
+#define CONTENT_LENGTH_UNKNOWN ((size_t) -1)
+
+/** Leelanau Software Company namespace
+*
+*/
+namespace lsc {
+
+class WebContext;
+typedef std::function<void(WebContext*)> HandlerFunction;
+
+enum HTTPMethod {HTTP_ANY, HTTP_GET, HTTP_HEAD, HTTP_POST, HTTP_PUT, HTTP_PATCH, HTTP_DELETE, HTTP_OPTIONS, HTTP_SUBSCRIBE, HTTP_UNSUBSCRIBE};
+
+class WebContext {
+  public:
+    WebContext() {}
+    ~WebContext();
+
+/**
+ *   Server facing API, as used by UPnPDevice. Handlers are matched on exact URI in registration order,
+ *   the same way the ESP web servers do it.
+ */
+    void           setup(void* server, IPAddress addr, int port)  {_localIP = addr; _localPort = port;}
+    void           on(const char* uri, HandlerFunction handler);
+    void           on(const char* uri, HTTPMethod method, HandlerFunction handler);
+    void           onNotFound(HandlerFunction handler)             {_notFound = handler;}
+
+    void           send(int code, const char* contentType, const String& content);
+    void           send_P(int code, PGM_P contentType, PGM_P content);
+    void           send_P(int code, PGM_P contentType, PGM_P content, size_t contentLength);
+    void           sendHeader(const String& name, const String& value, bool first = false);
+    void           setContentLength(size_t contentLength)          {_contentLength = contentLength;}
+    void           sendContent(const String& content)              {sendContent(content.c_str(),content.length());}
+    void           sendContent(const char* content, size_t size);
+    void           sendContent_P(PGM_P content)                    {sendContent(content,strlen_P(content));}
+    void           sendContent_P(PGM_P content, size_t size)       {sendContent(content,size);}
+
+    int            argCount()                                      {return (int)_argNames.size();}
+    const String&  argName(int i)                                  {return ((i>=0 && i<argCount())?(_argNames[i]):(_empty));}
+    const String&  arg(int i)                                      {return ((i>=0 && i<argCount())?(_args[i]):(_empty));}
+    const String&  arg(const char* name);
+    bool           hasArg(const char* name);
+
+    void           collectHeaders(const char* headerKeys[], size_t count);
+    const String&  header(const char* name);
+    bool           hasHeader(const char* name);
+
+    WiFiClient     client();
+    const String&  uri()                                           {return _uri;}
+    HTTPMethod     method()                                        {return _method;}
+    int            getLocalPort()                                  {return _localPort;}
+    IPAddress      getLocalIPAddress()                             {return _localIP;}
+
+/**
+ *   Host API: issue a request and capture the response.
+ *     request(url)        := Parses "/path?name=value&..." into uri and arguments, dispatches to the matching
+ *                            handler (or the not found handler) and returns false if nothing handled it.
+ *     clearResponse()     := Discards the captured response, for callers invoking handlers directly.
+ *     addRequestHeader()  := Adds a request header for the next request; cleared once the request completes.
+ *     responseXXX()       := Status, content type, collected response headers and body of the last request.
+ *                            A chunked response is reassembled into responseBody() and counted in responseChunks().
+ *     clientOutput()      := Bytes written so far to the client() of the last request that took it, for handlers that
+ *                            keep the connection and write to it directly. The client is one end of a socket pair.
+ *     closeClient()       := Closes the other end of that socket pair, as a browser leaving the page would.
+ */
+    bool           request(const char* url, HTTPMethod method = HTTP_GET);
+    void           clearResponse();
+    void           addRequestHeader(const char* name, const char* value);
+    int            responseCode()                                  {return _responseCode;}
+    const String&  responseType()                                  {return _responseType;}
+    const String&  responseBody()                                  {return _responseBody;}
+    const String&  responseHeader(const char* name);
+    bool           responseChunked()                               {return _chunked;}
+    int            responseChunks()                                {return _chunks;}
+    size_t         bytesSent()                                     {return _bytesSent;}
+    String         clientOutput();
+    void           closeClient();
+    int            numHandlers()                                   {return (int)_handlers.size();}
+    const char*    handlerURI(int i)                               {return ((i>=0 && i<numHandlers())?(_handlers[i].uri.c_str()):(NULL));}
+
+  private:
+    struct Handler {
+      String            uri;
+      HTTPMethod        method;
+      HandlerFunction   fn;
+    };
+    struct Header {
+      String            name;
+      String            value;
+    };
+
+    void           beginResponse(int code, const char* contentType);
+    void           parseQuery(const char* query);
+
+    std::vector<Handler>  _handlers;
+    HandlerFunction       _notFound;
+    std::vector<String>   _argNames;
+    std::vector<String>   _args;
+    std::vector<Header>   _requestHeaders;
+    std::vector<Header>   _pendingHeaders;
+    std::vector<Header>   _responseHeaders;
+    std::vector<String>   _collect;
+    String                _uri;
+    HTTPMethod            _method = HTTP_GET;
+    String                _empty;
+    IPAddress             _localIP;
+    int                   _localPort = 80;
+
+    int                   _responseCode = 0;
+    String                _responseType;
+    String                _responseBody;
+    size_t                _contentLength = 0;
+    size_t                _bytesSent = 0;
+    bool                  _chunked = false;
+    int                   _chunks = 0;
+    WiFiClient            _client;
+    int                   _clientPeer = -1;
+};
+
+} // End of namespace lsc
+
+#endif
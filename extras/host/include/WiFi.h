@@ -0,0 +1,44 @@
+/**
+ *
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or any
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  The author can be contacted at dan@leelanausoftware.com
+ *
+ */
+
+/**
+ *  Host stand-in for the ESP WiFi object. The local IP address is settable so that location
+ *  and interface dependent code can be exercised.
+ */
+
+#ifndef HOST_WIFI_H
+#define HOST_WIFI_H
+
+#include <Arduino.h>
+
+class WiFiClass {
+  public:
+    IPAddress  localIP()                    {return _localIP;}
+    void       setLocalIP(IPAddress addr)   {_localIP = addr;}
+
+  private:
+    IPAddress  _localIP = IPAddress(127,0,0,1);
+};
+
+extern WiFiClass WiFi;
+
+#endif
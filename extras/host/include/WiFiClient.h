@@ -0,0 +1,64 @@
+/**
+ * 
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+/**
+ *  Host stand-in for the ESP WiFiClient: a blocking TCP client over POSIX sockets, with the subset of the
+ *  Client/Stream API used by the library. Reads wait at most the Stream timeout (setTimeout(), default 1000ms).
+ *  As on the ESP, copies share the connection, which is closed by stop() or when the last copy is destroyed.
+ */
+
+#ifndef HOST_WIFI_CLIENT_H
+#define HOST_WIFI_CLIENT_H
+
+#include <Arduino.h>
+#include <memory>
+
+class WiFiClient {
+  public:
+    WiFiClient() {}
+    explicit WiFiClient(int fd);                      // Host only: takes ownership of a connected socket
+
+    int       connect(const char* host, uint16_t port);
+    int       connect(IPAddress ip, uint16_t port)    {return connect(ip.toString().c_str(),port);}
+    size_t    write(const uint8_t* buffer, size_t size);
+    size_t    write(const char* buffer, size_t size)  {return write((const uint8_t*)buffer,size);}
+    size_t    print(const char* s)                    {return write(s,strlen(s));}
+    int       available();
+    int       read();
+    int       read(uint8_t* buffer, size_t size);
+    String    readStringUntil(char terminator);
+    uint8_t   connected()                             {return fd() >= 0;}
+    void      setTimeout(unsigned long ms)            {_timeout = ms;}
+    void      stop();
+
+  private:
+    struct Socket {
+      int  fd = -1;
+      ~Socket();
+    };
+    int                      fd()                     {return ((_socket)?(_socket->fd):(-1));}
+
+    std::shared_ptr<Socket>  _socket;
+    unsigned long            _timeout = 1000;
+};
+
+#endif
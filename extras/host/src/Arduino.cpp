@@ -0,0 +1,71 @@
+/**
+ *
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or any
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  The author can be contacted at dan@leelanausoftware.com
+ *
+ */
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <chrono>
+#include <thread>
+
+HardwareSerial Serial;
+WiFiClass      WiFi;
+
+static size_t truncatedBytes = 0;
+
+static const std::chrono::steady_clock::time_point bootTime = std::chrono::steady_clock::now();
+
+size_t HardwareSerial::printf(const char* format, ...) {
+  va_list args;
+  va_start(args,format);
+  int result = vprintf(format,args);
+  va_end(args);
+  return ((result>0)?((size_t)result):(0));
+}
+
+int host_vsnprintf_P(char* buffer, size_t size, PGM_P format, va_list args) {
+  int result = vsnprintf(buffer,size,format,args);
+  if( (result > 0) && ((size_t)result >= size) ) truncatedBytes += (size_t)result - ((size>0)?(size-1):(0));
+  return result;
+}
+
+int host_snprintf_P(char* buffer, size_t size, PGM_P format, ...) {
+  va_list args;
+  va_start(args,format);
+  int result = host_vsnprintf_P(buffer,size,format,args);
+  va_end(args);
+  return result;
+}
+
+size_t hostTruncatedBytes()           {return truncatedBytes;}
+void   hostResetTruncation()          {truncatedBytes = 0;}
+void   hostAddTruncation(size_t n)    {truncatedBytes += n;}
+
+unsigned long millis() {
+  return (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now()-bootTime).count();
+}
+
+unsigned long micros() {
+  return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now()-bootTime).count();
+}
+
+void delay(unsigned long ms) {std::this_thread::sleep_for(std::chrono::milliseconds(ms));}
+
+void yield() {std::this_thread::yield();}
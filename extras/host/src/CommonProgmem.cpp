@@ -0,0 +1,115 @@
+/**
+ *
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or any
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  The author can be contacted at dan@leelanausoftware.com
+ *
+ */
+
+#include <CommonProgmem.h>
+
+/** Leelanau Software Company namespace
+*
+*/
+namespace lsc {
+
+const char TEXT_HTML[]      PROGMEM = "text/html";
+const char TEXT_CSS[]       PROGMEM = "text/css";
+const char TEXT_XML[]       PROGMEM = "text/xml";
+const char TEXT_PLAIN[]     PROGMEM = "text/plain";
+
+const char html_header[]    PROGMEM = "<!DOCTYPE html><html><head><meta charset=\"utf-8\">"
+                                        "<meta name=\"viewport\" content=\"width=device-width, initial-scale=1\">"
+                                        "<link rel=\"stylesheet\" href=\"/styles.css\"></head><body>";
+const char html_title[]     PROGMEM = "<br><h1 align=\"center\">%s</h1><br>";
+const char html_L3_title[]  PROGMEM = "<h3 align=\"center\">%s</h3>";
+const char html_tail[]      PROGMEM = "</body></html>";
+const char app_button[]     PROGMEM = "<div align=\"center\"><a href=\"%s\" class=\"appButton\">%s</a></div><br>";
+const char config_button[]  PROGMEM = "<br><div align=\"center\"><a href=\"%s\"><button class=\"cfgButton\">%s</button></a></div>";
+const char iframe_html[]    PROGMEM = "<div align=\"center\"><iframe src=\"%s\" height=\"%d\" width=\"%d\" frameborder=\"0\" scrolling=\"no\"></iframe></div>";
+
+const char styles_css[]     PROGMEM =
+  "html {font-family: Helvetica, Arial, sans-serif; display: inline-block; text-align: center;}\n"
+  "body {margin: 0; padding: 0; color: #202020; background-color: #f4f4f4;}\n"
+  "h1 {font-size: 1.8rem; color: #1b4f72; margin-top: 0.5em; margin-bottom: 0.25em;}\n"
+  "h2 {font-size: 1.5rem; color: #1b4f72; margin-top: 0.5em; margin-bottom: 0.25em;}\n"
+  "h3 {font-size: 1.2rem; color: #1b4f72; margin-top: 0.5em; margin-bottom: 0.25em;}\n"
+  "p {font-size: 1.0rem; line-height: 1.4em;}\n"
+  "a {color: #1b4f72;}\n"
+  "iframe {border: none; overflow: hidden; background-color: transparent;}\n"
+  ".appButton {display: inline-block; min-width: 220px; padding: 12px 24px; margin: 4px 2px; font-size: 1.1rem;\n"
+  "            font-weight: bold; text-decoration: none; text-align: center; color: #ffffff; background-color: #1b4f72;\n"
+  "            border: 2px solid #1b4f72; border-radius: 12px; box-shadow: 0 4px 8px 0 rgba(0,0,0,0.2);\n"
+  "            transition-duration: 0.3s; cursor: pointer;}\n"
+  ".appButton:hover {color: #1b4f72; background-color: #ffffff;}\n"
+  ".appButton:active {transform: translateY(2px); box-shadow: 0 2px 4px 0 rgba(0,0,0,0.2);}\n"
+  ".cfgButton {display: inline-block; padding: 6px 16px; margin: 4px 2px; font-size: 0.9rem; text-decoration: none;\n"
+  "            color: #1b4f72; background-color: #ffffff; border: 1px solid #1b4f72; border-radius: 8px; cursor: pointer;}\n"
+  ".cfgButton:hover {color: #ffffff; background-color: #1b4f72;}\n"
+  ".fmButton {display: inline-block; min-width: 90px; padding: 8px 16px; margin: 4px 2px; font-size: 1.0rem;\n"
+  "           color: #ffffff; background-color: #1b4f72; border: 1px solid #1b4f72; border-radius: 8px; cursor: pointer;}\n"
+  ".fmButton:hover {color: #1b4f72; background-color: #ffffff;}\n"
+  "form {display: inline-block; text-align: left; padding: 16px; background-color: #ffffff; border-radius: 12px;\n"
+  "      box-shadow: 0 4px 8px 0 rgba(0,0,0,0.15);}\n"
+  "label {display: inline-block; min-width: 140px; font-size: 1.0rem; font-weight: bold; color: #404040;}\n"
+  "input[type=text], input[type=number], input[type=password], select {width: 200px; padding: 6px 10px; margin: 4px 0;\n"
+  "      font-size: 1.0rem; border: 1px solid #a0a0a0; border-radius: 6px; box-sizing: border-box;}\n"
+  "input[type=text]:focus, input[type=number]:focus, input[type=password]:focus {border: 2px solid #1b4f72; outline: none;}\n"
+  ".toggle {position: relative; display: inline-block; width: 60px; height: 34px; vertical-align: middle; cursor: pointer;}\n"
+  ".toggle-checkbox {position: absolute; opacity: 0; width: 0; height: 0;}\n"
+  ".toggle-switch {position: absolute; top: 0; left: 0; right: 0; bottom: 0; background-color: #c0c0c0;\n"
+  "                border-radius: 34px; transition: 0.4s;}\n"
+  ".toggle-switch:before {position: absolute; content: \"\"; height: 26px; width: 26px; left: 4px; bottom: 4px;\n"
+  "                       background-color: #ffffff; border-radius: 50%; transition: 0.4s;}\n"
+  ".toggle-checkbox:checked + .toggle-switch {background-color: #1b4f72;}\n"
+  ".toggle-checkbox:checked + .toggle-switch:before {transform: translateX(26px);}\n"
+  ".reading {font-size: 2.4rem; font-weight: bold; color: #1b4f72;}\n"
+  ".units {font-size: 1.2rem; color: #606060;}\n"
+  ".status {font-size: 0.9rem; color: #606060;}\n"
+  ".error {font-size: 0.9rem; color: #a01010;}\n"
+  "table {margin-left: auto; margin-right: auto; border-collapse: collapse;}\n"
+  "th, td {padding: 6px 12px; text-align: left; border-bottom: 1px solid #d0d0d0;}\n"
+  "th {color: #ffffff; background-color: #1b4f72;}\n"
+  "tr:nth-child(even) {background-color: #eaeaea;}\n"
+  "@media (max-width: 480px) {.appButton {min-width: 160px; font-size: 1.0rem;} label {min-width: 100px;}}\n";
+
+int formatBuffer_P(char buffer[], int size, int pos, PGM_P format, ...) {
+  va_list args;
+  va_start(args,format);
+  if( (pos >= 0) && (pos < size) ) {
+    vsnprintf_P(buffer+pos,size-pos,format,args);
+    pos += strlen(buffer+pos);
+  }
+  else {
+    int dropped = vsnprintf(NULL,0,format,args);
+    if( dropped > 0 ) hostAddTruncation((size_t)dropped);
+  }
+  va_end(args);
+  return pos;
+}
+
+int formatHeader(char buffer[], int size, const char* title) {
+  int pos = 0;
+  if( size > 0 ) buffer[0] = '\0';
+  pos = formatBuffer_P(buffer,size,pos,html_header);
+  pos = formatBuffer_P(buffer,size,pos,html_title,title);
+  return pos;
+}
+
+int formatTail(char buffer[], int size, int pos) {return formatBuffer_P(buffer,size,pos,html_tail);}
+
+} // End of namespace lsc
@@ -0,0 +1,241 @@
+/**
+ *
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or any
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  The author can be contacted at dan@leelanausoftware.com
+ *
+ */
+
+#include <WebContext.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/** Leelanau Software Company namespace
+*
+*/
+namespace lsc {
+
+static int hexValue(char c) {
+  if( c >= '0' && c <= '9' ) return c - '0';
+  if( c >= 'a' && c <= 'f' ) return c - 'a' + 10;
+  if( c >= 'A' && c <= 'F' ) return c - 'A' + 10;
+  return -1;
+}
+
+/**
+ *  URL decode [s,s+len), '+' decodes to space
+ */
+static String urlDecode(const char* s, size_t len) {
+  String result;
+  result.reserve((unsigned int)len);
+  for( size_t i=0; i<len; i++ ) {
+    if( s[i] == '+' ) result += ' ';
+    else if( (s[i] == '%') && (i+2 < len) && (hexValue(s[i+1]) >= 0) && (hexValue(s[i+2]) >= 0) ) {
+      result += (char)((hexValue(s[i+1]) << 4) | hexValue(s[i+2]));
+      i += 2;
+    }
+    else result += s[i];
+  }
+  return result;
+}
+
+WebContext::~WebContext() {closeClient();}
+
+void WebContext::on(const char* uri, HandlerFunction handler) {on(uri,HTTP_ANY,handler);}
+
+void WebContext::on(const char* uri, HTTPMethod method, HandlerFunction handler) {
+  Handler h;
+  h.uri    = uri;
+  h.method = method;
+  h.fn     = handler;
+  _handlers.push_back(h);
+}
+
+void WebContext::beginResponse(int code, const char* contentType) {
+  _responseCode = code;
+  _responseType = contentType;
+  _responseHeaders.insert(_responseHeaders.end(),_pendingHeaders.begin(),_pendingHeaders.end());
+  _pendingHeaders.clear();
+}
+
+void WebContext::send(int code, const char* contentType, const String& content) {
+  beginResponse(code,contentType);
+  if( _contentLength == CONTENT_LENGTH_UNKNOWN ) _chunked = true;
+  else _responseBody = content;
+  if( !_chunked ) _bytesSent += content.length();
+}
+
+void WebContext::send_P(int code, PGM_P contentType, PGM_P content) {send_P(code,contentType,content,strlen_P(content));}
+
+void WebContext::send_P(int code, PGM_P contentType, PGM_P content, size_t contentLength) {
+  beginResponse(code,contentType);
+  _responseBody = String(content,contentLength);
+  _bytesSent += contentLength;
+}
+
+void WebContext::sendHeader(const String& name, const String& value, bool first) {
+  Header h;
+  h.name  = name;
+  h.value = value;
+  if( first ) _pendingHeaders.insert(_pendingHeaders.begin(),h);
+  else _pendingHeaders.push_back(h);
+}
+
+/**
+ *  For a chunked response an empty chunk terminates the response
+ */
+void WebContext::sendContent(const char* content, size_t size) {
+  if( _chunked && (size == 0) ) {_contentLength = 0; return;}
+  _responseBody.concat(content,size);
+  _bytesSent += size;
+  if( _chunked ) _chunks++;
+}
+
+const String& WebContext::arg(const char* name) {
+  for( size_t i=0; i<_argNames.size(); i++ ) {if( _argNames[i] == name ) return _args[i];}
+  return _empty;
+}
+
+bool WebContext::hasArg(const char* name) {
+  for( size_t i=0; i<_argNames.size(); i++ ) {if( _argNames[i] == name ) return true;}
+  return false;
+}
+
+/**
+ *  Like the ESP servers, only headers named in collectHeaders() are retained for a request
+ */
+void WebContext::collectHeaders(const char* headerKeys[], size_t count) {
+  _collect.clear();
+  for( size_t i=0; i<count; i++ ) _collect.push_back(String(headerKeys[i]));
+}
+
+const String& WebContext::header(const char* name) {
+  for( size_t i=0; i<_requestHeaders.size(); i++ ) {if( _requestHeaders[i].name.equalsIgnoreCase(name) ) return _requestHeaders[i].value;}
+  return _empty;
+}
+
+bool WebContext::hasHeader(const char* name) {
+  for( size_t i=0; i<_requestHeaders.size(); i++ ) {if( _requestHeaders[i].name.equalsIgnoreCase(name) ) return true;}
+  return false;
+}
+
+void WebContext::addRequestHeader(const char* name, const char* value) {
+  for( size_t i=0; i<_collect.size(); i++ ) {
+    if( _collect[i].equalsIgnoreCase(name) ) {
+      Header h;
+      h.name  = name;
+      h.value = value;
+      _requestHeaders.push_back(h);
+      return;
+    }
+  }
+}
+
+const String& WebContext::responseHeader(const char* name) {
+  for( size_t i=0; i<_responseHeaders.size(); i++ ) {if( _responseHeaders[i].name.equalsIgnoreCase(name) ) return _responseHeaders[i].value;}
+  return _empty;
+}
+
+void WebContext::parseQuery(const char* query) {
+  while( (query != NULL) && (*query != '\0') ) {
+    const char* amp = strchr(query,'&');
+    size_t      len = ((amp!=NULL)?((size_t)(amp-query)):(strlen(query)));
+    const char* eq  = (const char*)memchr(query,'=',len);
+    if( len > 0 ) {
+      if( eq != NULL ) {
+        _argNames.push_back(urlDecode(query,eq-query));
+        _args.push_back(urlDecode(eq+1,len-(eq-query)-1));
+      }
+      else {
+        _argNames.push_back(urlDecode(query,len));
+        _args.push_back(String());
+      }
+    }
+    query = ((amp!=NULL)?(amp+1):(NULL));
+  }
+}
+
+void WebContext::clearResponse() {
+  _responseHeaders.clear();
+  _pendingHeaders.clear();
+  _responseBody  = String();
+  _responseType  = String();
+  _responseCode  = 0;
+  _contentLength = 0;
+  _chunked       = false;
+  _chunks        = 0;
+}
+
+bool WebContext::request(const char* url, HTTPMethod method) {
+  _argNames.clear();
+  _args.clear();
+  clearResponse();
+  _method        = method;
+
+  const char* q = strchr(url,'?');
+  if( q != NULL ) {
+    _uri = String(url,q-url);
+    parseQuery(q+1);
+  }
+  else _uri = url;
+
+  bool handled = false;
+  for( size_t i=0; (i<_handlers.size()) && !handled; i++ ) {
+    Handler& h = _handlers[i];
+    if( ((h.method == HTTP_ANY) || (h.method == method)) && (h.uri == _uri) ) {
+      h.fn(this);
+      handled = true;
+    }
+  }
+  if( !handled && _notFound ) {
+    _notFound(this);
+    handled = (_responseCode != 0) || _client.connected();
+  }
+  _requestHeaders.clear();
+  _client = WiFiClient();                 // The server lets go of the connection; a handler may keep a copy
+  return handled;
+}
+
+/**
+ *  The connection for the current request, created on first use as one end of a socket pair
+ */
+WiFiClient WebContext::client() {
+  if( _client.connected() ) return _client;
+  int fds[2];
+  if( socketpair(AF_UNIX,SOCK_STREAM,0,fds) != 0 ) return WiFiClient();
+  closeClient();
+  fcntl(fds[1],F_SETFL,fcntl(fds[1],F_GETFL)|O_NONBLOCK);
+  _client     = WiFiClient(fds[0]);
+  _clientPeer = fds[1];
+  return _client;
+}
+
+String WebContext::clientOutput() {
+  String  result;
+  char    buffer[256];
+  ssize_t n;
+  while( (_clientPeer >= 0) && ((n = read(_clientPeer,buffer,sizeof(buffer))) > 0) ) result.concat(buffer,(unsigned int)n);
+  return result;
+}
+
+void WebContext::closeClient() {
+  if( _clientPeer >= 0 ) close(_clientPeer);
+  _clientPeer = -1;
+}
+
+} // End of namespace lsc
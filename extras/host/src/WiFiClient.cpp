@@ -0,0 +1,133 @@
+/**
+ * 
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+#include <WiFiClient.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+WiFiClient::Socket::~Socket() {
+  if( fd >= 0 ) close(fd);
+}
+
+WiFiClient::WiFiClient(int fd) : _socket(std::make_shared<Socket>()) {
+  _socket->fd = fd;
+}
+
+/**
+ *  Connects within the Stream timeout; returns 1 on success and 0 otherwise, as on the ESP
+ */
+int WiFiClient::connect(const char* host, uint16_t port) {
+  stop();
+  struct addrinfo  hints;
+  struct addrinfo* result = NULL;
+  char             service[8];
+  memset(&hints,0,sizeof(hints));
+  hints.ai_family   = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  snprintf(service,sizeof(service),"%u",(unsigned int)port);
+  if( getaddrinfo(host,service,&hints,&result) != 0 ) return 0;
+  for( struct addrinfo* a=result; (a != NULL) && (fd() < 0); a=a->ai_next ) {
+    int s = socket(a->ai_family,a->ai_socktype,a->ai_protocol);
+    if( s < 0 ) continue;
+    struct timeval tv;
+    tv.tv_sec  = _timeout/1000;
+    tv.tv_usec = (_timeout%1000)*1000;
+    setsockopt(s,SOL_SOCKET,SO_SNDTIMEO,&tv,sizeof(tv));
+    if( ::connect(s,a->ai_addr,a->ai_addrlen) != 0 ) close(s);
+    else {
+      _socket = std::make_shared<Socket>();
+      _socket->fd = s;
+    }
+  }
+  freeaddrinfo(result);
+  return ((fd() >= 0)?(1):(0));
+}
+
+size_t WiFiClient::write(const uint8_t* buffer, size_t size) {
+  size_t sent = 0;
+  while( (fd() >= 0) && (sent < size) ) {
+    ssize_t n = send(fd(),buffer+sent,size-sent,MSG_NOSIGNAL);
+    if( n <= 0 ) {stop(); break;}
+    sent += (size_t)n;
+  }
+  return sent;
+}
+
+/**
+ *  Returns the number of bytes that can be read without waiting. A connection the peer has closed is stopped, so that 
+ *  connected() reports it, as on the ESP
+ */
+int WiFiClient::available() {
+  if( fd() < 0 ) return 0;
+  struct pollfd p;
+  p.fd     = fd();
+  p.events = POLLIN;
+  if( poll(&p,1,0) <= 0 ) return 0;
+  int n = 0;
+  if( (ioctl(fd(),FIONREAD,&n) != 0) || (n <= 0) ) {stop(); return 0;}
+  return n;
+}
+
+/**
+ *  Reads up to size bytes that have already arrived, without waiting; returns the number read
+ */
+int WiFiClient::read(uint8_t* buffer, size_t size) {
+  int n = available();
+  if( n <= 0 ) return 0;
+  ssize_t r = recv(fd(),buffer,(((size_t)n < size)?((size_t)n):(size)),0);
+  if( r <= 0 ) {stop(); return 0;}
+  return (int)r;
+}
+
+/**
+ *  Returns the next byte, or -1 if none arrives within the timeout or the connection is closed
+ */
+int WiFiClient::read() {
+  if( fd() < 0 ) return -1;
+  struct pollfd p;
+  p.fd     = fd();
+  p.events = POLLIN;
+  if( poll(&p,1,(int)_timeout) <= 0 ) return -1;
+  uint8_t c;
+  if( recv(fd(),&c,1,0) != 1 ) {stop(); return -1;}
+  return c;
+}
+
+String WiFiClient::readStringUntil(char terminator) {
+  String result;
+  int    c;
+  while( ((c = read()) >= 0) && (c != terminator) ) result += (char)c;
+  return result;
+}
+
+/**
+ *  Closes the connection for every copy
+ */
+void WiFiClient::stop() {
+  if( !_socket ) return;
+  if( _socket->fd >= 0 ) close(_socket->fd);
+  _socket->fd = -1;
+  _socket.reset();
+}
@@ -0,0 +1,95 @@
+/**
+ * 
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+/**
+ *  Batch configuration tests: RootDevice configure requests apply every setting or none. Each rejected argument is
+ *  reported with its reason, and nothing is changed when any argument is rejected, including arguments before it.
+ */
+
+#include "Test.h"
+#include "UPnPDevice.h"
+#include "SensorWithConfig.h"
+
+using namespace lsc;
+
+namespace test {
+
+void batchTests() {
+  WebContext       ctx;
+  RootDevice       root;
+  SensorWithConfig sensor("sensor");
+  root.addDevice(&sensor);
+  ctx.setup(NULL,IPAddress(10,0,0,1),80);
+  root.setup(&ctx);
+
+  char base[64];
+  snprintf(base,sizeof(base),"%s/configure?",root.path());
+  std::string original = sensor.getMessage();
+  auto configure = [&ctx,&base](const std::string& args) {ctx.request((std::string(base)+args).c_str()); return ctx.responseCode();};
+  auto reports   = [&ctx](const char* line) {return (strstr(ctx.responseBody().c_str(),line) != NULL);};
+  auto unchanged = [&sensor,&original]() {return (strcmp(sensor.getDisplayName(),"Sensor With Config") == 0) && (original == sensor.getMessage());};
+
+  CHECK(unchanged());
+
+/**
+ *  Phase one rejects; nothing is applied
+ */
+  CHECK(configure("sensor.displayName=New&sensor.msg=hello&sensor.color=red") == 400);
+  CHECK(reports("rejected 1 of 3 settings, none applied"));
+  CHECK(reports("sensor.color unknown-setting"));
+  CHECK(unchanged());
+
+  CHECK(configure("sensor.msg=hello&nosuch.msg=x&sensordisplayName=x&sensor.displayName=&.msg=x&sensor.=x") == 400);
+  CHECK(reports("rejected 5 of 6 settings, none applied"));
+  CHECK(reports("nosuch.msg unknown-object"));
+  CHECK(reports("sensordisplayName malformed"));
+  CHECK(reports("sensor.displayName invalid-value"));
+  CHECK(reports(".msg malformed"));
+  CHECK(reports("sensor. malformed"));
+  CHECK(unchanged());
+
+  CHECK(configure("sensor.msg="+std::string(300,'x')) == 400);
+  CHECK(reports("sensor.msg invalid-value"));
+  CHECK(configure("sensor.msgs=x&sensor.ms=x") == 400);
+  CHECK(reports("rejected 2 of 2 settings"));
+  CHECK(unchanged());
+
+  std::string many;
+  for( int i=0; i<=MAX_BATCH_SETTINGS; i++ ) many += "sensor.msg=x&";
+  CHECK(configure(many) == 413);
+  CHECK(unchanged());
+
+/**
+ *  Phase two applies everything, addressed by target path or UUID
+ */
+  CHECK(configure("sensor.displayName=New&sensor.msg=hello") == 200);
+  CHECK(reports("applied 2 settings to 1 objects"));
+  CHECK((strcmp(sensor.getDisplayName(),"New") == 0) && (strcmp(sensor.getMessage(),"hello") == 0));
+
+  char id[UUID_SIZE];
+  sensor.getUUID().format(id);
+  CHECK(configure(std::string("uuid:")+id+".MSG=by-uuid&"+root.getTarget()+".displayName=Root") == 200);
+  CHECK(reports("applied 2 settings to 2 objects"));
+  CHECK((strcmp(sensor.getMessage(),"by-uuid") == 0) && (strcmp(root.getDisplayName(),"Root") == 0));
+}
+
+}
@@ -0,0 +1,176 @@
+/**
+ * 
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+/**
+ *  ConfigStore tests: a saved record restores the hierarchy, and a record that does not check (magic, version, length,
+ *  CRC) or whose entries run past its end is rejected without reading out of bounds. Records are written to
+ *  upnp_test.cfg in the working directory, which is removed afterwards.
+ */
+
+#include "Test.h"
+#include "UPnPDevice.h"
+#include "SensorWithConfig.h"
+#include <stdio.h>
+#include <vector>
+
+using namespace lsc;
+
+namespace test {
+
+static const char* const recordPath = "upnp_test.cfg";
+typedef std::vector<uint8_t> Record;
+
+/**
+ *  A SensorWithConfig whose message can be set directly
+ */
+class MessageSensor : public SensorWithConfig {
+  public:
+    MessageSensor(const char* target) : SensorWithConfig(target) {}
+    using SensorWithConfig::setMessage;
+};
+
+static Record readFile() {
+  Record result;
+  FILE*  f = fopen(recordPath,"rb");
+  if( f == NULL ) return result;
+  int c;
+  while( (c = fgetc(f)) != EOF ) result.push_back((uint8_t)c);
+  fclose(f);
+  return result;
+}
+
+static void writeFile(const Record& r) {
+  FILE* f = fopen(recordPath,"wb");
+  if( f == NULL ) return;
+  if( !r.empty() ) fwrite(r.data(),1,r.size(),f);
+  fclose(f);
+}
+
+/**
+ *  CRC-32 (IEEE 802.3), for records altered past the checks of length and CRC
+ */
+static void recrc(Record& r) {
+  uint32_t crc = 0xFFFFFFFF;
+  for( size_t i=12; i<r.size(); i++ ) {
+    crc ^= r[i];
+    for( int b=0; b<8; b++ ) crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+  }
+  crc = ~crc;
+  for( int i=0; i<4; i++ ) r[8+i] = (uint8_t)(crc >> (8*i));
+}
+
+static void setLength(Record& r, size_t length) {
+  r[6] = (uint8_t)length;
+  r[7] = (uint8_t)(length >> 8);
+}
+
+/**
+ *  Restores a fresh hierarchy from r, returning whether begin() accepted it. The sensor's message is reported in msg.
+ */
+static bool restores(const Record& r, std::string* msg = NULL) {
+  writeFile(r);
+  RootDevice       root;
+  SensorWithConfig sensor("sensor");
+  ConfigStore      store;
+  root.addDevice(&sensor);
+  bool result = store.begin(&root,recordPath);
+  if( msg != NULL ) *msg = sensor.getMessage();
+  return result;
+}
+
+void configStoreTests() {
+  remove(recordPath);
+  {
+    RootDevice  root;
+    ConfigStore store;
+    CHECK(!store.begin(&root,recordPath));                         // No record yet
+  }
+
+  RootDevice       root;
+  MessageSensor    sensor("sensor");
+  ConfigStore      store;
+  root.addDevice(&sensor);
+  store.begin(&root,recordPath);
+  sensor.setDisplayName("Saved Sensor");
+  sensor.setMessage("saved message");
+  CHECK(store.save(&root));
+  CHECK(store.save(&root));                                        // Unchanged, so not written again
+  CHECK((store.writes() == 1) && (store.skipped() == 1));
+
+  Record saved = readFile();
+  CHECK(saved.size() == store.recordSize());
+  CHECK((saved.size() > 12) && (memcmp(saved.data(),"UPnC",4) == 0) && (saved[5] == 2));
+  if( saved.size() <= 12 ) return;
+
+  std::string msg;
+  {
+    RootDevice       r;
+    SensorWithConfig s("sensor");
+    ConfigStore      cs;
+    r.addDevice(&s);
+    CHECK(cs.begin(&r,recordPath));
+    CHECK(strcmp(s.getDisplayName(),"Saved Sensor") == 0);
+    CHECK(strcmp(s.getMessage(),"saved message") == 0);
+    CHECK(s.getUUID() == sensor.getUUID());
+  }
+
+/**
+ *  Records that do not check are ignored whole
+ */
+  Record r;
+  CHECK(!restores(Record()));
+  CHECK(!restores(Record(saved.begin(),saved.begin()+5)));
+  CHECK(!restores(Record(saved.begin(),saved.begin()+12)));
+  r = saved; r[0] = 'X';                      CHECK(!restores(r));
+  r = saved; r[4]++;                          CHECK(!restores(r));
+  r = saved; r.pop_back();                    CHECK(!restores(r));
+  r = saved; r.push_back(0);                  CHECK(!restores(r));
+  r = saved; setLength(r,saved.size()-12+1);  CHECK(!restores(r));
+  r = saved; setLength(r,0xFFFF);             CHECK(!restores(r));
+  r = saved; r[8] ^= 1;                       CHECK(!restores(r));
+  r = saved; r.back() ^= 0x20;                CHECK(!restores(r,&msg) && (msg != "saved message"));
+
+/**
+ *  Records that check but whose entries run past the end are rejected; ASan builds catch any read beyond it
+ */
+  size_t root0   = 12;
+  size_t target0 = root0 + 20;
+  size_t name0   = target0 + 1 + saved[target0];
+  size_t count0  = name0 + 1 + saved[name0];
+  r = saved; r[5] = 3; recrc(r);                    CHECK(!restores(r));
+  r = saved; r[target0] = 255; recrc(r);            CHECK(!restores(r));
+  r = saved; r[name0] = 255; recrc(r);              CHECK(!restores(r));
+  r = saved; r[count0] = 255; recrc(r);             CHECK(!restores(r));
+  r = Record(saved.begin(),saved.begin()+count0+1); setLength(r,r.size()-12); r[5] = 2; recrc(r);
+  CHECK(!restores(r,&msg) && (msg != "saved message"));
+
+/**
+ *  A record that checks restores whatever its entries match, so the same record altered and checked again is applied
+ */
+  r = saved;
+  for( size_t i=0; i+5<r.size(); i++ ) {if( memcmp(&r[i],"saved",5) == 0 ) r[i] = 'S';}
+  recrc(r);
+  CHECK(restores(r,&msg) && (msg == "Saved message"));
+  remove(recordPath);
+}
+
+}
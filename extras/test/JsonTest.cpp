@@ -0,0 +1,87 @@
+/**
+ * 
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+/**
+ *  JsonWriter tests: commas between members and elements at every depth, none after a key or an opening bracket, and
+ *  escaped strings.
+ */
+
+#include "Test.h"
+#include "ResponseStream.h"
+
+using namespace lsc;
+
+namespace test {
+
+/**
+ *  Runs fn with a JsonWriter over a ResponseStream that collects what it is sent
+ */
+static std::string json(std::function<void(JsonWriter&)> fn) {
+  std::string result;
+  {
+    ResponseStream out([&result](const char* data, size_t len){result.append(data,len);});
+    JsonWriter     w(out);
+    fn(w);
+  }
+  return result;
+}
+
+void jsonTests() {
+  CHECK(json([](JsonWriter& w){w.beginObject(); w.endObject();}) == "{}");
+  CHECK(json([](JsonWriter& w){w.beginArray(); w.endArray();}) == "[]");
+  CHECK(json([](JsonWriter& w){w.beginObject(); w.member("a",1); w.endObject();}) == "{\"a\":1}");
+  CHECK(json([](JsonWriter& w){w.beginObject(); w.member("a",1); w.member("b",true); w.member("c","x"); w.endObject();})
+        == "{\"a\":1,\"b\":true,\"c\":\"x\"}");
+  CHECK(json([](JsonWriter& w){w.beginArray(); w.value(1); w.value(false); w.value((const char*)NULL); w.endArray();})
+        == "[1,false,null]");
+
+/**
+ *  Nested containers take a comma as a value, and start their own list
+ */
+  CHECK(json([](JsonWriter& w){
+          w.beginObject();
+          w.member("a",1);
+          w.key("b");
+          w.beginArray();
+          w.value(1);
+          w.beginObject(); w.endObject();
+          w.beginArray(); w.value("y"); w.value("z"); w.endArray();
+          w.endArray();
+          w.key("c");
+          w.beginObject(); w.member("d",-2L); w.endObject();
+          w.member("e","");
+          w.endObject();
+        }) == "{\"a\":1,\"b\":[1,{},[\"y\",\"z\"]],\"c\":{\"d\":-2},\"e\":\"\"}");
+  CHECK(json([](JsonWriter& w){
+          w.beginArray();
+          for( int i=0; i<3; i++ ) {w.beginObject(); w.member("i",i); w.endObject();}
+          w.endArray();
+        }) == "[{\"i\":0},{\"i\":1},{\"i\":2}]");
+
+/**
+ *  Keys and values are escaped, with '<' escaped so that JSON can be embedded in a page
+ */
+  CHECK(json([](JsonWriter& w){w.beginObject(); w.member("q\"k","a\\b\n\t</script>\x01"); w.endObject();})
+        == "{\"q\\\"k\":\"a\\\\b\\n\\t\\u003c/script>\\u0001\"}");
+}
+
+}
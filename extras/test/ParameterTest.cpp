@@ -0,0 +1,104 @@
+/**
+ * 
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+/**
+ *  Parameter tests: decode() of each type into an argument struct, bounds and rejects, checking only when args is NULL,
+ *  and compile time name hashes that ignore case.
+ */
+
+#include "Test.h"
+#include "Parameters.h"
+
+using namespace lsc;
+
+namespace test {
+
+struct TestArgs {
+  char     name[8];
+  int32_t  level;
+  boolean  async;
+  int      state;
+};
+
+static const char* const onOff[] = {"OFF","ON"};
+static const Parameter   testParams[] = {Parameter::text("name",offsetof(TestArgs,name),sizeof(TestArgs::name),2),
+                                         Parameter::integer("level",offsetof(TestArgs,level),-10,100),
+                                         Parameter::flag("async",offsetof(TestArgs,async)),
+                                         Parameter::choice("STATE",offsetof(TestArgs,state),onOff,2)};
+
+static bool decode(int i, const char* value, TestArgs* args) {return testParams[i].decode(value,strlen(value),args);}
+
+void parameterTests() {
+  TestArgs args = {"",-1,false,-1};
+
+  static_assert(Parameter::hash("State") == Parameter::hash("STATE"),"hash() folds case");
+  CHECK(testParams[3].nameHash == Parameter::hash("state"));
+  CHECK(Parameter::hash("level") != Parameter::hash("levels"));
+
+/**
+ *  Text: at least min characters, truncated to the field
+ */
+  CHECK(decode(0,"ab",&args) && (strcmp(args.name,"ab") == 0));
+  CHECK(decode(0,"abcdefghij",&args) && (strcmp(args.name,"abcdefg") == 0));
+  CHECK(!decode(0,"a",&args) && (strcmp(args.name,"abcdefg") == 0));
+  CHECK(!decode(0,"",&args));
+
+/**
+ *  Integer: whole decimal numbers within bounds
+ */
+  CHECK(decode(1,"42",&args) && (args.level == 42));
+  CHECK(decode(1,"-10",&args) && (args.level == -10));
+  CHECK(decode(1,"100",&args) && (args.level == 100));
+  CHECK(!decode(1,"101",&args) && (args.level == 100));
+  CHECK(!decode(1,"-11",&args));
+  CHECK(!decode(1,"12abc",&args));
+  CHECK(!decode(1,"",&args));
+  CHECK(!decode(1," ",&args));
+  CHECK(!decode(1,"99999999999999999999",&args));
+  CHECK(args.level == 100);
+
+/**
+ *  Flag: no value at all is true
+ */
+  CHECK(decode(2,"",&args) && args.async);
+  CHECK(decode(2,"off",&args) && !args.async);
+  CHECK(decode(2,"YES",&args) && args.async);
+  CHECK(decode(2,"0",&args) && !args.async);
+  CHECK(!decode(2,"maybe",&args) && !args.async);
+
+/**
+ *  Choice: the index of the value, compared without case
+ */
+  CHECK(decode(3,"on",&args) && (args.state == 1));
+  CHECK(decode(3,"OFF",&args) && (args.state == 0));
+  CHECK(!decode(3,"toggle",&args) && (args.state == 0));
+
+/**
+ *  With args NULL values are only checked
+ */
+  CHECK(decode(0,"xyz",NULL));
+  CHECK(!decode(1,"1000",NULL));
+  CHECK(decode(3,"On",NULL));
+  CHECK(strcmp(args.name,"abcdefg") == 0);
+}
+
+}
@@ -0,0 +1,71 @@
+/**
+ * 
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+/**
+ *  Scheduler tests: devices keep their periods through the timer wheel. A 300ms period is longer than level 0 spans 
+ *  (64 ticks of SCHEDULER_TICK ms), so it is placed in level 1 and reaches level 0 only when the wheel cascades; a 
+ *  period longer than the run is never due. The loop runs for a second of real time.
+ */
+
+#include "Test.h"
+#include "UPnPDevice.h"
+#include "SimpleSensor.h"
+
+using namespace lsc;
+
+namespace test {
+
+void schedulerTests() {
+  RootDevice   root;
+  SimpleSensor fast("fast");
+  SimpleSensor slow("slow");
+  SimpleSensor idle("idle");
+  root.addDevice(&fast);
+  root.addDevice(&slow);
+  root.addDevice(&idle);
+  fast.setSchedule(20);
+  slow.setSchedule(300);
+  idle.setSchedule(5000);
+
+  Scheduler*    sch   = root.scheduler();
+  unsigned long start = millis();
+  while( millis()-start < 1000 ) {
+    root.doDevice();
+    delay(1);
+  }
+
+  const ScheduleStats* f = sch->stats(&fast);
+  const ScheduleStats* s = sch->stats(&slow);
+  const ScheduleStats* i = sch->stats(&idle);
+  CHECK((f != NULL) && (s != NULL) && (i != NULL));
+  if( (f == NULL) || (s == NULL) || (i == NULL) ) return;
+
+  CHECK((f->runs >= 40) && (f->runs <= 50));
+  CHECK(s->runs == 3);
+  CHECK(i->runs == 0);
+  CHECK((f->missed == 0) && (s->missed == 0));
+  CHECK(s->maxLateness <= 50);
+  CHECK(sch->loops() > 100);
+  CHECK(sch->pending() == 0);
+}
+
+}
@@ -0,0 +1,80 @@
+/**
+ * 
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+/**
+ *  Page template tests: the compile time split of a template's text into literal segments and typed slots (checked
+ *  with static_assert, so a regression fails the build), and render() output.
+ */
+
+#include "Test.h"
+#include "PageTemplate.h"
+
+using namespace lsc;
+
+namespace test {
+
+PAGE_TEMPLATE(TestRow,    "<tr><td>%s</td><td>%d</td></tr>");
+PAGE_TEMPLATE(TestLead,   "%s and %s%d");
+PAGE_TEMPLATE(TestPlain,  "<hr>");
+PAGE_TEMPLATE(TestLong,   "0123456789012345678901234567890123456789012345678901234567890123456789%s0123456789012345678901234567890123456789%d.");
+
+static_assert(TemplateScan::count("a%sb%dc",0,7) == 2,"count");
+static_assert(TemplateScan::countOf("a%sb%dc",'s',0,7) == 1,"countOf");
+static_assert(TemplateScan::find("a%sb%dc",0,0,7) == 1,"find 0");
+static_assert(TemplateScan::find("a%sb%dc",1,0,7) == 4,"find 1");
+static_assert(TemplateScan::valid("a%sb%dc",0,7),"valid");
+static_assert(!TemplateScan::valid("a%xb",0,4),"%x is not a slot");
+
+static_assert(TestRow::slots == 2,"slots");
+static_assert(TestRow::textSlots == 1,"textSlots");
+static_assert(TestRow::literalLength == 27,"literalLength");
+static_assert((TestRow::start(0) == 0) && (TestRow::length(0) == 8),"segment 0");
+static_assert((TestRow::start(1) == 10) && (TestRow::length(1) == 9),"segment 1");
+static_assert((TestRow::start(2) == 21) && (TestRow::length(2) == 10),"segment 2");
+static_assert((TestRow::type(0) == 's') && (TestRow::type(1) == 'd'),"types");
+static_assert(TestRow::maxLength(4) == 27 + 4*TEMPLATE_ESCAPE_MAX + TEMPLATE_INT_MAX,"maxLength");
+
+static_assert((TestLead::slots == 3) && (TestLead::length(0) == 0) && (TestLead::length(2) == 0) && (TestLead::length(3) == 0),"empty segments");
+static_assert((TestPlain::slots == 0) && (TestPlain::length(0) == 4),"no slots");
+static_assert((TestLong::start(1) == 72) && (TestLong::length(1) == 40) && (TestLong::type(1) == 'd'),"long template");
+
+template<typename T, typename... V>
+static std::string render(V... values) {
+  std::string result;
+  {
+    ResponseStream out([&result](const char* data, size_t len){result.append(data,len);});
+    T::render(out,values...);
+  }
+  return result;
+}
+
+void templateTests() {
+  CHECK(render<TestRow>("a",1) == "<tr><td>a</td><td>1</td></tr>");
+  CHECK(render<TestRow>("<b>&\"",-25L) == "<tr><td>&lt;b&gt;&amp;&quot;</td><td>-25</td></tr>");
+  CHECK(render<TestRow>("",0) == "<tr><td></td><td>0</td></tr>");
+  CHECK(render<TestLead>("x","y",7) == "x and y7");
+  CHECK(render<TestPlain>() == "<hr>");
+  CHECK(render<TestLong>("s",9).size() == TestLong::literalLength + 2);
+  CHECK(render<TestRow>("abcd",-2147483647-1).size() <= TestRow::maxLength(4));
+}
+
+}
@@ -0,0 +1,55 @@
+/**
+ * 
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+/**
+ *  Minimal host test harness. Each suite checks one part of the library with CHECK(condition); a failed check prints
+ *  its file, line and condition. upnp_test prints one line per suite and exits non zero if any check failed, so it can
+ *  be run by ctest.
+ */
+
+#ifndef UPNP_TEST_H
+#define UPNP_TEST_H
+
+#include <Arduino.h>
+#include <WebContext.h>
+#include <string>
+
+namespace test {
+
+#define CHECK(condition) test::check((condition),#condition,__FILE__,__LINE__)
+
+void check(bool passed, const char* condition, const char* file, int line);
+
+/**
+ *  Suites
+ */
+void uuidTests();
+void parameterTests();
+void jsonTests();
+void templateTests();
+void configStoreTests();
+void batchTests();
+void schedulerTests();
+
+}
+
+#endif
@@ -0,0 +1,60 @@
+/**
+ * 
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+/**
+ *  upnp_test
+ *     Runs every suite and exits with the number of failed checks (0 when all pass)
+ */
+
+#include "Test.h"
+
+namespace test {
+
+static int checks   = 0;
+static int failures = 0;
+
+void check(bool passed, const char* condition, const char* file, int line) {
+  checks++;
+  if( passed ) return;
+  failures++;
+  Serial.printf("  FAILED %s:%d: %s\n",file,line,condition);
+}
+
+static void run(const char* suite, void (*fn)()) {
+  int f = failures;
+  int c = checks;
+  fn();
+  Serial.printf("%-12s %4d checks, %d failed\n",suite,checks-c,failures-f);
+}
+
+}
+
+int main() {
+  test::run("UUID",test::uuidTests);
+  test::run("Parameter",test::parameterTests);
+  test::run("JsonWriter",test::jsonTests);
+  test::run("Template",test::templateTests);
+  test::run("ConfigStore",test::configStoreTests);
+  test::run("Batch",test::batchTests);
+  test::run("Scheduler",test::schedulerTests);
+  return ((test::failures > 255)?(255):(test::failures));
+}
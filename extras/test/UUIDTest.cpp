@@ -0,0 +1,111 @@
+/**
+ * 
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+/**
+ *  UUID tests: parse() accepts the canonical form with or without "uuid:", in either case, and rejects anything else
+ *  without changing the UUID; format() gives the parsed string back in lower case. Device UUIDs derived from the path
+ *  follow it until set with setUUID().
+ */
+
+#include "Test.h"
+#include "UUID.h"
+#include "UPnPDevice.h"
+
+using namespace lsc;
+
+namespace test {
+
+void uuidTests() {
+  const char* canonical = "6ba7b810-9dad-11d1-80b4-00c04fd430c8";
+  char        buffer[UUID_SIZE];
+  UUID        u;
+  UUID        v;
+
+  CHECK(u.isNull());
+  CHECK(u.parse(canonical));
+  CHECK(!u.isNull());
+  u.format(buffer);
+  CHECK(strcmp(buffer,canonical) == 0);
+  CHECK(u.bytes()[0] == 0x6b);
+  CHECK(u.bytes()[15] == 0xc8);
+
+  CHECK(v.parse("uuid:6ba7b810-9dad-11d1-80b4-00c04fd430c8"));
+  CHECK(v == u);
+  CHECK(v.parse("UUID:6BA7B810-9DAD-11D1-80B4-00C04FD430C8"));
+  CHECK(v == u);
+  CHECK(v.hash() == u.hash());
+
+/**
+ *  Rejected strings leave the UUID as it was
+ */
+  CHECK(!v.parse(NULL));
+  CHECK(!v.parse(""));
+  CHECK(!v.parse("uuid:"));
+  CHECK(!v.parse("6ba7b810-9dad-11d1-80b4-00c04fd430c"));            // Short
+  CHECK(!v.parse("6ba7b810-9dad-11d1-80b4-00c04fd430c8a"));          // Long
+  CHECK(!v.parse("6ba7b8109-dad-11d1-80b4-00c04fd430c8"));           // Dash misplaced
+  CHECK(!v.parse("6ba7b810-9dad-11d1-80b4-00c04fd430cg"));           // Not hex
+  CHECK(!v.parse("6ba7b810-9dad-11d1-80b4_00c04fd430c8"));           // Not a dash
+  CHECK(!v.parse(" 6ba7b810-9dad-11d1-80b4-00c04fd430c8"));
+  CHECK(v == u);
+  CHECK(!UUID::isValid("6ba7b810-9dad-11d1-80b4"));
+  CHECK(UUID::isValid(canonical));
+
+/**
+ *  Name based UUIDs are version 5, RFC 4122 variant, and the same for the same name
+ */
+  UUID a;
+  UUID b;
+  a.nameBased(u,"/root/sensor");
+  b.nameBased(u,"/root/sensor");
+  CHECK(a == b);
+  CHECK((a.bytes()[6] >> 4) == 5);
+  CHECK((a.bytes()[8] & 0xC0) == 0x80);
+  b.nameBased(u,"/root/control");
+  CHECK(!(a == b));
+  a.format(buffer);
+  CHECK(b.parse(buffer) && (a == b));
+
+/**
+ *  A UUID used before the device is placed is derived again once it is
+ */
+  RootDevice root;
+  RootDevice other;
+  UPnPDevice d("device");
+  UPnPDevice e("moved");
+  UUID       early = d.getUUID();
+  root.addDevice(&d);
+  other.addDevice(&e);
+  CHECK(!(d.getUUID() == early));
+  d.setTarget("moved");
+  CHECK(d.getUUID() == e.getUUID());
+  e.getUUID().format(buffer);
+  CHECK(strcmp(d.uuid(),buffer) == 0);
+  d.setUUID(u);
+  d.setTarget("device");
+  CHECK((d.getUUID() == u) && (strcmp(d.uuid(),canonical) == 0));
+  d.setUUID(UUID());
+  d.setTarget("moved");
+  CHECK(d.getUUID() == e.getUUID());
+}
+
+}
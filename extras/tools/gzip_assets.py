@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+#
+#  UPnPDevice Library
+#  Copyright (C) 2023  Daniel L Toth
+#
+#  This program is free software: you can redistribute it and/or modify
+#  it under the terms of the GNU Lesser General Public License as published
+#  by the Free Software Foundation, either version 3 of the License, or any
+#  later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU Lesser General Public License for more details.
+#
+#  You should have received a copy of the GNU Lesser General Public License
+#  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#
+#  The author can be contacted at dan@leelanausoftware.com
+#
+
+"""
+Generates GzipAssets.h, gzip compressed PROGMEM copies of static assets defined as C string literals.
+
+    gzip_assets.py SOURCE [-a NAME]... [-o OUTPUT]
+
+SOURCE is a C/C++ file defining the assets, for example CommonProgmem.cpp from CommonUtil, and NAME an asset
+defined there as  const char NAME[] PROGMEM = "..." "...";  (default styles_css). For each asset the header defines
+
+    NAME_gz[]      := The gzip compressed asset, in PROGMEM
+    NAME_gz_size   := Size of NAME_gz in bytes
+    NAME_hash      := FNV-1a hash of the uncompressed asset
+
+UPnPDevice serves NAME_gz only when NAME_hash matches the asset it was built against, so a header generated
+from a different version of the source is ignored rather than served. Output is reproducible (gzip mtime is 0).
+Copy or generate the header into src/ for Arduino builds; the host CMake build generates its own.
+"""
+
+import argparse
+import gzip
+import re
+import sys
+
+ESCAPES = {'n': 10, 't': 9, 'r': 13, '0': 0, '\\': 92, '"': 34, "'": 39, 'a': 7, 'b': 8, 'f': 12, 'v': 11, '?': 63}
+
+
+def decode(literal):
+    """Bytes of the body of a C string literal"""
+    out = bytearray()
+    i = 0
+    while i < len(literal):
+        c = literal[i]
+        if c != '\\':
+            out += c.encode('utf-8')
+            i += 1
+            continue
+        e = literal[i+1]
+        if e == 'x':
+            m = re.match(r'[0-9a-fA-F]+', literal[i+2:])
+            out.append(int(m.group(0), 16) & 0xff)
+            i += 2 + len(m.group(0))
+        elif e in '01234567':
+            m = re.match(r'[0-7]{1,3}', literal[i+1:])
+            out.append(int(m.group(0), 8) & 0xff)
+            i += 1 + len(m.group(0))
+        else:
+            out.append(ESCAPES[e])
+            i += 2
+    return bytes(out)
+
+
+def extract(source, name):
+    """Concatenation of the adjacent string literals initializing name"""
+    m = re.search(r'\b' + re.escape(name) + r'\s*\[\s*\]\s*(?:PROGMEM\s*)?=\s*((?:\s*"(?:[^"\\]|\\.)*")+)\s*;', source, re.S)
+    if m is None:
+        sys.exit('gzip_assets: %s not found' % name)
+    return b''.join(decode(s) for s in re.findall(r'"((?:[^"\\]|\\.)*)"', m.group(1), re.S))
+
+
+def fnv1a(data):
+    h = 2166136261
+    for b in data:
+        h = ((h ^ b) * 16777619) & 0xffffffff
+    return h
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Generate gzip compressed PROGMEM copies of static assets')
+    parser.add_argument('source')
+    parser.add_argument('-a', '--asset', action='append', dest='assets')
+    parser.add_argument('-o', '--output', default='GzipAssets.h')
+    args = parser.parse_args()
+
+    with open(args.source, encoding='utf-8') as f:
+        source = f.read()
+    lines = ['/**',
+             ' *  Generated by extras/tools/gzip_assets.py; do not edit',
+             ' */',
+             '',
+             '#ifndef GZIP_ASSETS_H',
+             '#define GZIP_ASSETS_H',
+             '',
+             'namespace lsc {',
+             '']
+    for name in (args.assets or ['styles_css']):
+        raw = extract(source, name)
+        gz = gzip.compress(raw, compresslevel=9, mtime=0)
+        lines.append('const uint32_t %s_hash    = 0x%08x;      // %d bytes uncompressed' % (name, fnv1a(raw), len(raw)))
+        lines.append('const size_t   %s_gz_size = %d;' % (name, len(gz)))
+        lines.append('const uint8_t  %s_gz[]    PROGMEM = {' % name)
+        for i in range(0, len(gz), 16):
+            lines.append('  ' + ','.join('0x%02x' % b for b in gz[i:i+16]) + ',')
+        lines.append('};')
+        lines.append('')
+    lines += ['} // End of namespace lsc', '', '#endif', '']
+    with open(args.output, 'w') as f:
+        f.write('\n'.join(lines))
+
+
+if __name__ == '__main__':
+    main()
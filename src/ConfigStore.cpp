@@ -0,0 +1,320 @@
+/**
+ * 
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+#include "ConfigStore.h"
+#include "UPnPDevice.h"
+#if defined(ESP32) || defined(ESP8266)
+#include <LittleFS.h>
+#else
+#include <stdio.h>
+#endif
+
+#define RECORD_HEADER   12
+
+/** Leelanau Software Company namespace 
+*  
+*/
+namespace lsc {
+
+/**
+ *  Record fields are little endian. While a record is measured the buffer is NULL and only the position advances.
+ */
+static void putByte(uint8_t* buffer, size_t& pos, uint8_t v) {
+  if( buffer != NULL ) buffer[pos] = v;
+  pos++;
+}
+
+static void putBytes(uint8_t* buffer, size_t& pos, const void* data, size_t len) {
+  if( buffer != NULL ) memcpy(buffer+pos,data,len);
+  pos += len;
+}
+
+static void putWord(uint8_t* buffer, size_t& pos, uint32_t v) {
+  for( int i=0; i<4; i++ ) putByte(buffer,pos,(uint8_t)(v >> (8*i)));
+}
+
+static void putString(uint8_t* buffer, size_t& pos, const char* s) {
+  size_t len = strlen(s);
+  if( len > 255 ) len = 255;
+  putByte(buffer,pos,(uint8_t)len);
+  putBytes(buffer,pos,s,len);
+}
+
+static uint32_t getWord(const uint8_t* p) {return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);}
+
+void ConfigWriter::put(const char* name, const char* value) {
+  if( name == NULL ) return;
+  put(Parameter::hash(name),value);
+}
+
+void ConfigWriter::put(const Parameter& param, const char* value) {put(param.name,value);}
+
+void ConfigWriter::put(uint32_t h, const char* value) {
+  if( (value == NULL) || (_count >= 255) ) return;
+  size_t len = strlen(value);
+  if( len > 255 ) len = 255;
+  putWord(_buffer,_pos,h);
+  putByte(_buffer,_pos,(uint8_t)len);
+  putBytes(_buffer,_pos,value,len);
+  putByte(_buffer,_pos,0);
+  _count++;
+}
+
+/**
+ *  The name itself is compared, so a setting whose name only hashes the same is not taken for the one looked for
+ */
+void ConfigProbe::put(const char* name, const char* value) {
+  _found = _found || ((name != NULL) && (value != NULL) && (Parameter::hash(name) == _hash) && (strcasecmp(name,_name) == 0));
+}
+
+void ConfigProbe::put(const Parameter& param, const char* value) {
+  boolean found = _found;
+  put(param.name,value);
+  if( _found && !found ) _parameter = &param;
+}
+
+void ConfigProbe::put(uint32_t h, const char* value) {_found = _found || ((value != NULL) && (h == _hash));}
+
+const char* ConfigReader::get(const char* name) const {
+  uint32_t       h = Parameter::hash(name);
+  const uint8_t* p = _settings;
+  for( int i=0; i<_count; i++ ) {
+    if( getWord(p) == h ) return (const char*)(p+5);
+    p += 5 + p[4] + 1;
+  }
+  return NULL;
+}
+
+boolean ConfigStore::begin(RootDevice* root, const char* path) {
+  if( (root == NULL) || (path == NULL) ) return false;
+#if defined(ESP32)
+  if( !LittleFS.begin(true) ) return false;
+#elif defined(ESP8266)
+  if( !LittleFS.begin() ) return false;
+#endif
+  free(_path);
+  _path = (char*)malloc(strlen(path)+1);
+  if( _path == NULL ) return false;
+  strcpy(_path,path);
+
+  uint8_t* record = NULL;
+  size_t   size   = 0;
+  boolean  result = readRecord(record,size) && restore(root,record,size);
+  free(record);
+  return result;
+}
+
+void ConfigStore::changed() {
+  if( _path == NULL ) return;
+  unsigned long now = millis();
+  if( !_pending ) _firstChange = now;
+  _pending    = true;
+  _lastChange = now;
+}
+
+void ConfigStore::run(RootDevice* root) {
+  if( !_pending ) return;
+  unsigned long now = millis();
+  if( (now-_lastChange < CONFIG_STORE_DELAY) && (now-_firstChange < CONFIG_STORE_MAX_DELAY) ) return;
+  save(root);
+}
+
+/**
+ *  The record is measured, then built in a heap buffer of exactly its size. A record whose CRC and size match the one last
+ *  read or written is not written again. A save that fails for any reason, including a record too large for the header
+ *  or no memory to build it, stays pending and is tried again after another delay.
+ */
+boolean ConfigStore::save(RootDevice* root) {
+  if( (_path == NULL) || (root == NULL) ) return false;
+  size_t   size   = serialize(root,NULL);
+  uint8_t* record = ((size-RECORD_HEADER <= 0xFFFF)?((uint8_t*)malloc(size)):(NULL));
+  boolean  result = (record != NULL);
+  if( result ) {
+    serialize(root,record);
+    uint32_t crc = getWord(record+8);
+    if( (crc == _crc) && (size == _size) ) _skipped++;
+    else if( writeRecord(record,size) ) {
+      _crc  = crc;
+      _size = size;
+      _writes++;
+    }
+    else result = false;
+  }
+  free(record);
+  _pending = false;
+  if( !result ) changed();                  // Pending again, with the delay restarted
+  return result;
+}
+
+size_t ConfigStore::serialize(RootDevice* root, uint8_t* buffer) {
+  size_t pos     = RECORD_HEADER;
+  int    devices = 0;
+  for( int i=-1; (i<root->numDevices()) && (devices < 255); i++ ) {
+    UPnPDevice* d = ((i<0)?(root):(root->device(i)));
+    putWord(buffer,pos,typeHash(d));
+    putBytes(buffer,pos,d->getUUID().bytes(),16);
+    putString(buffer,pos,d->getTarget());
+    putString(buffer,pos,d->getDisplayName());
+    size_t countPos = pos++;
+    ConfigWriter settings(buffer,pos);
+    d->saveSettings(settings);
+    if( buffer != NULL ) buffer[countPos] = (uint8_t)settings.count();
+    pos = settings.pos();
+    devices++;
+  }
+  if( buffer != NULL ) {
+    size_t header = 0;
+    putBytes(buffer,header,"UPnC",4);
+    putByte(buffer,header,CONFIG_STORE_VERSION);
+    putByte(buffer,header,(uint8_t)devices);
+    putByte(buffer,header,(uint8_t)(pos-RECORD_HEADER));
+    putByte(buffer,header,(uint8_t)((pos-RECORD_HEADER) >> 8));
+    putWord(buffer,header,crc32(buffer+RECORD_HEADER,pos-RECORD_HEADER));
+  }
+  return pos;
+}
+
+/**
+ *  Every entry is checked against the end of the record before it is used, so a damaged record that passes the CRC 
+ *  still cannot be read past its end
+ */
+boolean ConfigStore::restore(RootDevice* root, const uint8_t* record, size_t size) {
+  if( (size < RECORD_HEADER) || (memcmp(record,"UPnC",4) != 0) || (record[4] != CONFIG_STORE_VERSION) ) return false;
+  int    devices = record[5];
+  size_t length  = record[6] | (record[7] << 8);
+  if( (RECORD_HEADER+length != size) || (crc32(record+RECORD_HEADER,length) != getWord(record+8)) ) return false;
+
+  const uint8_t* p   = record + RECORD_HEADER;
+  const uint8_t* end = record + size;
+  for( int i=0; i<devices; i++ ) {
+    if( end-p < 21 ) return false;
+    uint32_t       type   = getWord(p);
+    const uint8_t* uuid   = p + 4;
+    const uint8_t* target = p + 20;
+    p = target + 1 + target[0];
+    if( end-p < 1 ) return false;
+    const uint8_t* name = p;
+    p = name + 1 + name[0];
+    if( end-p < 1 ) return false;
+    int            count    = *p++;
+    const uint8_t* settings = p;
+    for( int j=0; j<count; j++ ) {
+      if( (end-p < 5) || (end-p < 5 + p[4] + 1) ) return false;
+      p += 5 + p[4] + 1;
+    }
+
+    UPnPDevice* d = ((i==0)?(root):(root->device(i-1)));
+    if( (d == NULL) || (typeHash(d) != type) ) continue;
+    char buffer[NAME_SIZE > TARGET_SIZE ? NAME_SIZE : TARGET_SIZE];
+    if( (target[0] > 0) && (target[0] < TARGET_SIZE) ) {
+      memcpy(buffer,target+1,target[0]);
+      buffer[target[0]] = '\0';
+      d->setTarget(buffer);
+    }
+    if( name[0] > 0 ) {
+      size_t len = ((name[0] < NAME_SIZE)?(name[0]):(NAME_SIZE-1));
+      memcpy(buffer,name+1,len);
+      buffer[len] = '\0';
+      d->setDisplayName(buffer);
+    }
+    UUID id;
+    memcpy(id.bytes(),uuid,16);
+    if( !id.isNull() ) d->setUUID(id);
+    ConfigReader reader(settings,count);
+    d->restoreSettings(reader);
+  }
+  _crc  = getWord(record+8);
+  _size = size;
+  return true;
+}
+
+uint32_t ConfigStore::typeHash(UPnPDevice* dvc) {return Parameter::hash(dvc->getType());}
+
+/**
+ *  CRC-32 (IEEE 802.3), bit at a time; records are small and checked once per read or write
+ */
+uint32_t ConfigStore::crc32(const uint8_t* data, size_t size) {
+  uint32_t crc = 0xFFFFFFFF;
+  for( size_t i=0; i<size; i++ ) {
+    crc ^= data[i];
+    for( int b=0; b<8; b++ ) crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+  }
+  return ~crc;
+}
+
+boolean ConfigStore::readRecord(uint8_t*& record, size_t& size) {
+  record = NULL;
+  size   = 0;
+#if defined(ESP32) || defined(ESP8266)
+  File f = LittleFS.open(_path,"r");
+  if( !f ) return false;
+  size = f.size();
+  if( (size < RECORD_HEADER) || (size > RECORD_HEADER+0xFFFF) || ((record = (uint8_t*)malloc(size)) == NULL) ) {
+    f.close();
+    return false;
+  }
+  boolean ok = (f.read(record,size) == size);
+  f.close();
+#else
+  FILE* f = fopen(_path,"rb");
+  if( f == NULL ) return false;
+  long len = ((fseek(f,0,SEEK_END) == 0)?(ftell(f)):(-1));
+  size = ((len > 0)?((size_t)len):(0));
+  if( (size < RECORD_HEADER) || (size > RECORD_HEADER+0xFFFF) || (fseek(f,0,SEEK_SET) != 0) || ((record = (uint8_t*)malloc(size)) == NULL) ) {
+    fclose(f);
+    return false;
+  }
+  boolean ok = (fread(record,1,size,f) == size);
+  fclose(f);
+#endif
+  if( !ok ) {
+    free(record);
+    record = NULL;
+  }
+  return ok;
+}
+
+/**
+ *  Written to path.tmp and renamed over path, so the old record survives a failed write
+ */
+boolean ConfigStore::writeRecord(const uint8_t* record, size_t size) {
+  size_t len = strlen(_path);
+  char*  tmp = (char*)malloc(len+5);
+  if( tmp == NULL ) return false;
+  memcpy(tmp,_path,len);
+  strcpy(tmp+len,".tmp");
+#if defined(ESP32) || defined(ESP8266)
+  File f = LittleFS.open(tmp,"w");
+  boolean ok = (f && (f.write(record,size) == size));
+  if( f ) f.close();
+  ok = ok && LittleFS.rename(tmp,_path);
+#else
+  FILE* f = fopen(tmp,"wb");
+  boolean ok = ((f != NULL) && (fwrite(record,1,size,f) == size));
+  if( f != NULL ) ok = (fclose(f) == 0) && ok;
+  ok = ok && (rename(tmp,_path) == 0);
+#endif
+  free(tmp);
+  return ok;
+}
+
+} // End of namespace lsc
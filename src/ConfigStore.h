@@ -0,0 +1,210 @@
+/**
+ * 
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+#ifndef UPNP_CONFIGSTORE_H
+#define UPNP_CONFIGSTORE_H
+
+#include <Arduino.h>
+#include "Parameters.h"
+
+/** Leelanau Software Company namespace 
+*  
+*/
+namespace lsc {
+
+/**
+ *   Configuration store limits, each of which can be overridden at compile time:
+ *     CONFIG_STORE_PATH      := File holding the record; on LittleFS for ESP8266 and ESP32, in the working directory on Linux
+ *     CONFIG_STORE_DELAY     := Milliseconds without a change after which a pending change is written
+ *     CONFIG_STORE_MAX_DELAY := Longest a change waits to be written (ms), however often changes keep coming
+ */
+#ifndef CONFIG_STORE_PATH
+#if defined(ESP32) || defined(ESP8266)
+#define CONFIG_STORE_PATH       "/upnp.cfg"
+#else
+#define CONFIG_STORE_PATH       "upnp.cfg"
+#endif
+#endif
+#ifndef CONFIG_STORE_DELAY
+#define CONFIG_STORE_DELAY      2000
+#endif
+#ifndef CONFIG_STORE_MAX_DELAY
+#define CONFIG_STORE_MAX_DELAY  30000
+#endif
+#define CONFIG_STORE_VERSION    1
+
+class RootDevice;
+class UPnPDevice;
+
+/** ConfigWriter
+ *  Passed to UPnPDevice::saveSettings() to add a device's own settings to its record. Values are strings of up to 255
+ *  characters, stored under the case folded FNV-1a hash of their name (Parameter::hash()). Subclasses override put() to 
+ *  take the settings elsewhere, as ConfigFormatter does to report them and ConfigProbe does to look for one.
+ *    put(name,value)   := Adds a setting; a NULL value is not stored
+ *    put(param,value)  := Adds the setting named by Parameter param, whose type a value set for it must then decode as
+ *    put(hash,value)   := Adds a setting by the hash of its name
+ */
+class ConfigWriter {
+  public:
+    ConfigWriter(uint8_t* buffer, size_t pos) : _buffer(buffer), _pos(pos) {}
+    virtual ~ConfigWriter() {}
+
+    virtual void     put(const char* name, const char* value);
+    virtual void     put(const Parameter& param, const char* value);
+    virtual void     put(uint32_t hash, const char* value);
+    size_t           pos()                         {return _pos;}
+    int              count()                       {return _count;}
+
+/**
+ *   Copy construction and destruction are not allowed
+ */
+    ConfigWriter(const ConfigWriter&)= delete;
+    ConfigWriter& operator=(const ConfigWriter&)= delete;
+
+  protected:
+    ConfigWriter() : _buffer(NULL), _pos(0) {}
+
+  private:
+    uint8_t*         _buffer;                      // NULL while the record is being measured
+    size_t           _pos;
+    int              _count   = 0;
+};
+
+/** ConfigProbe
+ *  A ConfigWriter that stores nothing, and records whether a device puts a setting of the name it is constructed with 
+ *  (compared without case), i.e. whether the device has the setting, and the Parameter describing it if the device gives
+ *  one. A setting put by hash alone is matched by hash.
+ *    found()           := True once a setting of that name has been put
+ *    parameter()       := The Parameter the setting was put with, or NULL
+ */
+class ConfigProbe : public ConfigWriter {
+  public:
+    ConfigProbe(const char* name) : _name(name), _hash(Parameter::hash(name)) {}
+
+    virtual void     put(const char* name, const char* value);
+    virtual void     put(const Parameter& param, const char* value);
+    virtual void     put(uint32_t hash, const char* value);
+    boolean          found()                       {return _found;}
+    const Parameter* parameter()                   {return _parameter;}
+
+  private:
+    const char*      _name;
+    uint32_t         _hash;
+    boolean          _found     = false;
+    const Parameter* _parameter = NULL;
+};
+
+/** ConfigReader
+ *  Passed to UPnPDevice::restoreSettings() with the settings read for the device. 
+ *    get(name)         := The value stored under name, or NULL. Values point into the record and are valid only for the
+ *                         duration of restoreSettings().
+ */
+class ConfigReader {
+  public:
+    ConfigReader(const uint8_t* settings, int count) : _settings(settings), _count(count) {}
+
+    const char*      get(const char* name) const;
+
+/**
+ *   Copy construction and destruction are not allowed
+ */
+    ConfigReader(const ConfigReader&)= delete;
+    ConfigReader& operator=(const ConfigReader&)= delete;
+
+  private:
+    const uint8_t*   _settings;
+    int              _count;
+};
+
+/** ConfigStore class definition
+ *  A ConfigStore keeps the configuration of a RootDevice hierarchy across restarts: for the RootDevice and each embedded 
+ *  device, its target, display name and UUID, and the settings it adds in UPnPDevice::saveSettings(). The whole hierarchy
+ *  is one compact binary record, read with a single read at boot. Writes are debounced: changes are written once none
+ *  has come for CONFIG_STORE_DELAY ms (or CONFIG_STORE_MAX_DELAY ms after the first of them), and a record identical to the 
+ *  one stored is not written at all, so a burst of configuration requests costs one flash write.
+ *
+ *  The record is, in little endian order:
+ *     "UPnC"  CONFIG_STORE_VERSION(1)  devices(1)  body length(2)  CRC-32 of body(4)
+ *  followed by one entry per device, the RootDevice first and then its devices in the order added:
+ *     type hash(4)  UUID(16)  target length(1) target  name length(1) name  settings(1)
+ *  and for each setting:  name hash(4)  value length(1) value '\0'
+ *  An entry is applied only to the device at its position whose UPnP type hashes the same, so a record written by other
+ *  firmware is ignored entry by entry, and a record that does not check (magic, version, length or CRC) is ignored whole.
+ *  The record is written to a temporary file and renamed over the old one, so power lost during a write leaves the old
+ *  record in place.
+ *
+ *  Class members are as follows:
+ *    begin(root,path)     := Mounts the file system (LittleFS on ESP), and restores root from the record at path 
+ *                            (CONFIG_STORE_PATH by default). Call it once devices are added and their defaults set, but before
+ *                            RootDevice::setup(), so that restored targets are registered. Returns true if a record was 
+ *                            restored. The store does nothing until begun.
+ *    changed()            := Notes a configuration change, to be written from run(). SetConfiguration requests call it; call
+ *                            it after changing configuration any other way.
+ *    run(root)            := Writes pending changes once they are due; called from RootDevice::doDevice()
+ *    save(root)           := Writes the record now, unless it is unchanged. Returns false if it could not be written.
+ *    pending()            := True while a change waits to be written
+ *    writes(), skipped()  := Records written, and saves skipped because the record was unchanged
+ *    recordSize()         := Size of the record last read or written
+ */
+class ConfigStore {
+  public:
+    ConfigStore() {}
+    virtual ~ConfigStore()                         {free(_path);}
+
+    boolean          begin(RootDevice* root, const char* path = CONFIG_STORE_PATH);
+    void             changed();
+    void             run(RootDevice* root);
+    boolean          save(RootDevice* root);
+
+    boolean          pending()                     {return _pending;}
+    uint32_t         writes()                      {return _writes;}
+    uint32_t         skipped()                     {return _skipped;}
+    size_t           recordSize()                  {return _size;}
+
+/**
+ *   Copy construction and destruction are not allowed
+ */
+    ConfigStore(const ConfigStore&)= delete;
+    ConfigStore& operator=(const ConfigStore&)= delete;
+
+  private:
+    size_t           serialize(RootDevice* root, uint8_t* buffer);
+    boolean          restore(RootDevice* root, const uint8_t* record, size_t size);
+    boolean          readRecord(uint8_t*& record, size_t& size);
+    boolean          writeRecord(const uint8_t* record, size_t size);
+
+    static uint32_t  typeHash(UPnPDevice* dvc);
+    static uint32_t  crc32(const uint8_t* data, size_t size);
+
+    char*            _path        = NULL;
+    boolean          _pending     = false;
+    unsigned long    _firstChange = 0;
+    unsigned long    _lastChange  = 0;
+    uint32_t         _crc         = 0;
+    size_t           _size        = 0;
+    uint32_t         _writes      = 0;
+    uint32_t         _skipped     = 0;
+};
+
+} // End of namespace lsc
+
+#endif
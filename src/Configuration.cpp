@@ -27,14 +27,21 @@
 */
 namespace lsc {
 
-const char Config_form[]      PROGMEM = "<form action=\"%s\"><div align=\"center\">"                                                                // Form Path
-                                             "<label for=\"displayName\">Device Name &nbsp &nbsp</label>"
-                                             "<input type=\"text\" placeholder=\"%s\" name=\"displayName\"><br><br>"                                // DisplayName
-                                             "<button class=\"fmButton\" type=\"submit\">Submit</button>&nbsp&nbsp"
-                                             "<button class=\"fmButton\" type=\"button\" onclick=\"window.location.href=\'%s\';\">Cancel</button>"  // Cancel path
-                                        "</div></form>";
-   
-const char Config_template[]  PROGMEM = "<?xml version=\"1.0\" encoding=\"UTF-8\"?><config><displayName>%s</displayName></config>";
+PAGE_TEMPLATE(ConfigForm,            "<form action=\"%s\"><div align=\"center\">"                                                                // Form Path
+                                          "<label for=\"displayName\">Device Name &nbsp &nbsp</label>"
+                                          "<input type=\"text\" placeholder=\"%s\" name=\"displayName\"><br><br>"                                // DisplayName
+                                          "<button class=\"fmButton\" type=\"submit\">Submit</button>&nbsp&nbsp"
+                                          "<button class=\"fmButton\" type=\"button\" onclick=\"window.location.href=\'%s\';\">Cancel</button>"  // Cancel path
+                                     "</div></form>");
+ 
+const char Config_head[]      PROGMEM = "<?xml version=\"1.0\" encoding=\"UTF-8\"?><config>";
+const char Config_tail[]      PROGMEM = "</config>";
+
+/**
+ *  The default configuration is the display name; an empty name is ignored
+ */
+struct ConfigArgs {char displayName[NAME_SIZE];};
+const Parameter Config_params[] = {Parameter::text("displayName",offsetof(ConfigArgs,displayName),NAME_SIZE,1)};
 
 INITIALIZE_STATIC_TYPE(GetConfiguration);
 INITIALIZE_STATIC_TYPE(SetConfiguration);
@@ -57,14 +64,10 @@ SetConfiguration::SetConfiguration(const char* target) : UPnPService(target) {
  *  Default handler takes DISPLAYNAME from the argument list and sets it on the parent UPnPDevice.
  */
 void SetConfiguration::defaultHandler(WebContext* svr) {
-  int numArgs = svr->argCount();
   UPnPObject* p = getParent();
   UPnPDevice* d = ((p!=NULL)?(p->asDevice()):(NULL));
-  for( int i=0; i<numArgs; i++) {
-     const String& argName = svr->argName(i);
-     const String& arg = svr->arg(i);
-     if( argName.equalsIgnoreCase("DISPLAYNAME") ) {if( (arg.length() > 0) && (p != NULL ) ) p->setDisplayName(arg.c_str());}
-  }
+  ConfigArgs  args;
+  if( Parameter::isBound(Parameter::bind(svr,Config_params,&args),0) && (p != NULL) ) p->setDisplayName(args.displayName);
   if( d != NULL ) d->display(svr);    
 }
 
@@ -72,34 +75,48 @@ void SetConfiguration::defaultHandler(WebContext* svr) {
  *  This can be included in either RootDevice or UPnPDevice and form path should resolve correctly.
  */
 void SetConfiguration::defaultFormHandler(WebContext* svr) {
-  char buffer[1000];
-  int size = sizeof(buffer);
-  int pos = formatHeader(buffer,size,"Set Display Name");
+  ResponseStream out(svr);
+  out.begin(200,"text/html");
+  out.formatHeader("Set Display Name");
 
-  char parentPath[100];
-  parentPath[0] = '\0';
   UPnPObject* parent = getParent();
-  if( parent != NULL ) parent->getPath(parentPath,100);
-  else sprintf(parentPath,"/%s",getTarget()); 
-  char path[100];
-  getPath(path,100);
+  const char* parentPath = ((parent!=NULL)?(parent->path()):(path()));
 
 /**
  *  path is the url of the form action (HttpHandler), and parentPath is the url of the device for the cancel button
  *  The Config_form takes path, displayName, and parentPath
- *  Note that displayName is that of the parent, which should NOT be NULL.
+ *  Note that displayName is that of the parent, which should NOT be NULL, and is escaped into the placeholder.
  */
   const char* dn = ((parent!=NULL)?(parent->getDisplayName()):(getDisplayName()));
-  pos = formatBuffer_P(buffer,size,pos,Config_form,path,dn,parentPath);
-  formatTail(buffer,size,pos);
-  svr->send(200,"text/html",buffer); 
+  ConfigForm::render(out,path(),dn,parentPath);
+  out.formatTail();
 }
 
 void SetConfiguration::setup(WebContext* svr) {
    UPnPService::setup(svr);
-   char pathBuffer[100];
-   formPath(pathBuffer,100);
-   svr->on(pathBuffer,[this](WebContext* svr){this->_formHandler(svr);});  
+   registerHandler(svr,"configForm");
+}
+
+/**
+ *  A configuration request changes the parent device, and handlers typically display the device once they have 
+ *  applied it, so the parent is marked dirty both before and after the handler runs. Afterwards, subscribers to 
+ *  the device's evented services are notified, and the change is noted for the RootDevice's ConfigStore.
+ */
+boolean SetConfiguration::dispatch(WebContext* svr, const char* handlerName) {
+   if( handlerName[0] == '\0' ) {
+     UPnPObject* p = getParent();
+     UPnPDevice* d = ((p!=NULL)?(p->asDevice()):(NULL));
+     if( p != NULL ) p->markDirty();
+     handleRequest(svr);
+     if( p != NULL ) p->markDirty();
+     for( int i=0; (d != NULL) && (i<d->numServices()); i++ ) d->service(i)->propertiesChanged();
+     RootDevice* root = rootDevice();
+     if( root != NULL ) root->configStore()->changed();
+     return true;
+   }
+   if( strcmp(handlerName,"configForm") != 0 ) return UPnPService::dispatch(svr,handlerName);
+   _formHandler(svr);
+   return true;
 }
 
 void SetConfiguration::formPath(char buffer[], size_t bufferSize) {
@@ -118,12 +135,52 @@ GetConfiguration::GetConfiguration(const char* target) : UPnPService(target) {
 
 void GetConfiguration::defaultHandler(WebContext* svr) {
   UPnPObject* p = getParent();
-  char buffer[1000];
-  size_t bufferSize = sizeof(buffer);
-  int size = bufferSize;
-  if( p != NULL ) snprintf_P(buffer,size,Config_template,p->getDisplayName());
-  else snprintf_P(buffer,size,Config_template,getDisplayName());                     // Service should always have a parent so this should not happen
-  svr->send(200, "text/xml", buffer);
+  sendConfiguration(svr,((p != NULL)?(p):(this)));                                    // Service should always have a parent
+}
+
+/**
+ *  Quality values in Accept are not weighed; the first of the JSON and XML types listed wins
+ */
+boolean GetConfiguration::wantsJson(WebContext* svr) {
+  const String& format = svr->arg("format");
+  if( format.length() > 0 ) return (strcasecmp(format.c_str(),"json") == 0);
+  const String& accept = svr->header("Accept");
+  const char*   json   = strstr(accept.c_str(),"application/json");
+  const char*   xml    = strstr(accept.c_str(),"xml");
+  return (json != NULL) && ((xml == NULL) || (json < xml));
+}
+
+void GetConfiguration::sendConfiguration(WebContext* svr, UPnPObject* obj) {
+  boolean json = wantsJson(svr);
+  svr->sendHeader("Vary","Accept");
+  ResponseStream out(svr);
+  out.begin(200,((json)?("application/json"):("text/xml")));
+  ConfigFormatter config(out,json);
+  config.begin();
+  config.put("displayName",obj->getDisplayName());
+  UPnPDevice* d = obj->asDevice();
+  if( d != NULL ) d->saveSettings(config);
+  config.end();
+}
+
+void ConfigFormatter::begin() {
+  if( _isJson ) _json.beginObject();
+  else          _out.print_P(Config_head);
+}
+
+void ConfigFormatter::end() {
+  if( _isJson ) _json.endObject();
+  else          _out.print_P(Config_tail);
+}
+
+void ConfigFormatter::put(const char* name, const char* value) {
+  if( (name == NULL) || (value == NULL) ) return;
+  if( _isJson ) _json.member(name,value);
+  else {
+    _out.printf_P(PSTR("<%s>"),name);
+    _out.printEscaped(value);
+    _out.printf_P(PSTR("</%s>"),name);
+  }
 }
 
 } // End of namespace lsc
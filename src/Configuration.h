@@ -47,6 +47,7 @@ class SetConfiguration : public UPnPService {
     void defaultFormHandler(WebContext* svr);
     void formPath(char buffer[],size_t size);
     void setup(WebContext* svr);
+    boolean dispatch(WebContext* svr, const char* handlerName);
     
 /**
  *   Macros to define the following Runtime and UPnP Type Info:
@@ -71,6 +72,37 @@ class SetConfiguration : public UPnPService {
 
 };
 
+/** ConfigFormatter
+ *  A ConfigWriter that streams each setting put to it as a member of a JSON object or an element of an XML <config>
+ *  document, so that the settings a device saves for its ConfigStore are also the settings it reports. A setting put
+ *  by hash alone has no name to report it under, and is left out; put settings by name or Parameter to report them.
+ *    begin()/end()       := Write the start/end of the document
+ */
+class ConfigFormatter : public ConfigWriter {
+    public:
+    ConfigFormatter(ResponseStream& out, boolean json) : _out(out), _json(out), _isJson(json) {}
+
+    void         begin();
+    void         end();
+    using        ConfigWriter::put;
+    virtual void put(const char* name, const char* value);
+    virtual void put(uint32_t hash, const char* value)     {}
+
+    private:
+    ResponseStream&   _out;
+    JsonWriter        _json;
+    boolean           _isJson;
+};
+
+/**
+ *   GetConfiguration responds with the display name of its parent device followed by the settings the device saves in
+ *   saveSettings(), as XML (<config><displayName>...</displayName>...</config>) or as JSON ({"displayName":"...",...}).
+ *   The response is streamed, so it is not limited in size. The request is not authenticated: every setting a device saves,
+ *   and so keeps in its ConfigStore, is readable by anyone who can reach the device, so do not save secrets as settings.
+ *     wantsJson(svr)           := True if the request asks for JSON: a format=json argument, or an Accept header that lists 
+ *                                 application/json ahead of any XML type. format=xml, or neither, means XML.
+ *     sendConfiguration(svr,o) := Responds with the configuration of Object o in the format the request asks for
+ */
 class GetConfiguration : public UPnPService {
     public:
     GetConfiguration();
@@ -78,6 +110,9 @@ class GetConfiguration : public UPnPService {
 
     void defaultHandler(WebContext* svr);
 
+    static boolean wantsJson(WebContext* svr);
+    static void    sendConfiguration(WebContext* svr, UPnPObject* obj);
+
 /**
  *   Macros to define the following Runtime and UPnP Type Info:
  *     private: static const ClassType  _classType;             
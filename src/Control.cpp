@@ -22,14 +22,6 @@
 
 #include "Control.h"
 
-const char Control_config_template[]  PROGMEM = "<?xml version=\"1.0\" encoding=\"UTF-8\"?><config><displayName>%s</displayName></config>";
-const char Control_config_form[]      PROGMEM = "<form action=\"setConfiguration\"><div align=\"center\">"
-                                                   "<label for=\"displayName\">Control Name &nbsp &nbsp</label>"
-                                                   "<input type=\"text\" placeholder=\"%s\" name=\"displayName\"><br><br>"
-                                                   "<button class=\"fmButton\" type=\"submit\">Submit</button>&nbsp&nbsp"
-                                                   "<a style=\"text-decoration:none\" href=\"/%s/%s\"><button class=\"fmButton\" type=\"button\">Cancel</button></a>"
-                                                "</div></form>";
-
 namespace lsc {
 /**
  *  Static initialization for RTT and UPnP device type
@@ -39,54 +31,71 @@ INITIALIZE_UPnP_TYPE(Control,urn:LeelanauSoftware-com:device:Control:1);
 
 Control::Control() : UPnPDevice("control") {
   addServices(getConfiguration(),setConfiguration());   // Add services for configuration
+  eventDisplayName(getConfiguration());                 // Subscribers are told of display name changes
   setDisplayName("Control");
 }
 
 Control::Control(const char* target) : UPnPDevice(target) {
   addServices(getConfiguration(),setConfiguration());   // Add services for configuration
+  eventDisplayName(getConfiguration());                 // Subscribers are told of display name changes
   setDisplayName("Control");
 }
 
 void Control::display(WebContext* svr) {
-  char buffer[500];
-  int size = sizeof(buffer);
-  int pos = formatHeader(buffer,size,getDisplayName());
+  ResponseStream out(svr);
+  out.begin(200,"text/html");
+  out.formatHeader(getDisplayName());
   char pathBuff[100];
   contentPath(pathBuff,100);
   
 /**
  *   iFrame display takes url, height, and width as arguments
  */
-  pos = formatBuffer_P(buffer,size,pos,iframe_html,pathBuff,frameHeight(),frameWidth());
+  IFrame::render(out,pathBuff,frameHeight(),frameWidth());
 
 /** 
  *  Add a Config Button to the Control display
  */
   setConfiguration()->formPath(pathBuff,100);
-  pos = formatBuffer_P(buffer,size,pos,config_button,pathBuff,"Configure"); 
-  formatTail(buffer,size,pos);
-  svr->send(200,"text/html",buffer);
+  ConfigButton::render(out,pathBuff,"Configure"); 
+  RootDevice* root = rootDevice();
+  if( root != NULL ) EventStream::formatScript(out,root);
+  out.formatTail();
+}
+
+void Control::content(ResponseStream& out) {
+  int   size;
+  char* buffer = out.reserve(size);
+  content(buffer,size);
+  out.commit();
+}
+
+void Control::renderContent(ResponseStream& out) {
+  _renderCache.write(out,stateVersion()+hierarchyVersion(),[this](ResponseStream& s){this->content(s);});
 }
 
 /**
- *   Provide iFrame content
+ *   Provide iFrame content, in an element the display page's event stream can redraw
  */
 void Control::displayControl(WebContext* svr) {
-  char buffer[1000];
-  int size = sizeof(buffer);
-  int pos = 0;
-  pos = formatBuffer_P(buffer,size,pos,html_header);
-  content(buffer+pos,size-pos);
-  pos = strlen(buffer);
-  pos = formatTail(buffer,size,pos); 
-  svr->send(200,"text/html",buffer);
+  ResponseStream out(svr);
+  out.begin(200,"text/html");
+  out.print_P(html_header);
+  EventStream::beginFragment(out,this);
+  renderContent(out);
+  EventStream::endFragment(out);
+  out.formatTail();
 }
 
 void Control::setup(WebContext* svr) {
   UPnPDevice::setup(svr);
-  char pathBuff[100];
-  contentPath(pathBuff,100);
-  svr->on(pathBuff,[this](WebContext* svr){this->displayControl(svr);});
+  registerHandler(svr,"displayControl");
+}
+
+boolean Control::dispatch(WebContext* svr, const char* handlerName) {
+  if( strcmp(handlerName,"displayControl") != 0 ) return UPnPDevice::dispatch(svr,handlerName);
+  displayControl(svr);
+  return true;
 }
 
 void Control::contentPath(char buffer[], size_t size) {handlerPath(buffer,size,"displayControl");}
@@ -75,8 +75,17 @@ class Control : public UPnPDevice  {
  *    frameHeight()                            := Height of iFrame (defaults to 75)
  *    frameWidth()                             := Width of iFrame (defaults to 300);
  *    
+ *  Controls with large content may also implement content(ResponseStream& out), which writes directly into the
+ *  response. The default renders content(buffer,buffSize) into a block of at most STREAM_BUFFER_SIZE bytes.
+ *
+ *  Content can be cached: after setRenderCache(true), renderContent() serves the bytes of the last content() call until 
+ *  stateVersion() changes (on setDisplayName(), a SetConfiguration request, or markDirty()) or the hierarchy changes. 
+ *  Controls that enable the cache must call markDirty() whenever anything content() renders changes.
  */
       virtual void       content(char buffer[], int buffSize) = 0;
+      virtual void       content(ResponseStream& out);
+      void               renderContent(ResponseStream& out);
+      void               setRenderCache(boolean flag)       {_renderCache.setEnabled(flag);}
       virtual int        frameHeight()      {return 75;}
       virtual int        frameWidth()       {return 300;}
       
@@ -85,6 +94,7 @@ class Control : public UPnPDevice  {
       
       void               display(WebContext* svr);
       void               setup(WebContext* svr);
+      virtual boolean    dispatch(WebContext* svr, const char* handlerName);
 
 /**
  *   Display Control content, intended for the endpoint of an iFrame link and
@@ -114,6 +124,7 @@ class Control : public UPnPDevice  {
       private:
       GetConfiguration     _getConfiguration;
       SetConfiguration     _setConfiguration;
+      RenderCache          _renderCache;
 };
 
 } // End of namespace lsc
@@ -0,0 +1,438 @@
+/**
+ * 
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+#include "Eventing.h"
+#include "UPnPDevice.h"
+#include "SensorDevice.h"
+#include "Control.h"
+
+const char event_body_head[]  PROGMEM = "<?xml version=\"1.0\"?>\r\n<e:propertyset xmlns:e=\"urn:schemas-upnp-org:event-1-0\">";
+const char event_body_tail[]  PROGMEM = "</e:propertyset>\r\n";
+const char notify_header[]    PROGMEM = "NOTIFY %s HTTP/1.1\r\nHOST: %s:%u\r\nCONTENT-TYPE: text/xml; charset=\"utf-8\"\r\n"
+                                        "NT: upnp:event\r\nNTS: upnp:propchange\r\nSID: %s\r\nSEQ: %lu\r\nCONTENT-LENGTH: %u\r\n"
+                                        "CONNECTION: close\r\n\r\n";
+const char stream_header[]    PROGMEM = "HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\nCache-Control: no-cache\r\n"
+                                        "Connection: keep-alive\r\n\r\nretry: 3000\n\n";
+const char content_event[]    PROGMEM = "event: content\ndata: ";
+PAGE_TEMPLATE(FragmentHead,     "<div id=\"%s\">");
+const char fragment_tail[]    PROGMEM = "</div>";
+
+/**
+ *  Opens the event stream of a RootDevice and replaces the element named by each event, in the page or any of its iFrames.
+ *  The stream is kept on window.upnpEvents, so content in an iFrame can tell whether its page is receiving events. The
+ *  root path is written between head and tail as a JSON string, which is escaped for use inside the script.
+ */
+const char event_script_head[] PROGMEM = "<script>(function(){if(!window.EventSource)return;"
+                                         "var s=window.upnpEvents=new EventSource(";
+const char event_script_tail[] PROGMEM = "+'/events');"
+                                         "s.addEventListener('content',function(e){"
+                                           "var i=e.data.indexOf('\\n'),id=e.data.substring(0,i),h=e.data.substring(i+1);"
+                                           "var d=[document],f=document.getElementsByTagName('iframe');"
+                                           "for(var k=0;k<f.length;k++){try{d.push(f[k].contentDocument);}catch(x){}}"
+                                           "for(var k=0;k<d.length;k++){var n=d[k]&&d[k].getElementById(id);if(n)n.innerHTML=h;}"
+                                         "});})();</script>";
+
+/** Leelanau Software Company namespace 
+*  
+*/
+namespace lsc {
+
+EventPublisher::~EventPublisher() {
+  for( int i=0; (_subscriptions != NULL) && (i<MAX_SUBSCRIPTIONS); i++ ) drop(_subscriptions[i]);
+  free(_subscriptions);
+  free(_body);
+}
+
+/**
+ *  New subscriptions carry NT and CALLBACK, renewals and UNSUBSCRIBE carry only SID
+ */
+void EventPublisher::handleRequest(WebContext* svr, UPnPService* svc) {
+  boolean hasSID = svr->hasHeader("SID");
+  boolean isNew  = svr->hasHeader("NT") || svr->hasHeader("CALLBACK");
+#ifdef ESP8266
+  boolean isSubscribe   = isNew || svr->hasHeader("TIMEOUT");
+  boolean isUnsubscribe = hasSID && !isSubscribe;
+#else
+  boolean isSubscribe   = (svr->method() == HTTP_SUBSCRIBE);
+  boolean isUnsubscribe = (svr->method() == HTTP_UNSUBSCRIBE);
+#endif
+  if( isNew && hasSID )      svr->send(400,TEXT_PLAIN,"Incompatible header fields");
+  else if( isUnsubscribe )   unsubscribe(svr,svc);
+  else if( !isSubscribe )    svr->send(405,TEXT_PLAIN,"Method Not Allowed");
+  else if( hasSID )          renew(svr,svc);
+  else                       subscribe(svr,svc);
+}
+
+/**
+ *  CALLBACK is one or more URLs, each in angle brackets; the first http URL is used
+ */
+void EventPublisher::subscribe(WebContext* svr, UPnPService* svc) {
+  const char* callback = strstr(svr->header("CALLBACK").c_str(),"<http://");
+  const char* end      = ((callback != NULL)?(strchr(callback,'>')):(NULL));
+  if( !svr->header("NT").equals("upnp:event") || (end == NULL) || (end-callback-1 >= CALLBACK_SIZE) ) {
+    svr->send(412,TEXT_PLAIN,"Precondition Failed");
+    return;
+  }
+  if( _subscriptions == NULL ) _subscriptions = (Subscription*)calloc(MAX_SUBSCRIPTIONS,sizeof(Subscription));
+  Subscription* s = NULL;
+  for( int i=0; (_subscriptions != NULL) && (i<MAX_SUBSCRIPTIONS) && (s == NULL); i++ ) {if( _subscriptions[i].service == NULL ) s = &_subscriptions[i];}
+  if( s == NULL ) {
+    svr->send(503,TEXT_PLAIN,"Too many subscriptions");
+    return;
+  }
+  UUID id;
+  id.random();
+  memcpy(s->sid,"uuid:",5);
+  id.format(s->sid+5);
+  memcpy(s->callback,callback+1,end-callback-1);
+  s->callback[end-callback-1] = '\0';
+  s->service     = svc;
+  s->expires     = millis() + timeout(svr)*1000;
+  s->seq         = 0;
+  s->sentVersion = 0;
+  s->failures    = 0;
+  sendSubscribed(svr,*s);
+}
+
+void EventPublisher::renew(WebContext* svr, UPnPService* svc) {
+  Subscription* s = find(svr->header("SID").c_str(),svc);
+  if( s == NULL ) {
+    svr->send(412,TEXT_PLAIN,"Precondition Failed");
+    return;
+  }
+  s->expires = millis() + timeout(svr)*1000;
+  sendSubscribed(svr,*s);
+}
+
+void EventPublisher::unsubscribe(WebContext* svr, UPnPService* svc) {
+  Subscription* s = find(svr->header("SID").c_str(),svc);
+  if( s == NULL ) {
+    svr->send(412,TEXT_PLAIN,"Precondition Failed");
+    return;
+  }
+  drop(*s);
+  svr->send(200,TEXT_PLAIN,"");
+}
+
+void EventPublisher::sendSubscribed(WebContext* svr, Subscription& s) {
+  char t[32];
+  snprintf(t,sizeof(t),"Second-%ld",(long)((s.expires - millis() + 500)/1000));
+  svr->sendHeader("SID",s.sid);
+  svr->sendHeader("TIMEOUT",t);
+  svr->sendHeader("SERVER","Arduino/1.0 UPnP/1.0 UPnPDevice/1.0");
+  svr->send(200,TEXT_PLAIN,"");
+}
+
+/**
+ *  TIMEOUT is "Second-n" or "Second-infinite"; missing, infinite and long timeouts are all capped at MAX_EVENT_TIMEOUT
+ */
+long EventPublisher::timeout(WebContext* svr) {
+  const char* t = svr->header("TIMEOUT").c_str();
+  long        n = MAX_EVENT_TIMEOUT;
+  if( strncasecmp(t,"Second-",7) == 0 && isdigit(t[7]) ) n = atol(t+7);
+  return (((n > 0) && (n < MAX_EVENT_TIMEOUT))?(n):(MAX_EVENT_TIMEOUT));
+}
+
+EventPublisher::Subscription* EventPublisher::find(const char* sid, UPnPService* svc) {
+  for( int i=0; (_subscriptions != NULL) && (i<MAX_SUBSCRIPTIONS); i++ ) {
+    Subscription& s = _subscriptions[i];
+    if( (s.service == svc) && (svc != NULL) && (strcmp(s.sid,sid) == 0) ) return &s;
+  }
+  return NULL;
+}
+
+int EventPublisher::numSubscriptions(UPnPService* svc) {
+  int count = 0;
+  for( int i=0; (_subscriptions != NULL) && (i<MAX_SUBSCRIPTIONS); i++ ) {
+    if( (_subscriptions[i].service != NULL) && ((svc == NULL) || (_subscriptions[i].service == svc)) ) count++;
+  }
+  return count;
+}
+
+void EventPublisher::remove(UPnPService* svc) {
+  for( int i=0; (_subscriptions != NULL) && (i<MAX_SUBSCRIPTIONS); i++ ) {if( _subscriptions[i].service == svc ) drop(_subscriptions[i]);}
+  if( _bodyService == svc ) _bodyService = NULL;
+}
+
+/**
+ *  A subscription is pending until the current eventVersion() of its service has been delivered
+ */
+boolean EventPublisher::isPending(Subscription& s) {return (s.service != NULL) && (s.sentVersion != s.service->eventVersion());}
+
+boolean EventPublisher::pending() {
+  for( int i=0; (_subscriptions != NULL) && (i<MAX_SUBSCRIPTIONS); i++ ) {if( isPending(_subscriptions[i]) ) return true;}
+  return false;
+}
+
+/**
+ *  Subscriptions are visited round robin from where the last call stopped, so no subscriber is starved when more than 
+ *  NOTIFY_PER_LOOP are pending. A subscription with a NOTIFY awaiting its reply is not sent another until the reply is in.
+ */
+void EventPublisher::publish() {
+  if( _subscriptions == NULL ) return;
+  unsigned long now  = millis();
+  int           sent = 0;
+  for( int i=0; i<MAX_SUBSCRIPTIONS; i++ ) {if( _subscriptions[i].client != NULL ) poll(_subscriptions[i]);}
+  for( int n=0; (n<MAX_SUBSCRIPTIONS) && (sent<NOTIFY_PER_LOOP); n++ ) {
+    Subscription& s = _subscriptions[_next];
+    _next = (_next+1)%MAX_SUBSCRIPTIONS;
+    if( s.service == NULL ) continue;
+    if( (long)(now - s.expires) >= 0 ) {drop(s); continue;}
+    if( (s.client != NULL) || !isPending(s) ) continue;
+    sent++;
+    notify(s);
+  }
+}
+
+/**
+ *  Frees a subscription, closing any NOTIFY still awaiting its reply
+ */
+void EventPublisher::drop(Subscription& s) {
+  if( s.client != NULL ) {
+    s.client->stop();
+    delete s.client;
+    s.client = NULL;
+  }
+  s.service = NULL;
+}
+
+void EventPublisher::failed(Subscription& s) {if( ++s.failures >= MAX_EVENT_FAILURES ) drop(s);}
+
+/**
+ *  The body for a service is rendered into a heap buffer once per eventVersion() and shared by all of its subscribers
+ */
+boolean EventPublisher::renderBody(UPnPService* svc) {
+  if( (_body != NULL) && (_bodyService == svc) && (_bodyVersion == svc->eventVersion()) ) return true;
+  _bodyService = NULL;
+  _bodyLength  = 0;
+  boolean failed = false;
+  {
+    ResponseStream out([this,&failed](const char* data, size_t len) {
+      if( failed ) return;
+      char* b = (char*)realloc(_body,_bodyLength+len);
+      if( b == NULL ) {failed = true; return;}
+      memcpy(b+_bodyLength,data,len);
+      _body        = b;
+      _bodyLength += len;
+    });
+    out.print_P(event_body_head);
+    svc->formatProperties(out);
+    out.print_P(event_body_tail);
+  }
+  if( failed ) return false;
+  _bodyService = svc;
+  _bodyVersion = svc->eventVersion();
+  return true;
+}
+
+/**
+ *  Callback is http://host[:port][/path]. The NOTIFY is written and the connection kept for poll() to read the reply; a 
+ *  subscriber whose callback cannot be connected to is dropped at once rather than retried.
+ */
+void EventPublisher::notify(Subscription& s) {
+  if( !renderBody(s.service) ) {failed(s); return;}
+  char        host[64];
+  const char* h    = s.callback + 7;
+  size_t      len  = strcspn(h,":/");
+  uint16_t    port = 80;
+  if( len >= sizeof(host) ) {drop(s); return;}
+  memcpy(host,h,len);
+  host[len] = '\0';
+  h += len;
+  if( *h == ':' ) port = (uint16_t)strtoul(h+1,(char**)&h,10);
+  const char* path = ((*h == '/')?(h):("/"));
+
+  char header[CALLBACK_SIZE+320];
+  int  size = snprintf_P(header,sizeof(header),notify_header,path,host,(unsigned int)port,s.sid,(unsigned long)s.seq,(unsigned int)_bodyLength);
+  if( (size <= 0) || (size >= (int)sizeof(header)) ) {drop(s); return;}
+
+  WiFiClient* client = new WiFiClient();
+  client->setTimeout(NOTIFY_TIMEOUT);
+  if( !client->connect(host,port) ) {
+    delete client;
+    drop(s);
+    return;
+  }
+  if( (client->write((const uint8_t*)header,size) != (size_t)size) || (client->write((const uint8_t*)_body,_bodyLength) != _bodyLength) ) {
+    client->stop();
+    delete client;
+    failed(s);
+    return;
+  }
+  s.client         = client;
+  s.sentAt         = millis();
+  s.sendingVersion = s.service->eventVersion();
+}
+
+/**
+ *  Delivery succeeds when the subscriber replies with a 2xx status line. It fails when the reply is anything else, when the
+ *  connection closes first, or after NOTIFY_TIMEOUT ms; nothing is read until the status code has arrived.
+ */
+void EventPublisher::poll(Subscription& s) {
+  const int   STATUS_SIZE = 12;                                       // "HTTP/1.1 200"
+  char        status[STATUS_SIZE];
+  WiFiClient* client = s.client;
+  int         n      = client->available();
+  if( (n < STATUS_SIZE) && client->connected() && (millis()-s.sentAt < NOTIFY_TIMEOUT) ) return;
+  n = ((n >= STATUS_SIZE)?(client->read((uint8_t*)status,STATUS_SIZE)):(0));
+  client->stop();
+  delete client;
+  s.client = NULL;
+  if( (n == STATUS_SIZE) && (strncmp(status,"HTTP/1.",7) == 0) && (status[9] == '2') ) {
+    s.sentVersion = s.sendingVersion;
+    s.failures    = 0;
+    if( ++s.seq == 0 ) s.seq = 1;                                     // SEQ wraps to 1; 0 is only for the initial event
+  }
+  else failed(s);
+}
+
+EventStream::~EventStream() {
+  for( int i=0; i<MAX_EVENT_STREAMS; i++ ) delete _streams[i];
+  free(_versions);
+}
+
+/**
+ *  The response header is written straight to the connection, which is then kept rather than closed by the Web server
+ */
+void EventStream::handleRequest(WebContext* svr, RootDevice* root) {
+  int slot = -1;
+  numStreams();
+  for( int i=0; (i<MAX_EVENT_STREAMS) && (slot < 0); i++ ) {if( _streams[i] == NULL ) slot = i;}
+  if( slot < 0 ) {
+    svr->send(503,TEXT_PLAIN,"Too many event streams");
+    return;
+  }
+  char        header[sizeof(stream_header)];
+  WiFiClient* client = new WiFiClient(svr->client());
+  strcpy_P(header,stream_header);
+  if( client->write((const uint8_t*)header,strlen(header)) != strlen(header) ) {
+    client->stop();
+    delete client;
+    return;
+  }
+  track(root);
+  _streams[slot] = client;
+  _lastSent      = millis();
+}
+
+/**
+ *  Sizes the version table to the devices of root. Devices not yet tracked, and all devices when no browser is connected
+ *  (versions are not followed then), start from their current version, so only later changes are streamed. Returns false 
+ *  if memory is exhausted.
+ */
+boolean EventStream::track(RootDevice* root) {
+  int n = root->numDevices();
+  if( n != _numVersions ) {
+    uint32_t* versions = (uint32_t*)realloc(_versions,n*sizeof(uint32_t));
+    if( versions == NULL ) return false;
+    for( int i=_numVersions; i<n; i++ ) versions[i] = root->device(i)->stateVersion();
+    _versions    = versions;
+    _numVersions = n;
+  }
+  if( numStreams() == 0 ) {
+    for( int i=0; i<n; i++ ) _versions[i] = root->device(i)->stateVersion();
+  }
+  return true;
+}
+
+/**
+ *  Nothing is compared while no browser is connected, so an idle stream costs a loop only a check of its connections
+ */
+void EventStream::publish(RootDevice* root) {
+  int n = root->numDevices();
+  if( (n == 0) || (numStreams() == 0) || !track(root) ) return;
+  for( int i=0; i<n; i++ ) {
+    UPnPDevice* d = root->device(i);
+    uint32_t    v = d->stateVersion();
+    if( v == _versions[i] ) continue;
+    _versions[i] = v;
+    sendContent(d);
+  }
+  if( millis()-_lastSent >= EVENT_KEEPALIVE ) send(": keep-alive\n\n",14);
+}
+
+/**
+ *  Drops streams whose browser has gone
+ */
+int EventStream::numStreams() {
+  int result = 0;
+  for( int i=0; i<MAX_EVENT_STREAMS; i++ ) {
+    if( (_streams[i] != NULL) && !_streams[i]->connected() ) {
+      delete _streams[i];
+      _streams[i] = NULL;
+    }
+    if( _streams[i] != NULL ) result++;
+  }
+  return result;
+}
+
+/**
+ *  Writes to every stream, dropping any the write fails on
+ */
+void EventStream::send(const char* data, size_t len) {
+  if( len == 0 ) return;
+  for( int i=0; i<MAX_EVENT_STREAMS; i++ ) {
+    if( (_streams[i] == NULL) || (_streams[i]->write((const uint8_t*)data,len) == len) ) continue;
+    _streams[i]->stop();
+    delete _streams[i];
+    _streams[i] = NULL;
+  }
+  _lastSent = millis();
+}
+
+/**
+ *  Content is rendered once, through a ResponseStream whose output is split into data: lines as it is written
+ */
+void EventStream::sendContent(UPnPDevice* dvc) {
+  Sensor*  s = (Sensor*)dvc->as(Sensor::classType());
+  Control* c = ((s == NULL)?((Control*)dvc->as(Control::classType())):(NULL));
+  if( (s == NULL) && (c == NULL) ) return;
+  char head[sizeof(content_event)];
+  strcpy_P(head,content_event);
+  send(head,strlen(head));
+  send(dvc->path(),strlen(dvc->path()));
+  send("\ndata: ",7);
+  ResponseStream out([this](const char* data, size_t len) {
+    size_t start = 0;
+    for( size_t i=0; i<len; i++ ) {
+      if( (data[i] != '\n') && (data[i] != '\r') ) continue;
+      send(data+start,i-start);
+      if( data[i] == '\n' ) send("\ndata: ",7);
+      start = i+1;
+    }
+    send(data+start,len-start);
+  });
+  if( s != NULL ) s->renderContent(out);
+  else            c->renderContent(out);
+  out.end();
+  send("\n\n",2);
+}
+
+void EventStream::beginFragment(ResponseStream& out, UPnPDevice* dvc) {FragmentHead::render(out,dvc->path());}
+void EventStream::endFragment(ResponseStream& out)                    {out.print_P(fragment_tail);}
+void EventStream::formatScript(ResponseStream& out, RootDevice* root) {
+  out.print_P(event_script_head);
+  out.printJson(root->path());
+  out.print_P(event_script_tail);
+}
+
+} // End of namespace lsc
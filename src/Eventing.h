@@ -0,0 +1,210 @@
+/**
+ * 
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+#ifndef UPNP_EVENTING_H
+#define UPNP_EVENTING_H
+
+#include <Arduino.h>
+#include <WebContext.h>
+#include <WiFiClient.h>
+#include "UUID.h"
+
+/** Leelanau Software Company namespace 
+*  
+*/
+namespace lsc {
+
+/**
+ *   GENA eventing limits, each of which can be overridden at compile time:
+ *     MAX_SUBSCRIPTIONS   := Subscriptions held by a RootDevice, across all of its services
+ *     CALLBACK_SIZE       := Longest callback URL accepted
+ *     MAX_EVENT_TIMEOUT   := Longest subscription (seconds) granted; longer or infinite requests are capped to it
+ *     NOTIFY_PER_LOOP     := NOTIFY messages sent per call to publish(), bounding the time spent in the Arduino loop()
+ *     NOTIFY_TIMEOUT      := Milliseconds allowed to connect to a subscriber and for its reply
+ *     MAX_EVENT_FAILURES  := Consecutive failed deliveries after which a subscription is dropped
+ */
+#ifndef MAX_SUBSCRIPTIONS
+#define MAX_SUBSCRIPTIONS  8
+#endif
+#ifndef CALLBACK_SIZE
+#define CALLBACK_SIZE      128
+#endif
+#ifndef MAX_EVENT_TIMEOUT
+#define MAX_EVENT_TIMEOUT  1800
+#endif
+#ifndef NOTIFY_PER_LOOP
+#define NOTIFY_PER_LOOP    2
+#endif
+#ifndef NOTIFY_TIMEOUT
+#define NOTIFY_TIMEOUT     500
+#endif
+#define MAX_EVENT_FAILURES 3
+#define SID_SIZE           (UUID_SIZE+5)
+
+/**
+ *   Server-Sent Events limits, either of which can be overridden at compile time:
+ *     MAX_EVENT_STREAMS   := Browsers a RootDevice streams to at once; each holds a connection open
+ *     EVENT_KEEPALIVE     := Milliseconds of silence after which a comment is sent, so closed connections are noticed
+ */
+#ifndef MAX_EVENT_STREAMS
+#define MAX_EVENT_STREAMS  4
+#endif
+#ifndef EVENT_KEEPALIVE
+#define EVENT_KEEPALIVE    15000
+#endif
+
+class UPnPService;
+class UPnPDevice;
+class RootDevice;
+class ResponseStream;
+
+/** EventPublisher class definition
+ *  An EventPublisher implements UPnP (GENA) eventing for the services of a RootDevice. Control points SUBSCRIBE to the event
+ *  URL of a service (/rootTarget/deviceTarget/serviceTarget/event) with a callback URL, and are then sent a NOTIFY message with 
+ *  the service's evented properties: once on subscription, and after every change. Changes are only recorded when they happen
+ *  (see UPnPService::propertiesChanged()); messages are sent later from the Arduino loop() by publish(), so any number of changes 
+ *  between calls are delivered as a single NOTIFY with the current values, and a message body is rendered once per change for 
+ *  all subscribers of a service. Delivery does not wait for a subscriber: publish() connects and writes a NOTIFY, and the 
+ *  reply is checked by later calls, so a slow or silent subscriber costs the loop only its connect.
+ *  Class members are as follows:
+ *    handleRequest(svr,svc)  := Handles SUBSCRIBE (new or renewal) and UNSUBSCRIBE requests to the event URL of svc
+ *    publish()               := Checks the replies to NOTIFY messages already sent, drops expired subscriptions and sends up
+ *                               to NOTIFY_PER_LOOP pending NOTIFY messages. Called from RootDevice::doDevice().
+ *    numSubscriptions(svc)   := Number of subscriptions to svc, or to all services when svc is NULL
+ *    pending()               := True if NOTIFY messages are waiting to be sent or for a reply
+ *    remove(svc)             := Drops all subscriptions to svc
+ *
+ *  The subscription table (MAX_SUBSCRIPTIONS entries) is allocated on the first subscription. A subscription is dropped when
+ *  its callback cannot be connected to, or after MAX_EVENT_FAILURES deliveries in a row are refused or time out. ESP8266WebServer reports SUBSCRIBE 
+ *  and UNSUBSCRIBE as GET, so on ESP8266 requests are told apart by their headers: a request with SID but neither NT, CALLBACK 
+ *  nor TIMEOUT is taken to be UNSUBSCRIBE.
+ */
+class EventPublisher {
+  public:
+    EventPublisher() {}
+    ~EventPublisher();
+
+    void              handleRequest(WebContext* svr, UPnPService* svc);
+    void              publish();
+    int               numSubscriptions(UPnPService* svc = NULL);
+    boolean           pending();
+    void              remove(UPnPService* svc);
+
+/**
+ *   Copy construction and destruction are not allowed
+ */
+    EventPublisher(const EventPublisher&)= delete;
+    EventPublisher& operator=(const EventPublisher&)= delete;
+
+  private:
+    struct Subscription {
+      UPnPService*    service;                   // NULL for a free entry
+      char            sid[SID_SIZE];
+      char            callback[CALLBACK_SIZE];
+      unsigned long   expires;                   // millis()
+      uint32_t        seq;
+      uint32_t        sentVersion;               // Service eventVersion() last delivered, 0 before the initial event
+      uint8_t         failures;
+      WiFiClient*     client;                    // Connection of a NOTIFY awaiting its reply, or NULL
+      unsigned long   sentAt;                    // millis() the NOTIFY was sent
+      uint32_t        sendingVersion;            // eventVersion() the NOTIFY carries
+    };
+
+    void              subscribe(WebContext* svr, UPnPService* svc);
+    void              renew(WebContext* svr, UPnPService* svc);
+    void              unsubscribe(WebContext* svr, UPnPService* svc);
+    Subscription*     find(const char* sid, UPnPService* svc);
+    boolean           isPending(Subscription& s);
+    void              notify(Subscription& s);
+    void              poll(Subscription& s);
+    void              drop(Subscription& s);
+    void              failed(Subscription& s);
+    boolean           renderBody(UPnPService* svc);
+    static void       sendSubscribed(WebContext* svr, Subscription& s);
+    static long       timeout(WebContext* svr);
+
+    Subscription*     _subscriptions = NULL;
+    int               _next          = 0;
+    char*             _body          = NULL;
+    size_t            _bodyLength    = 0;
+    UPnPService*      _bodyService   = NULL;
+    uint32_t          _bodyVersion   = 0;
+};
+
+/** EventStream class definition
+ *  An EventStream pushes changes to the Sensors and Controls of a RootDevice to browsers, as Server-Sent Events on
+ *  /rootTarget/events. Pages rendered by the library wrap each Sensor and Control content in an element whose id is the 
+ *  device path, and include a short script (formatScript()) that opens the stream and replaces the content of the element
+ *  named by an event, in the page itself or in any of its iFrames. Only the changed fragment is sent and redrawn, rather 
+ *  than a page or iFrame reloading. Each event is:
+ *      event: content
+ *      data: /rootTarget/deviceTarget
+ *      data: <device content, one data: line per line>
+ *  Changes are found from the loop: publish() compares each device's stateVersion() with the version last streamed, so a
+ *  device only needs to call markDirty() when its content changes, as it already must for the render cache, and any number
+ *  of changes between calls are sent as one event with the current content, rendered once for all browsers.
+ *  Class members are as follows:
+ *    handleRequest(svr,root) := Takes the connection of an event stream request for root and keeps it, or responds 503 
+ *                               when MAX_EVENT_STREAMS browsers are already connected
+ *    publish(root)           := Streams the content of devices of root that changed since the last call, and a keep-alive
+ *                               comment after EVENT_KEEPALIVE ms of silence. Called from RootDevice::doDevice().
+ *    numStreams()            := Number of connected browsers
+ *    beginFragment(out,dvc)  := Opens the element holding the content of dvc
+ *    endFragment(out)        := Closes it
+ *    formatScript(out,root)  := Writes the client script for the event stream of root
+ *
+ *  The connections are taken from the Web server (WebContext::client()), which lets go of a connection once a request is
+ *  handled, and are dropped when a write to them fails.
+ */
+class EventStream {
+  public:
+    EventStream() {}
+    ~EventStream();
+
+    void              handleRequest(WebContext* svr, RootDevice* root);
+    void              publish(RootDevice* root);
+    int               numStreams();
+
+    static void       beginFragment(ResponseStream& out, UPnPDevice* dvc);
+    static void       endFragment(ResponseStream& out);
+    static void       formatScript(ResponseStream& out, RootDevice* root);
+
+/**
+ *   Copy construction and destruction are not allowed
+ */
+    EventStream(const EventStream&)= delete;
+    EventStream& operator=(const EventStream&)= delete;
+
+  private:
+    boolean           track(RootDevice* root);
+    void              send(const char* data, size_t len);
+    void              sendContent(UPnPDevice* dvc);
+
+    WiFiClient*       _streams[MAX_EVENT_STREAMS] = {};
+    uint32_t*         _versions    = NULL;     // stateVersion() last streamed, per device of the RootDevice
+    int               _numVersions = 0;
+    unsigned long     _lastSent    = 0;
+};
+
+} // End of namespace lsc
+
+#endif
@@ -0,0 +1,330 @@
+/**
+ * 
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+#include "Metrics.h"
+#if defined(ESP32)
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#elif !defined(ESP8266) && defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+/**
+ *  Heap in use can be read on ESP and, on the host, from glibc: mallinfo2() from glibc 2.33, mallinfo() (whose counters
+ *  are int) before it. Elsewhere, e.g. macOS, heap deltas are not reported.
+ */
+#if defined(ESP32) || defined(ESP8266) || defined(__GLIBC__)
+#define HEAP_DELTA 1
+#else
+#define HEAP_DELTA 0
+#endif
+
+const char metrics_requests[]    PROGMEM = "# HELP upnp_requests_total Requests dispatched, by route\n# TYPE upnp_requests_total counter\n";
+const char metrics_render[]      PROGMEM = "Time handlers spent other than sending, by route";
+const char metrics_send[]        PROGMEM = "Time spent sending responses, by route";
+const char metrics_bytes[]       PROGMEM = "Response body size, by route";
+const char metrics_type[]        PROGMEM = "text/plain; version=0.0.4";
+const char metrics_stack_used[]  PROGMEM = "# HELP upnp_stack_used_bytes Most stack used below the point of dispatch, by route\n# TYPE upnp_stack_used_bytes gauge\n";
+const char metrics_stack_free[]  PROGMEM = "# HELP upnp_stack_free_bytes Least stack left during a request, by route\n# TYPE upnp_stack_free_bytes gauge\n";
+const char metrics_dropped[]     PROGMEM = "# HELP upnp_routes_dropped Routes not measured because memory ran out\n# TYPE upnp_routes_dropped gauge\n";
+const char metrics_heap_delta[]  PROGMEM = "# HELP upnp_heap_delta_bytes Least and most heap held after a request that was not held before it, by route\n# TYPE upnp_heap_delta_bytes gauge\n";
+
+/** Leelanau Software Company namespace 
+*  
+*/
+namespace lsc {
+
+MetricsScope* Metrics::_current = NULL;
+
+/**
+ *  Values below 2^HISTOGRAM_MIN_EXP go to bucket 0. Above that, the exponent picks a pair of buckets and the bit below 
+ *  the leading one picks the lower or upper half of the octave.
+ */
+int Histogram::bucket(uint32_t v) {
+  if( v < (1u << HISTOGRAM_MIN_EXP) ) return 0;
+  int e = 31 - __builtin_clz(v);
+  if( e >= HISTOGRAM_MAX_EXP ) return HISTOGRAM_BUCKETS-1;
+  return 1 + 2*(e-HISTOGRAM_MIN_EXP) + ((v >> (e-1)) & 1);
+}
+
+uint32_t Histogram::upperBound(int i) {
+  if( i <= 0 ) return (1u << HISTOGRAM_MIN_EXP) - 1;
+  if( i >= HISTOGRAM_BUCKETS-1 ) return 0xFFFFFFFF;
+  int e = HISTOGRAM_MIN_EXP + (i-1)/2;
+  return (((i-1)%2 == 0)?(3u << (e-1)):(2u << e)) - 1;
+}
+
+Metrics::~Metrics() {
+  for( int i=0; i<_numRoutes; i++ ) {
+    free(_routes[i]->route);
+    delete _routes[i];
+  }
+  free(_routes);
+}
+
+/**
+ *  Handlers hold the RouteMetrics of their routes, so turning metrics off clears the measurements but keeps the routes
+ */
+void Metrics::setEnabled(boolean flag) {
+  _enabled = flag;
+  if( flag ) return;
+  for( int i=0; i<_numRoutes; i++ ) {
+    RouteMetrics* r     = _routes[i];
+    char*         route = r->route;
+    uint32_t      hash  = r->hash;
+    *r = RouteMetrics();
+    r->route = route;
+    r->hash  = hash;
+  }
+}
+
+/**
+ *  The table starts at METRIC_ROUTES entries and doubles when full, so every route of a hierarchy is measured for as
+ *  long as memory lasts; a route that cannot be added is counted in dropped()
+ */
+RouteMetrics* Metrics::route(const char* path) {
+  if( !_enabled || (path == NULL) ) return NULL;
+  uint32_t h = 2166136261u;
+  for( const char* p=path; *p != '\0'; p++ ) {h ^= (uint8_t)*p; h *= 16777619u;}
+  for( int i=0; i<_numRoutes; i++ ) {if( (_routes[i]->hash == h) && (strcmp(_routes[i]->route,path) == 0) ) return _routes[i];}
+  if( _numRoutes == _capacity ) {
+    int            n      = ((_capacity > 0)?(2*_capacity):(METRIC_ROUTES));
+    RouteMetrics** routes = (RouteMetrics**)realloc(_routes,n*sizeof(RouteMetrics*));
+    if( routes == NULL ) {_dropped++; return NULL;}
+    _routes   = routes;
+    _capacity = n;
+  }
+  RouteMetrics* r = new RouteMetrics();
+  r->route = (char*)malloc(strlen(path)+1);
+  if( r->route == NULL ) {
+    delete r;
+    _dropped++;
+    return NULL;
+  }
+  strcpy(r->route,path);
+  r->hash = h;
+  _routes[_numRoutes++] = r;
+  return r;
+}
+
+void Metrics::sent(size_t bytes, uint32_t micros) {
+  if( _current == NULL ) return;
+  _current->_sendMicros += micros;
+  _current->_bytes      += bytes;
+}
+
+void Metrics::handleRequest(WebContext* svr) {
+  ResponseStream out(svr);
+  out.begin(200,metrics_type);
+  format(out);
+}
+
+/**
+ *  Only routes that have seen a request are written, each with every bucket so that series keep the same buckets
+ */
+void Metrics::format(ResponseStream& out) {
+  out.print_P(metrics_requests);
+  for( int i=0; i<_numRoutes; i++ ) {
+    if( _routes[i]->requests > 0 ) out.printf_P(PSTR("upnp_requests_total{route=\"%s\"} %lu\n"),_routes[i]->route,(unsigned long)_routes[i]->requests);
+  }
+  formatHistogram(out,"upnp_render_seconds",metrics_render,&RouteMetrics::render,true);
+  formatHistogram(out,"upnp_send_seconds",metrics_send,&RouteMetrics::send,true);
+  formatHistogram(out,"upnp_response_bytes",metrics_bytes,&RouteMetrics::bytes,false);
+  out.print_P(metrics_dropped);
+  out.printf_P(PSTR("upnp_routes_dropped %lu\n"),(unsigned long)_dropped);
+  if( _watermarks ) formatWatermarks(out);
+}
+
+/**
+ *  Times are kept in microseconds and written in seconds, the Prometheus base unit
+ */
+void Metrics::formatHistogram(ResponseStream& out, const char* name, PGM_P help, const Histogram RouteMetrics::* h, boolean seconds) {
+  out.printf_P(PSTR("# HELP %s "),name);
+  out.print_P(help);
+  out.printf_P(PSTR("\n# TYPE %s histogram\n"),name);
+  for( int i=0; i<_numRoutes; i++ ) {
+    const RouteMetrics& r = *_routes[i];
+    const Histogram&    hist = r.*h;
+    if( r.requests == 0 ) continue;
+    uint32_t cumulative = 0;
+    for( int b=0; b<HISTOGRAM_BUCKETS-1; b++ ) {
+      uint32_t le = Histogram::upperBound(b);
+      cumulative += hist.bucketCount(b);
+      if( seconds ) out.printf_P(PSTR("%s_bucket{route=\"%s\",le=\"%lu.%06lu\"} %lu\n"),name,r.route,(unsigned long)(le/1000000),(unsigned long)(le%1000000),(unsigned long)cumulative);
+      else          out.printf_P(PSTR("%s_bucket{route=\"%s\",le=\"%lu\"} %lu\n"),name,r.route,(unsigned long)le,(unsigned long)cumulative);
+    }
+    out.printf_P(PSTR("%s_bucket{route=\"%s\",le=\"+Inf\"} %lu\n"),name,r.route,(unsigned long)hist.count());
+    uint64_t sum = hist.sum();
+    if( seconds ) out.printf_P(PSTR("%s_sum{route=\"%s\"} %lu.%06lu\n"),name,r.route,(unsigned long)(sum/1000000),(unsigned long)(sum%1000000));
+    else          out.printf_P(PSTR("%s_sum{route=\"%s\"} %lu\n"),name,r.route,(unsigned long)sum);
+    out.printf_P(PSTR("%s_count{route=\"%s\"} %lu\n"),name,r.route,(unsigned long)hist.count());
+  }
+}
+
+void Metrics::formatWatermarks(ResponseStream& out) {
+  out.print_P(metrics_stack_used);
+  for( int i=0; i<_numRoutes; i++ ) {
+    if( _routes[i]->watermarks > 0 ) out.printf_P(PSTR("upnp_stack_used_bytes{route=\"%s\"} %lu\n"),_routes[i]->route,(unsigned long)_routes[i]->stackUsed);
+  }
+#if defined(ESP32) || defined(ESP8266)
+  out.print_P(metrics_stack_free);
+  for( int i=0; i<_numRoutes; i++ ) {
+    if( _routes[i]->watermarks > 0 ) out.printf_P(PSTR("upnp_stack_free_bytes{route=\"%s\"} %lu\n"),_routes[i]->route,(unsigned long)_routes[i]->stackFree);
+  }
+#endif
+#if HEAP_DELTA
+  out.print_P(metrics_heap_delta);
+  for( int i=0; i<_numRoutes; i++ ) {
+    const RouteMetrics& r = *_routes[i];
+    if( r.watermarks == 0 ) continue;
+    out.printf_P(PSTR("upnp_heap_delta_bytes{route=\"%s\",bound=\"min\"} %ld\n"),r.route,(long)r.heapDeltaMin);
+    out.printf_P(PSTR("upnp_heap_delta_bytes{route=\"%s\",bound=\"max\"} %ld\n"),r.route,(long)r.heapDeltaMax);
+  }
+#endif
+}
+
+void Metrics::printInfo(Metrics* m) {
+  Serial.printf("%-44s %8s  %10s  %10s  %8s  %8s\n","Route","Requests","Stack Used","Stack Free","Heap Min","Heap Max");
+  if( (m == NULL) || !m->enabled() ) return;
+  for( int i=0; i<m->_numRoutes; i++ ) {
+    const RouteMetrics& r = *m->_routes[i];
+    if( r.watermarks == 0 ) continue;
+#if defined(ESP32) || defined(ESP8266)
+    Serial.printf("%-44s %8lu  %10lu  %10lu  %8ld  %8ld\n",r.route,(unsigned long)r.watermarks,(unsigned long)r.stackUsed,
+                  (unsigned long)r.stackFree,(long)r.heapDeltaMin,(long)r.heapDeltaMax);
+#elif HEAP_DELTA
+    Serial.printf("%-44s %8lu  %10lu  %10s  %8ld  %8ld\n",r.route,(unsigned long)r.watermarks,(unsigned long)r.stackUsed,
+                  "-",(long)r.heapDeltaMin,(long)r.heapDeltaMax);
+#else
+    Serial.printf("%-44s %8lu  %10lu  %10s  %8s  %8s\n",r.route,(unsigned long)r.watermarks,(unsigned long)r.stackUsed,
+                  "-","-","-");
+#endif
+  }
+}
+
+/**
+ *  Heap in use, up to a constant, so that the difference of two readings is the heap a request kept. ESP reports free
+ *  heap, whose negation differs from heap in use only by the heap size.
+ */
+static int32_t heapInUse() {
+#if defined(ESP32) || defined(ESP8266)
+  return -(int32_t)ESP.getFreeHeap();
+#elif (__GLIBC__ > 2) || ((__GLIBC__ == 2) && (__GLIBC_MINOR__ >= 33))
+  return (int32_t)mallinfo2().uordblks;
+#elif HEAP_DELTA
+  return (int32_t)mallinfo().uordblks;
+#else
+  return 0;
+#endif
+}
+
+#if !defined(ESP8266)
+#define STACK_PATTERN  0xA5A5A5A5u
+#define STACK_MARGIN   256           // Bytes left unpainted below the painting frame, for the calls that return from it
+
+/**
+ *  Paints the stack from STACK_MARGIN below this frame down STACK_PAINT_SIZE bytes (ESP32: no further than the task's
+ *  stack start). Kept out of line so its frame lies below the scope being measured, and written through a volatile 
+ *  pointer so the stores to memory below the stack pointer are kept. Sets top to the top of the painted region, from 
+ *  which use is measured, and returns its bottom; use within STACK_MARGIN of the dispatch frame is not seen.
+ */
+static uint32_t* __attribute__((noinline)) paintStack(uintptr_t& top) {
+  volatile uint32_t marker = 0;
+  uint32_t* end    = (uint32_t*)(((uintptr_t)&marker - STACK_MARGIN) & ~(uintptr_t)3);
+  uint32_t* bottom = end - STACK_PAINT_SIZE/4;
+  top = (uintptr_t)end;
+#if defined(ESP32)
+  uint32_t* start  = (uint32_t*)pxTaskGetStackStart(NULL) + 16;
+  if( bottom < start ) bottom = start;
+#endif
+  for( volatile uint32_t* p=bottom; p<end; p++ ) *p = STACK_PATTERN;
+  return bottom;
+}
+
+/**
+ *  The lowest word no longer holding the pattern is as deep as the stack has reached since painting
+ */
+static uintptr_t __attribute__((noinline)) stackLowWater(uint32_t* bottom, uintptr_t top) {
+  volatile uint32_t* p = bottom;
+  while( ((uintptr_t)p < top) && (*p == STACK_PATTERN) ) p++;
+  return (uintptr_t)p;
+}
+#endif
+
+/**
+ *  The heap is read before the stack is painted and after it is scanned, so that reading it is not counted as stack use
+ */
+void MetricsScope::beginWatermarks() {
+  _heap = heapInUse();
+#if defined(ESP8266)
+  ESP.resetFreeContStack();
+  _stackBase = ESP.getFreeContStack();
+#else
+  _stackLow = paintStack(_stackTop);
+#endif
+}
+
+void MetricsScope::endWatermarks() {
+#if defined(ESP8266)
+  _stackFree = ESP.getFreeContStack();
+  _stackUsed = (_stackBase > _stackFree)?(_stackBase-_stackFree):(0);
+#else
+  uintptr_t low = stackLowWater(_stackLow,_stackTop);
+  _stackUsed = (uint32_t)(_stackTop - low);
+#if defined(ESP32)
+  _stackFree = (uint32_t)(low - (uintptr_t)pxTaskGetStackStart(NULL));
+#endif
+#endif
+  int32_t heap = heapInUse() - _heap;
+  if( _route == NULL ) return;
+  if( (_route->watermarks == 0) || (_stackFree < _route->stackFree) ) _route->stackFree = _stackFree;
+  if( (_route->watermarks == 0) || (heap < _route->heapDeltaMin) )    _route->heapDeltaMin = heap;
+  if( (_route->watermarks == 0) || (heap > _route->heapDeltaMax) )    _route->heapDeltaMax = heap;
+  if( _stackUsed > _route->stackUsed ) _route->stackUsed = _stackUsed;
+  _route->watermarks++;
+}
+
+/**
+ *  Scopes do not nest; a request dispatched while another is measured is not measured
+ */
+MetricsScope::MetricsScope(Metrics* metrics, RouteMetrics* route) : _active(false), _route(route) {
+  if( (metrics == NULL) || !metrics->enabled() || (Metrics::_current != NULL) ) return;
+  _active           = true;
+  _watermark        = metrics->watermarks();
+  if( _watermark ) beginWatermarks();
+  _start            = micros();
+  Metrics::_current = this;
+}
+
+MetricsScope::~MetricsScope() {
+  if( !_active ) return;
+  uint32_t total    = (uint32_t)(micros()-_start);
+  Metrics::_current = NULL;
+  if( _watermark ) endWatermarks();
+  if( _route == NULL ) return;
+  _route->requests++;
+  _route->render.record(((total > _sendMicros)?(total-_sendMicros):(0)));
+  _route->send.record(_sendMicros);
+  _route->bytes.record(_bytes);
+}
+
+} // End of namespace lsc
@@ -0,0 +1,224 @@
+/**
+ * 
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+#ifndef UPNP_METRICS_H
+#define UPNP_METRICS_H
+
+#include <Arduino.h>
+#include <WebContext.h>
+#include "ResponseStream.h"
+
+/** Leelanau Software Company namespace 
+*  
+*/
+namespace lsc {
+
+/**
+ *   Request metrics limits, which can be overridden at compile time:
+ *     METRIC_ROUTES       := Routes the table is first sized for; it doubles as routes are added
+ *     STACK_PAINT_SIZE    := Most stack (bytes) below the point of dispatch that watermarks paint and scan, bounding both the
+ *                            cost and the largest stack use that can be seen. ESP32 paints no further than the task stack.
+ *   Histograms are log-linear: values below 2^HISTOGRAM_MIN_EXP share the first bucket, each power of two from there up to
+ *   2^HISTOGRAM_MAX_EXP is split into two buckets (so a bucket is at most 50% wide), and larger values share the last. 
+ *   Times are recorded in microseconds, so the buckets run from 16us to 1s, and sizes in bytes, from 16 bytes to 1MB.
+ */
+#ifndef METRIC_ROUTES
+#define METRIC_ROUTES      16
+#endif
+#ifndef STACK_PAINT_SIZE
+#define STACK_PAINT_SIZE   8192
+#endif
+#define HISTOGRAM_MIN_EXP  4
+#define HISTOGRAM_MAX_EXP  20
+#define HISTOGRAM_BUCKETS  (2*(HISTOGRAM_MAX_EXP-HISTOGRAM_MIN_EXP)+2)
+
+class MetricsScope;
+
+/** Histogram class definition
+ *  A fixed size log-linear histogram of unsigned 32 bit values.
+ *  Class members are as follows:
+ *    record(v)       := Counts v in its bucket; a count leading zeros and a shift
+ *    count()         := Number of values recorded
+ *    sum()           := Sum of values recorded
+ *    bucketCount(i)  := Number of values recorded in bucket i
+ *    upperBound(i)   := Largest value counted in bucket i; the last bucket is unbounded
+ */
+class Histogram {
+  public:
+    Histogram() {}
+
+    void             record(uint32_t v)              {_counts[bucket(v)]++; _count++; _sum += v;}
+    uint32_t         count() const                   {return _count;}
+    uint64_t         sum() const                     {return _sum;}
+    uint32_t         bucketCount(int i) const        {return (((i>=0)&&(i<HISTOGRAM_BUCKETS))?(_counts[i]):(0));}
+
+    static int       bucket(uint32_t v);
+    static uint32_t  upperBound(int i);
+
+  private:
+    uint32_t         _counts[HISTOGRAM_BUCKETS] = {};
+    uint32_t         _count = 0;
+    uint64_t         _sum   = 0;
+};
+
+/** RouteMetrics
+ *  Measurements for one route, named by its path:
+ *    requests      := Requests dispatched
+ *    render        := Microseconds spent in the handler other than sending (rendering, parsing, device work)
+ *    send          := Microseconds spent handing the response to the Web server
+ *    bytes         := Response body bytes
+ *  and, with watermarks on:
+ *    watermarks    := Requests measured for stack and heap
+ *    stackUsed     := Most stack (bytes) used below the point of dispatch by any request
+ *    stackFree     := Least stack (bytes) left during any request, on ESP8266 and ESP32; 0 where it cannot be known
+ *    heapDeltaMin  := Least and most heap (bytes) held at the end of a request that was not held at its start; negative
+ *    heapDeltaMax     when a request frees memory held before it, e.g. a cache rebuilt smaller. 0, and not exported, on
+ *                     hosts without glibc, where heap in use cannot be read
+ */
+struct RouteMetrics {
+  char*       route;
+  uint32_t    hash;
+  uint32_t    requests;
+  Histogram   render;
+  Histogram   send;
+  Histogram   bytes;
+  uint32_t    watermarks;
+  uint32_t    stackUsed;
+  uint32_t    stackFree;
+  int32_t     heapDeltaMin;
+  int32_t     heapDeltaMax;
+};
+
+/** Metrics class definition
+ *  Metrics records, for every route of a RootDevice, the number of requests and histograms of render time, send time 
+ *  and response size, and exports them in Prometheus text format on /rootTarget/metrics. Metrics are off, and take no
+ *  memory, until enabled; enable them before setup(), so that routes can be measured as they are registered. Handlers
+ *  keep the RouteMetrics of their route, so routes, once added, are kept until the Metrics is destroyed.
+ *  A request is measured by a MetricsScope around its dispatch. Time spent sending is reported to the scope of the 
+ *  request in progress by sent() (ResponseStream does this for every chunk), and the rest of the handler's time counts
+ *  as render time, so measuring costs a few calls to micros() per request.
+ *  Class members are as follows:
+ *    setEnabled(flag)     := Turns metrics on; turning them off stops measuring and clears all measurements
+ *    route(path)          := Returns the RouteMetrics for path, adding it if need be, or NULL when disabled or when 
+ *                            memory for it runs out
+ *    numRoutes()          := Number of routes measured
+ *    dropped()            := Number of routes not measured because memory ran out; exported as upnp_routes_dropped
+ *    handleRequest(svr)   := Responds with all measurements in Prometheus text format
+ *    format(out)          := Writes them to out
+ *    sent(bytes,micros)   := Adds a send to the request being measured, if any
+ *    timeSend(bytes,f)    := Calls f, which sends bytes of response, and reports it with sent()
+ *    setWatermarks(flag)  := Also records each route's stack high-water mark and heap delta (see RouteMetrics). The stack 
+ *                            below the point of dispatch is painted with a pattern before each request and scanned after
+ *                            it (on ESP8266 the core's own painted stack is reset and read), which costs tens of 
+ *                            microseconds per request, so watermarks are off unless asked for.
+ *    printInfo(m)         := Sends the watermarks of every route to Serial
+ */
+class Metrics {
+  public:
+    Metrics() {}
+    ~Metrics();
+
+    void             setEnabled(boolean flag);
+    boolean          enabled()                       {return _enabled;}
+    void             setWatermarks(boolean flag)     {_watermarks = flag;}
+    boolean          watermarks()                    {return _watermarks;}
+    RouteMetrics*    route(const char* path);
+    int              numRoutes()                     {return _numRoutes;}
+    uint32_t         dropped()                       {return _dropped;}
+    void             handleRequest(WebContext* svr);
+    void             format(ResponseStream& out);
+    static void      printInfo(Metrics* m);
+
+    static boolean   measuring()                     {return _current != NULL;}
+    static void      sent(size_t bytes, uint32_t micros);
+
+    template<typename F>
+    static void      timeSend(size_t bytes, F send)  {
+                       if( _current == NULL ) {send(); return;}
+                       unsigned long start = micros();
+                       send();
+                       sent(bytes,(uint32_t)(micros()-start));
+                     }
+
+/**
+ *   Copy construction and destruction are not allowed
+ */
+    Metrics(const Metrics&)= delete;
+    Metrics& operator=(const Metrics&)= delete;
+
+  private:
+    void             formatHistogram(ResponseStream& out, const char* name, PGM_P help, const Histogram RouteMetrics::* h, boolean seconds);
+
+    void             formatWatermarks(ResponseStream& out);
+
+    RouteMetrics**   _routes     = NULL;
+    int              _numRoutes  = 0;
+    int              _capacity   = 0;
+    uint32_t         _dropped    = 0;
+    boolean          _enabled    = false;
+    boolean          _watermarks = false;
+
+    static MetricsScope*  _current;
+    friend class MetricsScope;
+};
+
+/** MetricsScope class definition
+ *  Measures one request from construction to destruction and records it into a route. The route may be given up front, 
+ *  or set with setRoute() once dispatch has found it; nothing is recorded without one. A NULL Metrics or a disabled one 
+ *  measures nothing.
+ */
+class MetricsScope {
+  public:
+    MetricsScope(Metrics* metrics, RouteMetrics* route = NULL);
+    ~MetricsScope();
+
+    void             setRoute(RouteMetrics* route)   {_route = route;}
+
+/**
+ *   Copy construction and destruction are not allowed
+ */
+    MetricsScope(const MetricsScope&)= delete;
+    MetricsScope& operator=(const MetricsScope&)= delete;
+
+  private:
+    void             beginWatermarks();
+    void             endWatermarks();
+
+    boolean          _active;
+    boolean          _watermark  = false;
+    RouteMetrics*    _route;
+    unsigned long    _start      = 0;
+    uint32_t         _sendMicros = 0;
+    uint32_t         _bytes      = 0;
+    int32_t          _heap       = 0;          // Heap in use at the start, up to a constant
+    uintptr_t        _stackTop   = 0;          // Address the stack is measured down from
+    uint32_t*        _stackLow   = NULL;       // Bottom of the painted stack
+    uint32_t         _stackBase  = 0;          // ESP8266: free cont stack at the start
+    uint32_t         _stackUsed  = 0;
+    uint32_t         _stackFree  = 0;
+
+    friend class Metrics;
+};
+
+} // End of namespace lsc
+
+#endif
@@ -0,0 +1,166 @@
+/**
+ * 
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+#ifndef UPNP_PAGE_TEMPLATE_H
+#define UPNP_PAGE_TEMPLATE_H
+
+#include "ResponseStream.h"
+
+/** Leelanau Software Company namespace 
+*  
+*/
+namespace lsc {
+
+/**
+ *   Longest rendering of a template value:
+ *     TEMPLATE_ESCAPE_MAX   := Bytes one character of text can become when escaped (&quot;)
+ *     TEMPLATE_INT_MAX      := Characters of a %d value, sign included
+ */
+#define TEMPLATE_ESCAPE_MAX  6
+#define TEMPLATE_INT_MAX     11
+
+/** TemplateScan
+ *  Compile time scans of a template's text, s[lo,hi). C++11 constexpr functions are a single expression, so each scan
+ *  splits its range in half rather than walking it, keeping recursion to log2 of the template length however long
+ *  the page is.
+ *  Class members are as follows:
+ *    count(s,lo,hi)            := Number of conversions ('%')
+ *    countOf(s,type,lo,hi)     := Number of conversions of type ('s' or 'd')
+ *    find(s,n,lo,hi)           := Position of conversion n (from 0), which must exist
+ *    valid(s,lo,hi)            := true if every '%' is followed by s or d
+ */
+class TemplateScan {
+  public:
+    static constexpr size_t  count(const char* s, size_t lo, size_t hi) {
+      return ((hi-lo == 0)?(0):((hi-lo == 1)?((s[lo] == '%')?(1):(0)):(count(s,lo,lo+(hi-lo)/2) + count(s,lo+(hi-lo)/2,hi))));
+    }
+    static constexpr size_t  countOf(const char* s, char type, size_t lo, size_t hi) {
+      return ((hi-lo == 0)?(0):((hi-lo == 1)?(((s[lo] == '%') && (s[lo+1] == type))?(1):(0)):
+                                            (countOf(s,type,lo,lo+(hi-lo)/2) + countOf(s,type,lo+(hi-lo)/2,hi))));
+    }
+    static constexpr size_t  find(const char* s, size_t n, size_t lo, size_t hi) {
+      return ((hi-lo == 1)?(lo):((n < count(s,lo,lo+(hi-lo)/2))?(find(s,n,lo,lo+(hi-lo)/2)):
+                                                                (find(s,n-count(s,lo,lo+(hi-lo)/2),lo+(hi-lo)/2,hi))));
+    }
+    static constexpr boolean valid(const char* s, size_t lo, size_t hi) {
+      return ((hi-lo == 0)?(true):((hi-lo == 1)?((s[lo] != '%') || (s[lo+1] == 's') || (s[lo+1] == 'd')):
+                                               (valid(s,lo,lo+(hi-lo)/2) && valid(s,lo+(hi-lo)/2,hi))));
+    }
+};
+
+/** TemplateSlot
+ *  How a value is written into a slot: text (const char*) is escaped into %s, integers are written into %d. Values of
+ *  any other type do not compile.
+ */
+template<typename V> struct TemplateSlot;
+template<> struct TemplateSlot<const char*> {static constexpr char type = 's'; static void write(ResponseStream& out, const char* v) {out.printEscaped(v);}};
+template<> struct TemplateSlot<char*>       {static constexpr char type = 's'; static void write(ResponseStream& out, const char* v) {out.printEscaped(v);}};
+template<> struct TemplateSlot<int>         {static constexpr char type = 'd'; static void write(ResponseStream& out, int v)         {out.print((long)v);}};
+template<> struct TemplateSlot<long>        {static constexpr char type = 'd'; static void write(ResponseStream& out, long v)        {out.print(v);}};
+
+/** PageTemplate class definition
+ *  A PageTemplate is a page fragment whose text is split into literal segments and typed slots by the compiler, so 
+ *  rendering it is a fixed sequence of memcpy_P() and value writes with no format string to parse. Templates are
+ *  declared with PAGE_TEMPLATE, which keeps the text in PROGMEM and names the PageTemplate type:
+ *
+ *      PAGE_TEMPLATE(AppButton,"<div align=\"center\"><a href=\"%s\" class=\"appButton\">%s</a></div><br>");
+ *      ...
+ *      AppButton::render(out,d->path(),d->getDisplayName());
+ *
+ *  Slots are %s (text, escaped as by ResponseStream::printEscaped()) and %d (int or long). A template with any other 
+ *  conversion, render() with the wrong number of values, or a value of the wrong type for its slot, does not compile.
+ *  Class members are as follows:
+ *    slots                     := Number of slots; render() takes one value for each
+ *    literalLength             := Bytes of literal text, written by every render()
+ *    maxLength(textLength)     := Longest possible rendering when no text value is longer than textLength
+ *    start(i)/length(i)        := Position and length of literal segment i, which precedes slot i (the last 
+ *                                 segment follows the last slot)
+ *    type(i)                   := Type of slot i, 's' or 'd'
+ *    render(out,values...)     := Writes the template to out, with values in its slots
+ */
+template<size_t N, const char (&Text)[N]>
+class PageTemplate {
+  public:
+    static_assert(TemplateScan::valid(Text,0,N-1),"PageTemplate slots are %s and %d only");
+
+    static constexpr size_t  slots         = TemplateScan::count(Text,0,N-1);
+    static constexpr size_t  textSlots     = TemplateScan::countOf(Text,'s',0,N-1);
+    static constexpr size_t  literalLength = N-1-2*slots;
+
+    static constexpr size_t  maxLength(size_t textLength) {return literalLength + textSlots*textLength*TEMPLATE_ESCAPE_MAX + (slots-textSlots)*TEMPLATE_INT_MAX;}
+    static constexpr size_t  start(size_t i)  {return ((i == 0)?(0):(TemplateScan::find(Text,i-1,0,N-1)+2));}
+    static constexpr size_t  length(size_t i) {return ((i == slots)?(N-1):(TemplateScan::find(Text,i,0,N-1))) - start(i);}
+    static constexpr char    type(size_t i)   {return Text[TemplateScan::find(Text,i,0,N-1)+1];}
+
+    template<typename... V>
+    static void render(ResponseStream& out, V... values) {
+      static_assert(sizeof...(V) == slots,"PageTemplate::render() takes one value per slot");
+      renderFrom<0>(out,values...);
+    }
+
+  private:
+/**
+ *   Segment positions and lengths are template arguments, so they are computed by the compiler, never at run time
+ */
+    template<size_t Start, size_t Length>
+    static void segment(ResponseStream& out)                  {if( Length > 0 ) out.write_P(Text+Start,Length);}
+
+    template<size_t I>
+    static void renderFrom(ResponseStream& out)               {segment<start(I),length(I)>(out);}
+
+    template<size_t I, typename V, typename... Rest>
+    static void renderFrom(ResponseStream& out, V value, Rest... rest) {
+      static_assert(type(I) == TemplateSlot<V>::type,"PageTemplate value does not match its slot: %s takes text, %d an integer");
+      segment<start(I),length(I)>(out);
+      TemplateSlot<V>::write(out,value);
+      renderFrom<I+1>(out,rest...);
+    }
+};
+
+template<size_t N, const char (&Text)[N]> constexpr size_t PageTemplate<N,Text>::slots;
+template<size_t N, const char (&Text)[N]> constexpr size_t PageTemplate<N,Text>::textSlots;
+template<size_t N, const char (&Text)[N]> constexpr size_t PageTemplate<N,Text>::literalLength;
+
+/**
+ *   Declares the PROGMEM text name_text and the PageTemplate type name
+ */
+#define PAGE_TEMPLATE(name,text) constexpr char name##_text[] PROGMEM = text;  \
+                                 typedef lsc::PageTemplate<sizeof(name##_text),name##_text> name
+
+/**
+ *   Library page fragments. The CommonProgmem fragments are printf formats that cannot be split at compile time, so their
+ *   markup is copied here, and this is the only copy; keep each in step with the CommonProgmem fragment it names:
+ *     L3Title      := html_L3_title
+ *     AppButton    := app_button
+ *     ConfigButton := config_button
+ *     IFrame       := iframe_html
+ *   The page header and title (html_header, html_title) are written by CommonProgmem's formatHeader() itself, through
+ *   ResponseStream::formatHeader().
+ */
+PAGE_TEMPLATE(L3Title,      "<h3 align=\"center\">%s</h3>");
+PAGE_TEMPLATE(AppButton,    "<div align=\"center\"><a href=\"%s\" class=\"appButton\">%s</a></div><br>");
+PAGE_TEMPLATE(ConfigButton, "<br><div align=\"center\"><a href=\"%s\"><button class=\"cfgButton\">%s</button></a></div>");
+PAGE_TEMPLATE(IFrame,       "<div align=\"center\"><iframe src=\"%s\" height=\"%d\" width=\"%d\" frameborder=\"0\" scrolling=\"no\"></iframe></div>");
+
+} // End of namespace lsc
+
+#endif
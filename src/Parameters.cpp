@@ -0,0 +1,102 @@
+/**
+ * 
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+#include "Parameters.h"
+
+/** Leelanau Software Company namespace 
+*  
+*/
+namespace lsc {
+
+/**
+ *  One pass over the arguments: each name is hashed once, folded as Parameter::hash() folds, and looked up among params 
+ *  by hash, with strcasecmp() only to confirm a match
+ */
+uint32_t Parameter::bind(WebContext* svr, const Parameter params[], int count, void* args, uint32_t* rejected) {
+  uint32_t bound = 0;
+  if( rejected != NULL ) *rejected = 0;
+  if( count > MAX_PARAMETERS ) count = MAX_PARAMETERS;
+  int numArgs = svr->argCount();
+  for( int i=0; i<numArgs; i++ ) {
+    const String& argName = svr->argName(i);
+    const char*   n = argName.c_str();
+    uint32_t      h = 2166136261u;
+    for( const char* p=n; *p != '\0'; p++ ) {h ^= (uint8_t)fold(*p); h *= 16777619u;}
+    for( int j=0; j<count; j++ ) {
+      if( (params[j].nameHash != h) || (strcasecmp(params[j].name,n) != 0) ) continue;
+      const String& arg = svr->arg(i);
+      if( params[j].decode(arg.c_str(),arg.length(),args) ) {
+        bound |= (1u << j);
+        if( rejected != NULL ) *rejected &= ~(1u << j);
+      }
+      else if( rejected != NULL ) *rejected |= (1u << j);
+      break;
+    }
+  }
+  return bound;
+}
+
+/**
+ *  A value is parsed in full before the field is written, so a rejected value leaves the field as it was
+ */
+boolean Parameter::decode(const char* value, size_t len, void* args) const {
+  char* field = ((args != NULL)?((char*)args + offset):(NULL));
+  switch( type ) {
+    case TEXT_PARAMETER: {
+      if( (int32_t)len < min ) return false;
+      if( len > (size_t)max ) len = max;
+      if( field == NULL ) return true;
+      memcpy(field,value,len);
+      field[len] = '\0';
+      return true;
+    }
+    case INT_PARAMETER: {
+      if( len == 0 ) return false;
+      char* end = NULL;
+      long  v = strtol(value,&end,10);
+      if( (*end != '\0') || (v < min) || (v > max) ) return false;
+      int32_t i = (int32_t)v;
+      if( field != NULL ) memcpy(field,&i,sizeof(i));
+      return true;
+    }
+    case BOOL_PARAMETER: {
+      boolean b;
+      if( (len == 0) || (strcmp(value,"1") == 0) || (strcasecmp(value,"true") == 0) || (strcasecmp(value,"on") == 0) || (strcasecmp(value,"yes") == 0) ) b = true;
+      else if( (strcmp(value,"0") == 0) || (strcasecmp(value,"false") == 0) || (strcasecmp(value,"off") == 0) || (strcasecmp(value,"no") == 0) ) b = false;
+      else return false;
+      if( field != NULL ) memcpy(field,&b,sizeof(b));
+      return true;
+    }
+    case CHOICE_PARAMETER: {
+      for( int i=0; i<size; i++ ) {
+        if( strcasecmp(choices[i],value) == 0 ) {
+          if( field != NULL ) memcpy(field,&i,sizeof(i));
+          return true;
+        }
+      }
+      return false;
+    }
+  }
+  return false;
+}
+
+} // End of namespace lsc
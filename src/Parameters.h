@@ -0,0 +1,129 @@
+/**
+ * 
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+#ifndef UPNP_PARAMETERS_H
+#define UPNP_PARAMETERS_H
+
+#include <Arduino.h>
+#include <WebContext.h>
+#include <stddef.h>
+
+/** Leelanau Software Company namespace 
+*  
+*/
+namespace lsc {
+
+/**
+ *   Parameter limits:
+ *     MAX_PARAMETERS      := Parameters in one table; bind() reports them in a 32 bit mask
+ */
+#define MAX_PARAMETERS     32
+
+/**
+ *   Parameter types and the type of field each is bound to:
+ *     TEXT_PARAMETER      := char[size]; values longer than size-1 are truncated, shorter than min are rejected
+ *     INT_PARAMETER       := int32_t; a whole decimal number from min to max
+ *     BOOL_PARAMETER      := boolean; 1/true/on/yes or 0/false/off/no, and no value at all is true ("?async")
+ *     CHOICE_PARAMETER    := int; the index of the value among choices, compared without case
+ */
+enum ParameterType : uint8_t {TEXT_PARAMETER, INT_PARAMETER, BOOL_PARAMETER, CHOICE_PARAMETER};
+
+/** Parameter
+ *  A Parameter describes one request argument of a handler and the field of an argument struct it is decoded into. A
+ *  handler declares its Parameters once, as a constant table, and binds each request to a struct on its stack:
+ *
+ *      struct StateArgs {int state; boolean async;};
+ *      const char* const onOff[] = {"OFF","ON"};
+ *      const Parameter   stateParams[] = {Parameter::choice("STATE",offsetof(StateArgs,state),onOff,2),
+ *                                         Parameter::flag("async",offsetof(StateArgs,async))};
+ *      ...
+ *      StateArgs args = {-1,false};
+ *      uint32_t  bound = Parameter::bind(svr,stateParams,&args);
+ *      if( Parameter::isBound(bound,0) ) ...
+ *
+ *  Names are matched without case. Each table entry carries the FNV-1a hash of its case folded name, computed at compile
+ *  time, so decoding hashes each argument name once and compares strings only when hashes agree. Nothing is allocated: 
+ *  values are parsed from the server's argument strings straight into the struct.
+ *  Class members are as follows:
+ *    name          := Argument name
+ *    nameHash      := hash(name)
+ *    type          := ParameterType
+ *    offset        := Offset of the field in the argument struct (offsetof)
+ *    size          := TEXT: size of the char[] field; CHOICE: number of choices
+ *    min, max      := INT: bounds of the value; TEXT: min is the least length accepted
+ *    choices       := CHOICE: the accepted values
+ *  Static functions are:
+ *    text(name,offset,size,minLength)     := TEXT Parameter for a char[size] field
+ *    integer(name,offset,min,max)         := INT Parameter
+ *    flag(name,offset)                    := BOOL Parameter
+ *    choice(name,offset,choices,count)    := CHOICE Parameter
+ *    bind(svr,params,count,args,rejected) := Decodes the request arguments of svr into args, and returns a mask with bit i
+ *                                            set for each params[i] bound. A Parameter present but with a value that does
+ *                                            not parse or is out of bounds is left as it was and, if rejected is not NULL,
+ *                                            set in *rejected. Arguments not in params are ignored, and a repeated argument
+ *                                            binds its last value. The template takes the count from the table.
+ *    isBound(mask,i)                      := True if params[i] is set in mask
+ *    decode(value,len,args)               := Parses value into the field of args, returning false if it does not parse or
+ *                                            is out of bounds. With args NULL the value is only checked.
+ *    hash(name)                           := FNV-1a hash of name with A-Z folded to a-z; constexpr, so it may also be 
+ *                                            used for case labels
+ */
+struct Parameter {
+  const char*          name;
+  uint32_t             nameHash;
+  ParameterType        type;
+  uint16_t             offset;
+  uint16_t             size;
+  int32_t              min;
+  int32_t              max;
+  const char* const*   choices;
+
+  static constexpr char     fold(char c)                                     {return (((c >= 'A') && (c <= 'Z'))?((char)(c-'A'+'a')):(c));}
+  static constexpr uint32_t hash(const char* s, uint32_t h = 2166136261u)    {return ((*s == '\0')?(h):(hash(s+1,(h ^ (uint8_t)fold(*s)) * 16777619u)));}
+
+  static constexpr Parameter text(const char* name, size_t offset, size_t size, int32_t minLength = 0) {
+    return {name,hash(name),TEXT_PARAMETER,(uint16_t)offset,(uint16_t)size,minLength,(int32_t)size-1,NULL};
+  }
+  static constexpr Parameter integer(const char* name, size_t offset, int32_t min, int32_t max) {
+    return {name,hash(name),INT_PARAMETER,(uint16_t)offset,(uint16_t)sizeof(int32_t),min,max,NULL};
+  }
+  static constexpr Parameter flag(const char* name, size_t offset) {
+    return {name,hash(name),BOOL_PARAMETER,(uint16_t)offset,(uint16_t)sizeof(boolean),0,1,NULL};
+  }
+  static constexpr Parameter choice(const char* name, size_t offset, const char* const choices[], int count) {
+    return {name,hash(name),CHOICE_PARAMETER,(uint16_t)offset,(uint16_t)count,0,count-1,choices};
+  }
+
+  static uint32_t      bind(WebContext* svr, const Parameter params[], int count, void* args, uint32_t* rejected = NULL);
+  template<size_t N>
+  static uint32_t      bind(WebContext* svr, const Parameter (&params)[N], void* args, uint32_t* rejected = NULL) {
+    static_assert(N <= MAX_PARAMETERS,"Too many Parameters for one table");
+    return bind(svr,params,(int)N,args,rejected);
+  }
+  static boolean       isBound(uint32_t mask, int i)                        {return ((mask & (1u << i)) != 0);}
+
+  boolean              decode(const char* value, size_t len, void* args) const;
+};
+
+} // End of namespace lsc
+
+#endif
@@ -0,0 +1,394 @@
+/**
+ *
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or any
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  The author can be contacted at dan@leelanausoftware.com
+ *
+ */
+
+#include "ResponseStream.h"
+#include "Metrics.h"
+
+/** Leelanau Software Company namespace
+*
+*/
+namespace lsc {
+
+/**
+ *  Length of the plain text (or literal template text) at s, up to the next character printEscaped() replaces (the 
+ *  next '%'), or the terminating null. strcspn() is vectorized in the host C library; on the ESP boards newlib's 
+ *  strcspn() walks the reject set for every character, so one mask test per character is used instead, and ESP8266 
+ *  templates are read from flash a byte at a time. The escaped characters all fall below 0x40: &(0x26), <(0x3C),
+ *  >(0x3E), "(0x22) and '(0x27), along with the null, so a 64 bit mask covers them.
+ */
+#if defined(ESP8266) || defined(ESP32)
+static const uint64_t stop_mask = (1ULL<<'&') | (1ULL<<'<') | (1ULL<<'>') | (1ULL<<'"') | (1ULL<<'\'') | 1ULL;
+
+static inline size_t plainRun(const char* s) {
+  const char* p = s;
+  while( ((uint8_t)*p >= 0x40) || !((stop_mask >> (uint8_t)*p) & 1) ) p++;
+  return p-s;
+}
+
+static inline size_t literalRun(PGM_P s) {
+  PGM_P p = s;
+  char  c;
+  while( ((c = (char)pgm_read_byte(p)) != '\0') && (c != '%') ) p++;
+  return p-s;
+}
+#else
+static inline size_t plainRun(const char* s)   {return strcspn(s,"&<>\"'");}
+static inline size_t literalRun(PGM_P s)       {const char* p = strchr(s,'%'); return ((p!=NULL)?(p-s):(strlen(s)));}
+#endif
+
+/**
+ *  Sends to the Web server are timed for the request being measured (see Metrics)
+ */
+void ResponseStream::begin(int code, const char* contentType) {
+  if( (_svr != NULL) && !_started ) {
+    _svr->setContentLength(CONTENT_LENGTH_UNKNOWN);
+    Metrics::timeSend(0,[this,code,contentType](){_svr->send(code,contentType,"");});
+  }
+  _started = true;
+}
+
+void ResponseStream::flush() {
+  if( _pos > 0 ) {
+    if( _capture ) _capture(_buffer,_pos);
+    else if( _svr != NULL ) Metrics::timeSend(_pos,[this](){_svr->sendContent(_buffer,_pos);});
+    else if( _sink ) _sink(_buffer,_pos);
+    _pos = 0;
+  }
+}
+
+/**
+ *  An empty chunk terminates a chunked response
+ */
+void ResponseStream::end() {
+  if( !_ended ) {
+    flush();
+    if( (_svr != NULL) && _started ) Metrics::timeSend(0,[this](){_svr->sendContent("",0);});
+    _ended = true;
+  }
+}
+
+/**
+ *  Writes that fit the buffer are copied inline by write(); larger ones are sent a buffer at a time
+ */
+void ResponseStream::writeBlocks(const char* data, size_t len) {
+  _written += len;
+  while( len > 0 ) {
+    if( _pos >= sizeof(_buffer) ) flush();
+    size_t n = sizeof(_buffer) - _pos;
+    if( n > len ) n = len;
+    memcpy(_buffer+_pos,data,n);
+    _pos += n;
+    data += n;
+    len  -= n;
+  }
+}
+
+void ResponseStream::print_P(PGM_P s) {write_P(s,strlen_P(s));}
+
+void ResponseStream::write_P(PGM_P s, size_t len) {
+  if( len <= sizeof(_buffer)-_pos ) {
+    memcpy_P(_buffer+_pos,s,len);
+    _pos     += len;
+    _written += len;
+    return;
+  }
+  while( len > 0 ) {
+    if( _pos >= sizeof(_buffer) ) flush();
+    size_t n = sizeof(_buffer) - _pos;
+    if( n > len ) n = len;
+    memcpy_P(_buffer+_pos,s,n);
+    _pos     += n;
+    _written += n;
+    s        += n;
+    len      -= n;
+  }
+}
+
+/**
+ *  Digits are produced from the right into a scratch buffer; the magnitude is taken unsigned so LONG_MIN is exact
+ */
+void ResponseStream::print(long n) {
+  char          num[24];
+  char*         p = num + sizeof(num);
+  unsigned long u = ((n < 0)?(0UL-(unsigned long)n):((unsigned long)n));
+  do {*--p = (char)('0' + (u % 10)); u /= 10;} while( u != 0 );
+  if( n < 0 ) *--p = '-';
+  write(p,(num+sizeof(num))-p);
+}
+
+/**
+ *  Plain text is scanned a run at a time and copied with a single write, so text without special characters 
+ *  (nearly all of it) costs one scan and one copy
+ */
+void ResponseStream::printEscaped(const char* s) {
+  if( s == NULL ) return;
+  while( *s != '\0' ) {
+    size_t n = plainRun(s);
+    if( n > 0 ) write(s,n);
+    s += n;
+    switch( *s ) {
+      case '\0': return;
+      case '&':  write("&amp;",5);  break;
+      case '<':  write("&lt;",4);   break;
+      case '>':  write("&gt;",4);   break;
+      case '"':  write("&quot;",6); break;
+      default:   write("&#39;",5);
+    }
+    s++;
+  }
+}
+
+void ResponseStream::printJson(const char* s) {
+  write('"');
+  for( ; (s != NULL) && (*s != '\0'); s++ ) {
+    switch( *s ) {
+      case '"':  write("\\\"",2); break;
+      case '\\': write("\\\\",2); break;
+      case '\n': write("\\n",2);  break;
+      case '\r': write("\\r",2);  break;
+      case '\t': write("\\t",2);  break;
+      default:
+        if( ((uint8_t)*s < 0x20) || (*s == '<') ) {
+          char esc[8];
+          snprintf(esc,sizeof(esc),"\\u%04x",(unsigned)(uint8_t)*s);
+          write(esc,6);
+        }
+        else write(*s);
+    }
+  }
+  write('"');
+}
+
+/**
+ *  A value directly after a key, or first at its depth, takes no comma
+ */
+void JsonWriter::separate() {
+  if( _afterKey ) {
+    _afterKey = false;
+    return;
+  }
+  if( _depth == 0 ) return;
+  uint32_t bit = 1u << (_depth-1);
+  if( _first & bit ) _first &= ~bit;
+  else _out.write(',');
+}
+
+void ResponseStream::printf_P(PGM_P format, ...) {
+  va_list args;
+  va_start(args,format);
+  vprintf_P(format,args);
+  va_end(args);
+}
+
+void ResponseStream::formatBuffer_P(PGM_P format, ...) {
+  va_list args;
+  va_start(args,format);
+  vprintf_P(format,args);
+  va_end(args);
+}
+
+void ResponseStream::printHtml_P(PGM_P format, ...) {
+  va_list args;
+  va_start(args,format);
+  vprintHtml_P(format,args);
+  va_end(args);
+}
+
+/**
+ *  Page templates take only text and small integers, so the format is scanned for the next '%' and the literal 
+ *  run before it is copied in one block, with no conversion specification to parse
+ */
+void ResponseStream::vprintHtml_P(PGM_P format, va_list args) {
+  for(;;) {
+    size_t n = literalRun(format);
+    if( n > 0 ) write_P(format,n);
+    format += n;
+    if( pgm_read_byte(format) == '\0' ) return;
+    char c = (char)pgm_read_byte(++format);
+    switch( c ) {
+      case 's':  printEscaped(va_arg(args,const char*)); break;
+      case 'd':  print((long)va_arg(args,int));          break;
+      case '%':  write('%');                             break;
+      case '\0': write('%'); return;
+      default:   write('%'); write(c);
+    }
+    format++;
+  }
+}
+
+/**
+ *  Literal text is copied straight from the (PROGMEM) format. Each conversion is formatted on its own: %s arguments
+ *  are written directly, so they are never truncated, and numeric conversions are rendered by snprintf into a small
+ *  scratch buffer using the original conversion specification.
+ */
+void ResponseStream::vprintf_P(PGM_P format, va_list args) {
+  char c;
+  while( (c = (char)pgm_read_byte(format)) != '\0' ) {
+    if( c != '%' ) {
+      write(c);
+      format++;
+      continue;
+    }
+
+/**
+ *  Collect the conversion specification: %[flags][width][.precision][length]conversion
+ */
+    char spec[40];
+    int  n         = 0;
+    int  precision = -1;
+    int  longs     = 0;
+    spec[n++] = (char)pgm_read_byte(format++);
+    while( ((c = (char)pgm_read_byte(format)) != '\0') && (strchr("-+ #0",c) != NULL) && (n < 8) ) {spec[n++] = c; format++;}
+    if( c == '*' ) {n += snprintf(spec+n,12,"%d",va_arg(args,int)); c = (char)pgm_read_byte(++format);}
+    while( isdigit(c) && (n < 20) ) {spec[n++] = c; c = (char)pgm_read_byte(++format);}
+    if( c == '.' ) {
+      precision = 0;
+      spec[n++] = c;
+      c = (char)pgm_read_byte(++format);
+      if( c == '*' ) {precision = va_arg(args,int); n += snprintf(spec+n,12,"%d",precision); c = (char)pgm_read_byte(++format);}
+      else while( isdigit(c) ) {precision = precision*10 + (c-'0'); if(n < 32) spec[n++] = c; c = (char)pgm_read_byte(++format);}
+    }
+    while( (c == 'l') || (c == 'h') || (c == 'z') ) {
+      if( c == 'l' ) longs++;
+      if( n < 36 ) spec[n++] = c;
+      c = (char)pgm_read_byte(++format);
+    }
+    if( c == '\0' ) break;
+    format++;
+    spec[n++] = c;
+    spec[n]   = '\0';
+
+    char num[32];
+    int  len = 0;
+    switch( c ) {
+      case '%':
+        write('%');
+        break;
+      case 's': {
+        const char* s = va_arg(args,const char*);
+        if( s == NULL ) s = "(null)";
+        if( n == 2 ) print(s);                                                   // Plain %s, the common case
+        else {
+          size_t  slen  = ((precision >= 0)?(strnlen(s,precision)):(strlen(s)));
+          int     width = atoi(spec+1+strspn(spec+1,"-+ #0"));
+          boolean left  = (strchr(spec,'-') != NULL);
+          for( int i=(int)slen; !left && (i<width); i++ ) write(' ');
+          write(s,slen);
+          for( int i=(int)slen; left && (i<width); i++ ) write(' ');
+        }
+        break;
+      }
+      case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'c':
+        if( longs >= 2 )      len = snprintf(num,sizeof(num),spec,va_arg(args,long long));
+        else if( longs == 1 ) len = snprintf(num,sizeof(num),spec,va_arg(args,long));
+        else                  len = snprintf(num,sizeof(num),spec,va_arg(args,int));
+        break;
+      case 'f': case 'e': case 'E': case 'g': case 'G':
+        len = snprintf(num,sizeof(num),spec,va_arg(args,double));
+        break;
+      case 'p':
+        len = snprintf(num,sizeof(num),spec,va_arg(args,void*));
+        break;
+      default:
+        write(spec,n);
+    }
+    if( len > 0 ) write(num,((len < (int)sizeof(num))?(len):((int)sizeof(num)-1)));
+  }
+}
+
+/**
+ *  Copies s into buffer with the characters printEscaped() replaces replaced by the same entities, stopping before an
+ *  entity or character that does not fit
+ */
+static void escapeInto(char buffer[], size_t size, const char* s) {
+  size_t pos = 0;
+  for( ; (s != NULL) && (*s != '\0'); s++ ) {
+    const char* entity;
+    switch( *s ) {
+      case '&':  entity = "&amp;";  break;
+      case '<':  entity = "&lt;";   break;
+      case '>':  entity = "&gt;";   break;
+      case '"':  entity = "&quot;"; break;
+      case '\'': entity = "&#39;";  break;
+      default:   entity = NULL;
+    }
+    size_t n = ((entity != NULL)?(strlen(entity)):(1));
+    if( pos+n >= size ) break;
+    if( entity != NULL ) memcpy(buffer+pos,entity,n);
+    else buffer[pos] = *s;
+    pos += n;
+  }
+  buffer[pos] = '\0';
+}
+
+/**
+ *  The header is CommonProgmem's, rendered into the stream's own buffer, so pages follow the library's header markup
+ */
+void ResponseStream::formatHeader(const char* title) {
+  char escaped[HEADER_TITLE_SIZE];
+  escapeInto(escaped,sizeof(escaped),title);
+  int   size;
+  char* buffer = reserve(size);
+  lsc::formatHeader(buffer,size,escaped);
+  commit();
+}
+
+void ResponseStream::formatTail() {print_P(html_tail);}
+
+void RenderCache::clear() {
+  free(_data);
+  _data   = NULL;
+  _length = 0;
+  _valid  = false;
+}
+
+/**
+ *  Content is captured from out's own buffer, growing the cache a flushed block at a time (usually once). If memory 
+ *  runs out the content is rendered straight to out instead, and the cache is left empty.
+ */
+void RenderCache::write(ResponseStream& out, uint32_t version, RenderFunction render) {
+  if( !_enabled ) {render(out); return;}
+  if( !_valid || (_version != version) ) {
+    clear();
+    boolean failed = false;
+    out.beginCapture([this,&failed](const char* data, size_t len) {
+      if( failed ) return;
+      char* d = (char*)realloc(_data,_length+len);
+      if( d == NULL ) {failed = true; return;}
+      memcpy(d+_length,data,len);
+      _data    = d;
+      _length += len;
+    });
+    render(out);
+    out.endCapture();
+    if( failed ) {
+      clear();
+      render(out);
+      return;
+    }
+    _version = version;
+    _valid   = true;
+  }
+  out.write(_data,_length);
+}
+
+} // End of namespace lsc
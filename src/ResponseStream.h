@@ -0,0 +1,228 @@
+/**
+ *
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published
+ *  by the Free Software Foundation, either version 3 of the License, or any
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  The author can be contacted at dan@leelanausoftware.com
+ *
+ */
+
+#ifndef RESPONSE_STREAM_H
+#define RESPONSE_STREAM_H
+
+#include <Arduino.h>
+#include <WebContext.h>
+#include <CommonProgmem.h>
+
+/** Leelanau Software Company namespace
+*
+*/
+namespace lsc {
+
+/**
+ *   Bytes buffered before a chunk is sent. This is also the largest block a legacy content(char buffer[], int size)
+ *   implementation may render into, so it matches the largest of the former fixed display buffers.
+ */
+#ifndef STREAM_BUFFER_SIZE
+#define STREAM_BUFFER_SIZE 1000
+#endif
+
+/**
+ *   Largest page title formatHeader() writes, once escaped; a longer title is cut before the entity or character that
+ *   would not fit.
+ */
+#ifndef HEADER_TITLE_SIZE
+#define HEADER_TITLE_SIZE  256
+#endif
+
+typedef std::function<void(const char* data, size_t len)> StreamFunction;
+
+/** ResponseStream class definition
+ *  A ResponseStream renders a response incrementally through a single fixed buffer, so peak memory is bounded by
+ *  STREAM_BUFFER_SIZE no matter how large the page is, and output is never truncated. Full buffers are sent as
+ *  chunks of a chunked (Transfer-Encoding: chunked) response through WebContext, or handed to a StreamFunction.
+ *  Class members are as follows:
+ *    begin(code,contentType)      := Sends response headers for a chunked response. Must precede any output when
+ *                                    streaming to a WebContext
+ *    end()                        := Sends any buffered output and terminates the response; called by the destructor
+ *    write(data,len)              := Appends len bytes
+ *    write_P(s,len)               := Appends len bytes from PROGMEM
+ *    print(s)/print_P(s)          := Appends a null terminated string from RAM/PROGMEM
+ *    printEscaped(s)              := Appends s with the XML/HTML special characters &, <, >, " and ' replaced by entities,
+ *                                    for user supplied text such as display names. Runs of plain text are copied whole
+ *    printJson(s)                 := Appends s as a quoted JSON string, escaping quotes, backslashes and control characters,
+ *                                    and < so that the string is also a safe JavaScript literal inside a <script> element
+ *    printf_P(format,...)         := printf from a PROGMEM format. Supports the flags, width, precision and length
+ *                                    modifiers of printf; %s arguments are copied directly rather than formatted
+ *    printHtml_P(format,...)      := Appends a PROGMEM page template, copying the literal text between conversions in
+ *                                    blocks. Conversions are %s (text, escaped as by printEscaped), %d (int) and %%;
+ *                                    anything else is copied as is. The library's own pages are PAGE_TEMPLATEs (see 
+ *                                    PageTemplate.h); this is for sketch templates only known at run time that carry a
+ *                                    display name, message or other user supplied text
+ *    formatHeader(title)          := Streaming forms of the CommonProgmem buffer formatters, so handlers written
+ *    formatBuffer_P(format,...)      against formatHeader/formatBuffer_P/formatTail translate one for one. formatHeader()
+ *    formatTail()                    calls CommonProgmem's formatHeader() with the title escaped
+ *    reserve(size)                := Flushes and returns the (empty) internal buffer and its size, for legacy code
+ *    commit()                        that renders into a char buffer; commit() appends what was rendered there
+ *    bytesWritten()               := Total bytes written to the stream
+ */
+class ResponseStream {
+  public:
+    ResponseStream(WebContext* svr) : _svr(svr) {}
+    ResponseStream(StreamFunction f) : _sink(f) {}
+    ~ResponseStream() {end();}
+
+    void         begin(int code, const char* contentType);
+    void         end();
+    void         flush();
+
+    void         write(const char* data, size_t len)      {if( len <= sizeof(_buffer)-_pos ) {memcpy(_buffer+_pos,data,len); _pos += len; _written += len;} else writeBlocks(data,len);}
+    void         write_P(PGM_P s, size_t len);
+    void         write(char c)                            {if( _pos >= sizeof(_buffer) ) flush(); _buffer[_pos++] = c; _written++;}
+    void         print(const char* s)                     {if( s != NULL ) write(s,strlen(s));}
+    void         print_P(PGM_P s);
+    void         print(long n);
+    void         printEscaped(const char* s);
+    void         printJson(const char* s);
+    void         printf_P(PGM_P format, ...);
+    void         vprintf_P(PGM_P format, va_list args);
+    void         printHtml_P(PGM_P format, ...);
+    void         vprintHtml_P(PGM_P format, va_list args);
+
+    void         formatHeader(const char* title);
+    void         formatBuffer_P(PGM_P format, ...);
+    void         formatTail();
+
+    char*        reserve(int& size)                       {flush(); _buffer[0] = '\0'; size = sizeof(_buffer); return _buffer;}
+    void         commit()                                 {_pos = strnlen(_buffer,sizeof(_buffer)); _written += _pos;}
+
+    size_t       bytesWritten()                           {return _written;}
+
+/**
+ *   Copy construction and destruction are not allowed
+ */
+    ResponseStream(const ResponseStream&)= delete;
+    ResponseStream& operator=(const ResponseStream&)= delete;
+
+  private:
+    void         writeBlocks(const char* data, size_t len);
+
+/**
+ *   Capture, for RenderCache: output is handed to the capture function instead of the response until endCapture(),
+ *   and is not counted in bytesWritten()
+ */
+    friend class RenderCache;
+    void         beginCapture(StreamFunction f)           {flush(); _capture = f; _mark = _written;}
+    void         endCapture()                             {flush(); _capture = NULL; _written = _mark;}
+
+    WebContext*     _svr     = NULL;
+    StreamFunction  _sink    = NULL;
+    StreamFunction  _capture = NULL;
+    size_t          _mark    = 0;                  // bytesWritten() when capture began
+    boolean         _started = false;
+    boolean         _ended   = false;
+    size_t          _pos     = 0;
+    size_t          _written = 0;
+    char            _buffer[STREAM_BUFFER_SIZE];
+};
+
+/** JsonWriter class definition
+ *  A JsonWriter streams a JSON document through a ResponseStream as it is described, placing the commas and colons, so 
+ *  JSON of any size is written with no more memory than the stream's buffer. Nesting is tracked one bit per level, up to 
+ *  JSON_MAX_DEPTH levels.
+ *  Class members are as follows:
+ *    beginObject()/endObject()    := Opens/closes an object
+ *    beginArray()/endArray()      := Opens/closes an array
+ *    key(name)                    := Names the next value, which must follow, in the current object
+ *    value(s)/value(n)/value(b)   := Writes a string (NULL as null), number or boolean
+ *    member(name,value)           := key(name) followed by value(value)
+ */
+#define JSON_MAX_DEPTH 32
+
+class JsonWriter {
+  public:
+    JsonWriter(ResponseStream& out) : _out(out) {}
+
+    void         beginObject()                            {open('{');}
+    void         endObject()                              {close('}');}
+    void         beginArray()                             {open('[');}
+    void         endArray()                               {close(']');}
+    void         key(const char* name)                    {separate(); _out.printJson(name); _out.write(':'); _afterKey = true;}
+    void         value(const char* s)                     {separate(); if( s != NULL ) _out.printJson(s); else _out.write("null",4);}
+    void         value(long n)                            {separate(); _out.print(n);}
+    void         value(int n)                             {value((long)n);}
+    void         value(boolean b)                         {separate(); if( b ) _out.write("true",4); else _out.write("false",5);}
+    template<typename T>
+    void         member(const char* name, T v)            {key(name); value(v);}
+
+/**
+ *   Copy construction and destruction are not allowed
+ */
+    JsonWriter(const JsonWriter&)= delete;
+    JsonWriter& operator=(const JsonWriter&)= delete;
+
+  private:
+    void         separate();
+    void         open(char c)                             {separate(); _out.write(c); if( _depth < JSON_MAX_DEPTH ) _depth++; _first |= (1u << (_depth-1));}
+    void         close(char c)                            {_out.write(c); if( _depth > 0 ) _depth--; _afterKey = false;}
+
+    ResponseStream& _out;
+    uint32_t        _first    = 0;              // Bit n set while nothing has been written at depth n+1
+    uint8_t         _depth    = 0;
+    boolean         _afterKey = false;
+};
+
+/** RenderCache class definition
+ *  A RenderCache holds the output of a rendering function on the heap, keyed by a version number, so that content which 
+ *  has not changed is copied into a response rather than formatted again. Caching is off until enabled. Content is 
+ *  captured through the response's own stream buffer, so caching takes no more stack than rendering directly.
+ *  Objects key their content with stateVersion()+hierarchyVersion() (see UPnPObject): both only increase, so the sum 
+ *  changes whenever either does.
+ *  Class members are as follows:
+ *    setEnabled(flag)              := Turns caching on or off; turning it off frees the cached bytes
+ *    write(out,version,render)     := Writes the cached bytes to out if they were rendered at version, otherwise calls render 
+ *                                     to capture new content and writes that. When disabled, render writes directly to out.
+ *    clear()                       := Frees the cached bytes
+ */
+typedef std::function<void(ResponseStream& out)> RenderFunction;
+
+class RenderCache {
+  public:
+    RenderCache() {}
+    ~RenderCache() {clear();}
+
+    boolean      enabled()                                {return _enabled;}
+    void         setEnabled(boolean flag)                 {_enabled = flag; if( !flag ) clear();}
+    void         write(ResponseStream& out, uint32_t version, RenderFunction render);
+    void         clear();
+
+/**
+ *   Copy construction and destruction are not allowed
+ */
+    RenderCache(const RenderCache&)= delete;
+    RenderCache& operator=(const RenderCache&)= delete;
+
+  private:
+    char*        _data     = NULL;
+    size_t       _length   = 0;
+    uint32_t     _version  = 0;
+    boolean      _valid    = false;
+    boolean      _enabled  = false;
+};
+
+} // End of namespace lsc
+
+#endif
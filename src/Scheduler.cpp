@@ -0,0 +1,227 @@
+/**
+ * 
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+#include "Scheduler.h"
+#include "UPnPDevice.h"
+
+/** Leelanau Software Company namespace 
+*  
+*/
+namespace lsc {
+
+Scheduler::~Scheduler() {
+  free(_timers);
+  free(_slots);
+}
+
+/**
+ *  Every loop devices run first, then devices that have come due, within what is left of the budget. Devices with a 
+ *  period run every loop if memory for the wheel cannot be had, and all devices do if memory for their timers cannot.
+ */
+void Scheduler::run(RootDevice* root) {
+  unsigned long start = micros();
+  if( !track(root) ) {
+    for( int i=0; i<root->numDevices(); i++ ) {root->device(i)->doDevice();}
+    return;
+  }
+  if( _rebuild ) rebuild();
+  for( int i=0; (i<_numTimers) && (_everyLoop > 0); i++ ) {if( (_timers[i].period == 0) || (_slots == NULL) ) _timers[i].device->doDevice();}
+  if( _slots != NULL ) {
+    advance();
+    runReady(start);
+  }
+  _loops++;
+  uint32_t elapsed = (uint32_t)(micros()-start);
+  if( elapsed > _maxLoopTime ) _maxLoopTime = elapsed;
+}
+
+const ScheduleStats* Scheduler::stats(UPnPDevice* dvc) {
+  for( int i=0; i<_numTimers; i++ ) {if( _timers[i].device == dvc ) return &_timers[i].stats;}
+  return NULL;
+}
+
+int Scheduler::pending() {
+  int result = 0;
+  for( uint16_t t=_readyHead; t!=0; t=_timers[t-1].next ) result++;
+  return result;
+}
+
+/**
+ *  Adds a timer for each device added to root since the last call; returns false if memory is exhausted
+ */
+boolean Scheduler::track(RootDevice* root) {
+  int n = root->numDevices();
+  if( n == _numTimers ) return true;
+  Timer* timers = (Timer*)realloc(_timers,n*sizeof(Timer));
+  if( timers == NULL ) return false;
+  for( int i=_numTimers; i<n; i++ ) {
+    memset(&timers[i],0,sizeof(Timer));
+    timers[i].device = root->device(i);
+  }
+  _timers    = timers;
+  _numTimers = n;
+  _rebuild   = true;
+  return true;
+}
+
+/**
+ *  Reads every device's period and places the timers again. A device whose period changed, or that is new, is first due 
+ *  one period from now; the others keep their due time.
+ */
+void Scheduler::rebuild() {
+  _rebuild   = false;
+  _everyLoop = 0;
+  for( int i=0; i<_numTimers; i++ ) {
+    Timer&   t = _timers[i];
+    uint32_t p = ticks(t.device->period());
+    if( !t.scheduled || (p != t.period) ) {
+      t.period    = p;
+      t.due       = _tick + p;
+      t.scheduled = true;
+    }
+    if( p == 0 ) _everyLoop++;
+  }
+  if( (_everyLoop == _numTimers) && (_slots == NULL) ) return;
+  if( _slots == NULL ) {
+    _slots = (uint16_t*)malloc(WHEEL_LEVELS*WHEEL_SLOTS*sizeof(uint16_t));
+    if( _slots == NULL ) {
+      _everyLoop = _numTimers;
+      return;
+    }
+    _lastMillis = (uint32_t)millis();
+  }
+  memset(_slots,0,WHEEL_LEVELS*WHEEL_SLOTS*sizeof(uint16_t));
+  _readyHead = _readyTail = 0;
+  for( int i=0; i<_numTimers; i++ ) {if( _timers[i].period > 0 ) insert(i+1);}
+}
+
+/**
+ *  Steps the wheel one tick at a time up to millis(), carrying any remainder to the next call
+ */
+void Scheduler::advance() {
+  uint32_t n = ((uint32_t)millis()-_lastMillis)/SCHEDULER_TICK;
+  _lastMillis += n*SCHEDULER_TICK;
+  while( n-- > 0 ) step();
+}
+
+/**
+ *  When level 0 wraps, the next level 1 slot is spread over level 0 (after level 2 is spread over level 1, when level 1 
+ *  wraps too). The level 0 slot for the new tick then holds exactly the timers due now.
+ */
+void Scheduler::step() {
+  _tick++;
+  uint32_t i0 = _tick & WHEEL_MASK;
+  if( i0 == 0 ) {
+    uint32_t i1 = (_tick >> WHEEL_BITS) & WHEEL_MASK;
+    if( i1 == 0 ) cascade(2,(_tick >> 2*WHEEL_BITS) & WHEEL_MASK);
+    cascade(1,i1);
+  }
+  uint16_t t = _slots[i0];
+  _slots[i0] = 0;
+  while( t != 0 ) {
+    uint16_t next = _timers[t-1].next;
+    ready(t);
+    t = next;
+  }
+}
+
+/**
+ *  A timer goes in the lowest level whose span reaches its due tick, in the slot that level visits at that tick. A timer
+ *  beyond level 2 goes in the last level 2 slot and is placed again when that slot is reached.
+ */
+void Scheduler::insert(uint16_t t) {
+  Timer&    timer = _timers[t-1];
+  int32_t   delta = (int32_t)(timer.due - _tick);
+  uint16_t* slot;
+  if( delta <= 0 ) {
+    ready(t);
+    return;
+  }
+  if( delta < WHEEL_SLOTS ) slot = &_slots[timer.due & WHEEL_MASK];
+  else if( (timer.due >> WHEEL_BITS) - (_tick >> WHEEL_BITS) < WHEEL_SLOTS ) slot = &_slots[WHEEL_SLOTS + ((timer.due >> WHEEL_BITS) & WHEEL_MASK)];
+  else if( (timer.due >> 2*WHEEL_BITS) - (_tick >> 2*WHEEL_BITS) < WHEEL_SLOTS ) slot = &_slots[2*WHEEL_SLOTS + ((timer.due >> 2*WHEEL_BITS) & WHEEL_MASK)];
+  else slot = &_slots[2*WHEEL_SLOTS + (((_tick >> 2*WHEEL_BITS) + WHEEL_MASK) & WHEEL_MASK)];
+  timer.next = *slot;
+  *slot      = t;
+}
+
+void Scheduler::cascade(int level, uint32_t index) {
+  uint16_t* slot = &_slots[level*WHEEL_SLOTS + index];
+  uint16_t  t    = *slot;
+  *slot = 0;
+  while( t != 0 ) {
+    uint16_t next = _timers[t-1].next;
+    insert(t);
+    t = next;
+  }
+}
+
+void Scheduler::ready(uint16_t t) {
+  _timers[t-1].next = 0;
+  if( _readyTail != 0 ) _timers[_readyTail-1].next = t;
+  else _readyHead = t;
+  _readyTail = t;
+}
+
+/**
+ *  Runs due devices in the order they came due until the budget is spent. A device's next run is one period after the 
+ *  run it was due for, so the cadence does not drift; periods already passed while it waited are skipped, not made up.
+ */
+void Scheduler::runReady(unsigned long start) {
+  boolean ran = false;
+  while( _readyHead != 0 ) {
+    if( ran && ((uint32_t)(micros()-start) >= _budget*1000) ) {
+      for( uint16_t t=_readyHead; t!=0; t=_timers[t-1].next ) _timers[t-1].stats.deferred++;
+      _overruns++;
+      return;
+    }
+    uint16_t t     = _readyHead;
+    Timer&   timer = _timers[t-1];
+    _readyHead = timer.next;
+    if( _readyHead == 0 ) _readyTail = 0;
+    ran = runDevice(timer) || ran;
+    timer.due += timer.period*((_tick-timer.due)/timer.period + 1);
+    insert(t);
+  }
+}
+
+/**
+ *  Returns false, without running the device, if it is later than its deadline
+ */
+boolean Scheduler::runDevice(Timer& t) {
+  uint32_t late     = (_tick-t.due)*SCHEDULER_TICK;
+  uint32_t deadline = t.device->deadline();
+  if( (deadline > 0) && (late > deadline) ) {
+    t.stats.missed++;
+    return false;
+  }
+  unsigned long begin = micros();
+  t.device->doDevice();
+  uint32_t runtime = (uint32_t)(micros()-begin);
+  t.stats.runs++;
+  t.stats.totalLateness += late;
+  if( late > t.stats.maxLateness )   t.stats.maxLateness = late;
+  if( runtime > t.stats.maxRuntime ) t.stats.maxRuntime  = runtime;
+  return true;
+}
+
+} // End of namespace lsc
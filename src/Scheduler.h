@@ -0,0 +1,154 @@
+/**
+ * 
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+#ifndef UPNP_SCHEDULER_H
+#define UPNP_SCHEDULER_H
+
+#include <Arduino.h>
+
+/** Leelanau Software Company namespace 
+*  
+*/
+namespace lsc {
+
+/**
+ *   Scheduler limits, either of which can be overridden at compile time:
+ *     SCHEDULER_TICK      := Milliseconds per timer wheel tick, the resolution of periods, deadlines and lateness
+ *     SCHEDULER_BUDGET    := Milliseconds per RootDevice::doDevice() after which devices still due are deferred to the
+ *                            next call. At least one due device runs per call, so a slow device cannot starve the others.
+ *   The wheel has WHEEL_LEVELS levels of WHEEL_SLOTS slots, so with the default tick, level 0 spans 256ms, level 1 16s and 
+ *   level 2 17 minutes. Longer periods are held in level 2 and placed again as they come closer.
+ */
+#ifndef SCHEDULER_TICK
+#define SCHEDULER_TICK    4
+#endif
+#ifndef SCHEDULER_BUDGET
+#define SCHEDULER_BUDGET  20
+#endif
+#define WHEEL_BITS        6
+#define WHEEL_SLOTS       (1 << WHEEL_BITS)
+#define WHEEL_MASK        (WHEEL_SLOTS - 1)
+#define WHEEL_LEVELS      3
+
+class UPnPDevice;
+class RootDevice;
+
+/** ScheduleStats
+ *  Per device scheduling statistics, kept for devices with a period.
+ *  Class members are as follows:
+ *    runs           := Number of times doDevice() was called
+ *    missed         := Runs skipped because the device was found later than its deadline
+ *    deferred       := Times the device was due but left for the next loop because the loop budget was spent
+ *    maxLateness    := Longest delay (ms) between the time a run was due and the time it started
+ *    totalLateness  := Sum of those delays, for meanLateness()
+ *    maxRuntime     := Longest doDevice() call (microseconds)
+ */
+struct ScheduleStats {
+  uint32_t  runs;
+  uint32_t  missed;
+  uint32_t  deferred;
+  uint32_t  maxLateness;
+  uint32_t  totalLateness;
+  uint32_t  maxRuntime;
+
+  uint32_t  meanLateness() const {return ((runs>0)?(totalLateness/runs):(0));}
+};
+
+/** Scheduler class definition
+ *  A Scheduler decides which of the devices of a RootDevice have their doDevice() called from the Arduino loop(). A device
+ *  with no period (UPnPDevice::setSchedule()) runs on every call, as it always has. A device with a period is held in a 
+ *  hierarchical timer wheel driven by millis(), so a loop in which nothing is due costs a few slot checks no matter how 
+ *  many devices there are, and runs are kept to a fixed cadence rather than drifting by the time each loop takes. A device 
+ *  that falls further behind than its deadline skips that run, and devices due after the loop budget is spent wait for the
+ *  next loop, keeping the time taken away from request handling bounded.
+ *  Class members are as follows:
+ *    run(root)          := Calls doDevice() for the devices of root that are due. Called from RootDevice::doDevice().
+ *    reschedule()       := Picks up changed periods on the next run(); called by UPnPDevice::setSchedule()
+ *    setBudget(ms)      := Sets the loop budget, SCHEDULER_BUDGET by default
+ *    stats(dvc)         := Statistics for dvc, or NULL if dvc has not been scheduled
+ *    loops()            := Number of calls to run()
+ *    overruns()         := Calls to run() that spent the budget with devices still due
+ *    maxLoopTime()      := Longest call to run() (microseconds)
+ *    pending()          := Number of devices due but not yet run
+ *
+ *  Timers are allocated when devices are added, and the wheel when the first device is given a period.
+ */
+class Scheduler {
+  public:
+    Scheduler() {}
+    ~Scheduler();
+
+    void                  run(RootDevice* root);
+    void                  reschedule()                 {_rebuild = true;}
+    void                  setBudget(uint32_t ms)       {_budget = ms;}
+    uint32_t              budget()                     {return _budget;}
+    const ScheduleStats*  stats(UPnPDevice* dvc);
+    uint32_t              loops()                      {return _loops;}
+    uint32_t              overruns()                   {return _overruns;}
+    uint32_t              maxLoopTime()                {return _maxLoopTime;}
+    int                   pending();
+
+/**
+ *   Copy construction and destruction are not allowed
+ */
+    Scheduler(const Scheduler&)= delete;
+    Scheduler& operator=(const Scheduler&)= delete;
+
+  private:
+    struct Timer {
+      UPnPDevice*     device;
+      uint32_t        period;                    // Ticks; 0 runs every loop
+      uint32_t        due;                       // Tick
+      uint16_t        next;                      // Next timer in its slot or the ready list, as index+1; 0 ends the list
+      boolean         scheduled;                 // False until the period is first read from the device
+      ScheduleStats   stats;
+    };
+
+    boolean               track(RootDevice* root);
+    void                  rebuild();
+    void                  advance();
+    void                  step();
+    void                  insert(uint16_t t);
+    void                  cascade(int level, uint32_t index);
+    void                  ready(uint16_t t);
+    void                  runReady(unsigned long start);
+    boolean               runDevice(Timer& t);
+    static uint32_t       ticks(uint32_t ms)           {return ((ms == 0)?(0):((ms+SCHEDULER_TICK-1)/SCHEDULER_TICK));}
+
+    Timer*                _timers      = NULL;
+    int                   _numTimers   = 0;
+    int                   _everyLoop   = 0;        // Timers run on every loop
+    uint16_t*             _slots       = NULL;     // WHEEL_LEVELS*WHEEL_SLOTS list heads
+    uint16_t              _readyHead   = 0;
+    uint16_t              _readyTail   = 0;
+    boolean               _rebuild     = false;
+    uint32_t              _tick        = 0;
+    uint32_t              _lastMillis  = 0;
+    uint32_t              _budget      = SCHEDULER_BUDGET;
+    uint32_t              _loops       = 0;
+    uint32_t              _overruns    = 0;
+    uint32_t              _maxLoopTime = 0;
+};
+
+} // End of namespace lsc
+
+#endif
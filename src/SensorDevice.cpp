@@ -29,20 +29,34 @@ INITIALIZE_UPnP_TYPE(Sensor,urn:LeelanauSoftware-com:device:Sensor:1);
 
 Sensor::Sensor() : UPnPDevice("sensor") {
   addServices(getConfiguration(),setConfiguration());   // Add services for configuration
+  eventDisplayName(getConfiguration());                 // Subscribers are told of display name changes
   setDisplayName("Sensor");                             // Set the eisplay name
 }
 
 Sensor::Sensor(const char* target) : UPnPDevice(target) {
   addServices(getConfiguration(),setConfiguration());   // Add services configuration
+  eventDisplayName(getConfiguration());                 // Subscribers are told of display name changes
   setDisplayName("Sensor");                             // Set the eisplay name
 }
 
+void Sensor::content(ResponseStream& out) {
+  int   size;
+  char* buffer = out.reserve(size);
+  content(buffer,size);
+  out.commit();
+}
+
+void Sensor::renderContent(ResponseStream& out) {
+  _renderCache.write(out,stateVersion()+hierarchyVersion(),[this](ResponseStream& s){this->content(s);});
+}
+
 void Sensor::display(WebContext* svr) {
-  char buffer[500];
-  int size = sizeof(buffer);
-  int pos = formatHeader(buffer,size,getDisplayName());
-  content(buffer+pos,size-pos);
-  pos = strlen(buffer);
+  ResponseStream out(svr);
+  out.begin(200,"text/html");
+  out.formatHeader(getDisplayName());
+  EventStream::beginFragment(out,this);
+  renderContent(out);
+  EventStream::endFragment(out);
  
 /** 
  *  Parent of a Sensor is a RootDevice and thus is non-null and provides a complete path
@@ -50,10 +64,10 @@ void Sensor::display(WebContext* svr) {
  */
   char pathBuff[100];
   setConfiguration()->formPath(pathBuff,100);
-  pos = formatBuffer_P(buffer,size,pos,config_button,pathBuff,"Configure"); 
-   
-  formatTail(buffer,size,pos);
-  svr->send(200,"text/html",buffer);
+  ConfigButton::render(out,pathBuff,"Configure"); 
+  RootDevice* root = rootDevice();
+  if( root != NULL ) EventStream::formatScript(out,root);
+  out.formatTail();
 }
 
 }
@@ -78,8 +78,18 @@ class Sensor : public UPnPDevice {
  *                           buffer. Base Sensor class provides implementation for display(),
  *                           which uses content(), so this method must be implemented.
  *    
+ *  Sensors with large content may also implement content(ResponseStream&), which writes the reading
+ *  directly into the response. The default renders content(buffer,size) into a block of at most
+ *  STREAM_BUFFER_SIZE bytes.
+ *
+ *  Content can be cached: after setRenderCache(true), renderContent() serves the bytes of the last content() call until 
+ *  stateVersion() changes (on setDisplayName(), a SetConfiguration request, or markDirty()) or the hierarchy changes. 
+ *  Sensors that enable the cache must call markDirty() whenever anything content() renders changes.
  */
       virtual void       content(char buffer[], int bufferSize) = 0;
+      virtual void       content(ResponseStream& out);
+      void               renderContent(ResponseStream& out);
+      void               setRenderCache(boolean flag)       {_renderCache.setEnabled(flag);}
       
       virtual void       display(WebContext* svr);
 
@@ -106,6 +116,7 @@ class Sensor : public UPnPDevice {
 
       GetConfiguration     _getConfiguration;
       SetConfiguration     _setConfiguration;
+      RenderCache          _renderCache;
 
 };
 
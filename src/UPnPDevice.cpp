@@ -24,6 +24,16 @@
 #include "SensorDevice.h"
 #include "Control.h"
 
+/**
+ *  Optional gzip compressed copies of static assets, generated by extras/tools/gzip_assets.py
+ */
+#if defined(__has_include)
+#if __has_include("GzipAssets.h")
+#include "GzipAssets.h"
+#define HAS_GZIP_ASSETS
+#endif
+#endif
+
 /** Leelanau Software Company namespace 
 *  
 */
@@ -37,123 +47,167 @@ INITIALIZE_STATIC_TYPE(RootDevice);
 INITIALIZE_UPnP_TYPE(UPnPDevice,urn:LeelanauSoftware-com:device:Basic:1);
 INITIALIZE_UPnP_TYPE(RootDevice,urn:LeelanauSoftware-com:device:RootDevice:1);
 
-void getRandomBytes(unsigned char *a, int len) {for(int i=0; i<len; i++ ) a[i] = (unsigned char) rand()%255;}
+/**
+ *  UPnP device description templates. URLs are paths relative to the description URL, so the document does not
+ *  depend on the interface address it is served from.
+ */
+const char description_head[]    PROGMEM = "<?xml version=\"1.0\"?>\r\n<root xmlns=\"urn:schemas-upnp-org:device-1-0\">"
+                                           "<specVersion><major>1</major><minor>0</minor></specVersion>";
+const char description_tail[]    PROGMEM = "</root>\r\n";
+const char device_description[]  PROGMEM = "</friendlyName><manufacturer>Leelanau Software Company</manufacturer>"
+                                           "<modelName>UPnPDevice</modelName><UDN>uuid:%s</UDN>";
 
-void generateUUID(char s[UUID_SIZE])
-{
-  unsigned char uuid[16];
-  getRandomBytes(uuid,16);
-  
-// Set UUID version to 4 --- truly random generation
-  uuid[6] = (uuid[6] & 0x0F) | 0x40;
-// Set the UUID variant to DCE 
-  uuid[8] = (uuid[8] & 0x3F) | 0x80;
-
-// A UUID string is of the form:
-// xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx
-// where x is a hex digit
-  sprintf(s,"%02x%02x%02x%02x-%02x%02x-%02x%02x-%02x%02x-%02x%02x%02x%02x%02x%02x",uuid[0],uuid[1],uuid[2],uuid[3],uuid[4],uuid[5],uuid[6],uuid[7],uuid[8],uuid[9],uuid[10],uuid[11],uuid[12],uuid[13],uuid[14],uuid[15]);
-  s[UUID_SIZE-1] = '\0';
-}
-
-/** Return true if the UUID is valid.
- *  A valid UUID is of the form:
- *  xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx
- *  where x is a hex digit
- * 
+/**
+ *  Request headers the library reads; the ESP Web servers keep only headers named with collectHeaders()
  */
-bool isValidUUID(String uuidStr)
-{
-  const char* uuid = uuidStr.c_str();
-  if( uuidStr.length() != UUID_SIZE-1 ) return false;
-
-  for (int i = 0; i < UUID_SIZE-1; i++) {
-    if (i == 8 || i == 13 || i == 18 || i == 23) {
-      if (uuid[i] != '-')
-        return false;
-    } else if (!isxdigit(uuid[i])) {
-      return false;
-    }
-  }
+static const char* collectedHeaders[] = {"If-None-Match","Accept-Encoding","Accept","SID","NT","CALLBACK","TIMEOUT"};
+
+/**
+ *  Sends 304 Not Modified and returns true if the request's If-None-Match header matches etag, which may be 
+ *  one of several listed or "*". Response headers (ETag, Cache-Control) must be sent first.
+ */
+static boolean notModified(WebContext* svr, const char* etag, PGM_P contentType) {
+  const String& match = svr->header("If-None-Match");
+  if( (match.length() == 0) || (etag[0] == '\0') ) return false;
+  if( (match != "*") && (strstr(match.c_str(),etag) == NULL) ) return false;
+  svr->send(304,contentType,"");
+  return true;
+}
+
+/**
+ *  Make room for one more pointer in a growable array, in steps of CAPACITY_INCREMENT up to max. 
+ *  Returns false if the array is full or memory is exhausted.
+ */
+template<typename T>
+static boolean ensureCapacity(T**& array, int& capacity, int count, int max) {
+  if( count < capacity ) return true;
+  if( capacity >= max ) return false;
+  int n = ((capacity+CAPACITY_INCREMENT < max)?(capacity+CAPACITY_INCREMENT):(max));
+  T** a = (T**)realloc(array,n*sizeof(T*));
+  if( a == NULL ) return false;
+  array    = a;
+  capacity = n;
   return true;
 }
 
 UPnPDevice::UPnPDevice() {
-  _uuid[0] = '\0';
   setDisplayName("Device");
 }
 
 UPnPDevice::UPnPDevice(const char* target) : UPnPObject(target) {
-  _uuid[0] = '\0';
   setDisplayName("Device");
 }
 
+UPnPDevice::~UPnPDevice() {
+  free(_services);
+  free(_uuidString);
+}
+
 void UPnPDevice::display(WebContext* svr) {
-  char buffer[DISPLAY_SIZE];
-  int size = sizeof(buffer);
-  int pos = formatHeader(buffer,size,getDisplayName());
-  char pathBuff[100];
-  for( int i=0; (i<_numServices) && (size>0); i++ ) {
+  ResponseStream out(svr);
+  out.begin(200,"text/html");
+  out.formatHeader(getDisplayName());
+  for( int i=0; i<_numServices; i++ ) {
     UPnPService* s = service(i);
-    if( s != NULL ) {
-       s->getPath(pathBuff,100);
-       pos = formatBuffer_P(buffer,size,pos,app_button,pathBuff,s->getDisplayName());
-    }
+    if( s != NULL ) AppButton::render(out,s->path(),s->getDisplayName());
   }
-  formatTail(buffer,size,pos);
-  svr->send(200,"text/html",buffer);
+  out.formatTail();
 }
 
 void UPnPDevice::setup(WebContext* svr) {
-  char pathBuffer[100];
-  pathBuffer[0] = '\0';
-  getPath(pathBuffer,100);
-  svr->on(pathBuffer,[this](WebContext* svr){this->display(svr);});
+  registerHandler(svr);
   for( int i=0; i<numServices(); i++ ) {service(i)->setup(svr);}
 }
 
+boolean UPnPDevice::dispatch(WebContext* svr, const char* handlerName) {
+  if( handlerName[0] != '\0' ) return false;
+  display(svr);
+  return true;
+}
+
+UPnPObject* UPnPDevice::child(const char* segment, size_t len, uint32_t hash) {
+  for( int i=0; i<_numServices; i++ ) {if( _services[i]->isTarget(segment,len,hash) ) return _services[i];}
+  return NULL;
+}
+
+void UPnPDevice::formatDescription(ResponseStream& out) {
+  out.printf_P(PSTR("<device><deviceType>%s</deviceType><friendlyName>"),getType());
+  out.printEscaped(getDisplayName());
+  out.printf_P(device_description,uuid());
+  if( numServices() > 0 ) {
+    out.print_P(PSTR("<serviceList>"));
+    for( int i=0; i<numServices(); i++ ) service(i)->formatDescription(out);
+    out.print_P(PSTR("</serviceList>"));
+  }
+  RootDevice* root = asRootDevice();
+  if( (root != NULL) && (root->numDevices() > 0) ) {
+    out.print_P(PSTR("<deviceList>"));
+    for( int i=0; i<root->numDevices(); i++ ) root->device(i)->formatDescription(out);
+    out.print_P(PSTR("</deviceList>"));
+  }
+  out.printf_P(PSTR("<presentationURL>%s</presentationURL></device>"),path());
+}
+
 /** Set UUID to uuid if uuid is valid
  *  returns true if uuid is valid and false otherwise
  */
 boolean UPnPDevice::setUUID( String uuid ) {
-  if( isValidUUID(uuid) ) {
-    strlcpy(_uuid, uuid.c_str(), sizeof(_uuid));
+  UUID id;
+  if( id.parse(uuid.c_str()) ) {
+    setUUID(id);
     return true;
   }
   else return false;
 }
 
+void UPnPDevice::setUUID(const UUID& id) {
+  _uuid    = id;
+  _uuidSet = !id.isNull();
+  _uuidGen = 0;
+  free(_uuidString);
+  _uuidString = NULL;
+  hierarchyChanged();
+  if( rootDevice() != NULL ) rootDevice()->invalidateIndex();
+}
+
+void UPnPDevice::eventDisplayName(UPnPService* svc) {
+  if( svc != NULL ) svc->setEventProperties([this](ResponseStream& out){UPnPService::formatProperty(out,"displayName",this->getDisplayName());});
+}
+
+/**
+ *  The RootDevice reads the new schedule on its next doDevice()
+ */
+void UPnPDevice::setSchedule(uint32_t period, uint32_t deadline) {
+  _period   = period;
+  _deadline = deadline;
+  RootDevice* root = rootDevice();
+  if( (root != NULL) && (root != this) ) root->scheduler()->reschedule();
+}
+
 /** Add a UPnPService to this device
  *  If a target hasn't been set yet, set a default target as "serviceN" where N is it's position in the _services array
  * 
  */
-void UPnPDevice::addService(UPnPService* svc) {
-  if( svc != NULL ) {
-     if(_numServices < MAX_SERVICES ) {
-         if( strlen(svc->_target) == 0 ) sprintf(svc->_target,"service%d",_numServices);
-         _services[_numServices++] = svc;
-         svc->setParent(this);
+boolean UPnPDevice::addService(UPnPService* svc) {
+  if( (svc == NULL) || !ensureCapacity(_services,_serviceCapacity,_numServices,MAX_SERVICES) ) return false;
+  if( strlen(svc->_target) == 0 ) {
+    char target[TARGET_SIZE];
+    snprintf(target,sizeof(target),"service%d",_numServices);
+    svc->setTarget(target);
+  }
+  _services[_numServices++] = svc;
+  svc->setParent(this);
+  if( rootDevice() != NULL ) rootDevice()->indexObject(svc);
 /**
- *     Late binding setup. If this device has already been added to a RootDevice, and setup() has 
- *     already been called on that RootDevice, any added service must also be setup();
+ *  Late binding setup. If this device has already been added to a RootDevice, and setup() has 
+ *  already been called on that RootDevice, any added service must also be setup();
  */
-       if(rootDevice() != NULL) {
-           if( rootDevice()->getContext() != NULL ) svc->setup(rootDevice()->getContext());
-       }
-     }
+  if(rootDevice() != NULL) {
+    if( rootDevice()->getContext() != NULL ) svc->setup(rootDevice()->getContext());
   }
+  return true;
 }
 
-void UPnPDevice::location(char buffer[], int buffSize, IPAddress ifc) {
-  UPnPObject* p = getParent();
-  if( p != NULL ) {
-    p->location(buffer,buffSize,ifc);
-    int pos = strlen(buffer);
-    int size = buffSize-pos;
-    snprintf(buffer+pos,size,"/%s",getTarget());
-  }
-  else snprintf(buffer, buffSize,"/%s",getTarget());
-}
 
 uint32_t getChipID() {
   uint32_t result = 0;
@@ -165,20 +219,62 @@ uint32_t getChipID() {
   return result;
 }
 
+/**
+ *  Namespace for device UUIDs, itself the version 5 UUID of the name "leelanausoftware.com" in the RFC 4122 DNS 
+ *  namespace (108e731d-5206-52ba-9968-043d31635ecc)
+ */
+static const uint8_t deviceNamespace[16] = {0x10,0x8e,0x73,0x1d,0x52,0x06,0x52,0xba,0x99,0x68,0x04,0x3d,0x31,0x63,0x5e,0xcc};
+
+/**
+ *  Device UUIDs not set explicitly are derived from the name "chipID/rootTarget/deviceTarget", where chipID is 8 hex digits
+ */
+/**
+ *  A derived UUID follows the path: it is derived again once the path generation has moved on, which also invalidates the
+ *  RootDevice index and the description, so neither keeps the old UUID
+ */
+const UUID& UPnPDevice::getUUID() {
+  if( !_uuidSet && (_uuidGen != pathGeneration()) ) {
+    UUID ns;
+    memcpy(ns.bytes(),deviceNamespace,16);
+    const char* p    = path();
+    size_t      size = strlen(p) + 9;
+    char*       name = (char*)malloc(size);
+    if( name != NULL ) {
+      snprintf(name,size,"%08x%s",(unsigned int)getChipID(),p);
+      UUID id;
+      id.nameBased(ns,name);
+      free(name);
+      if( !(id == _uuid) ) {
+        _uuid = id;
+        free(_uuidString);
+        _uuidString = NULL;
+      }
+      _uuidGen = pathGeneration();
+    }
+  }
+  return _uuid;
+}
+
+const char* UPnPDevice::uuid() {
+  getUUID();
+  if( _uuidString == NULL ) {
+    _uuidString = (char*)malloc(UUID_SIZE);
+    if( _uuidString == NULL ) return "";
+    getUUID().format(_uuidString);
+  }
+  return _uuidString;
+}
+
 void UPnPDevice::printInfo(UPnPDevice* d) {
   RootDevice* r = (RootDevice*)(d->asRootDevice());
   if( r != NULL ) Serial.printf("RootDevice %s:\n   UUID: %s\n   Type: %s\n",d->getDisplayName(),d->uuid(),d->getType());
   else Serial.printf("%s:\n   UUID: %s\n   Type: %s\n",d->getDisplayName(),d->uuid(),d->getType());
-  char buffer[128];
-  d->location(buffer,128,WiFi.localIP());
-  Serial.printf("   Location is %s\n",buffer);
+  Serial.printf("   Location is %s\n",d->getLocation(WiFi.localIP()));
   if( d->numServices() > 0 ) Serial.printf("   %s Services:\n",d->getDisplayName());
   else Serial.printf("   %s has no Services\n",d->getDisplayName());
   for(int i=0; i<d->numServices(); i++) {
     UPnPService* s = d->service(i);
-    buffer[0] = '\0';
-    s->location(buffer,128,WiFi.localIP());
-    Serial.printf("      %s:\n         Type: %s\n         Location is %s\n",s->getDisplayName(),s->getType(),buffer);
+    Serial.printf("      %s:\n         Type: %s\n         Location is %s\n",s->getDisplayName(),s->getType(),s->getLocation(WiFi.localIP()));
   }
   if( r != NULL ) {
     if( r->numDevices() > 0 ) Serial.printf("%s Devices:\n",r->getDisplayName());
@@ -188,44 +284,93 @@ void UPnPDevice::printInfo(UPnPDevice* d) {
 }
 
 RootDevice::RootDevice() : UPnPDevice("root") {
-  srand(getChipID());
-  generateUUID(_uuid);
   setDisplayName("Root Device");
 }
 
 RootDevice::RootDevice(const char* target) : UPnPDevice(target) {
-  srand(getChipID());
-  generateUUID(_uuid);
   setDisplayName("Root Device");
 }
 
+RootDevice::~RootDevice() {
+  free(_devices);
+  free(_objects.slots);
+  free(_children.slots);
+  free(_description);
+}
+
+#ifdef HAS_GZIP_ASSETS
+/**
+ *  True if Accept-Encoding lists gzip (or *) without q=0
+ */
+static boolean acceptsGzip(WebContext* svr) {
+  const char* accept = svr->header("Accept-Encoding").c_str();
+  const char* token  = strstr(accept,"gzip");
+  if( token == NULL ) token = strchr(accept,'*');
+  if( token == NULL ) return false;
+  const char* q = strchr(token,';');
+  const char* e = strchr(token,',');
+  if( (q == NULL) || ((e != NULL) && (e < q)) ) return true;
+  q = strstr(q,"q=");
+  return (q == NULL) || ((e != NULL) && (e < q)) || (atof(q+2) > 0);
+}
+#endif
+
+/**
+ *  The stylesheet is fixed at build time, so its ETag is the FNV-1a hash of styles_css, computed on the first request.
+ *  A gzip compressed copy, when built in, is served to clients that accept it, but only if it was generated from this 
+ *  styles_css. The two encodings are different representations, so each has its own ETag.
+ */
 void RootDevice::styles(WebContext* svr) {
-  svr->send_P(200,TEXT_CSS,styles_css);
+  static char    etag[16] = "";
+#ifdef HAS_GZIP_ASSETS
+  static boolean gzip     = false;
+#endif
+  if( etag[0] == '\0' ) {
+    uint32_t h = 2166136261u;
+    char     c;
+    for( PGM_P p=styles_css; (c = (char)pgm_read_byte(p)) != '\0'; p++ ) {h ^= (uint8_t)c; h *= 16777619u;}
+    snprintf(etag,sizeof(etag),"\"%08x\"",(unsigned int)h);
+#ifdef HAS_GZIP_ASSETS
+    gzip = (h == styles_css_hash);
+#endif
+  }
+  char cacheControl[40];
+  snprintf(cacheControl,sizeof(cacheControl),"max-age=%ld, immutable",(long)STYLES_MAX_AGE);
+  svr->sendHeader("Cache-Control",cacheControl);
+  svr->sendHeader("Vary","Accept-Encoding");
+#ifdef HAS_GZIP_ASSETS
+  if( gzip && acceptsGzip(svr) ) {
+    char gzEtag[24];
+    snprintf(gzEtag,sizeof(gzEtag),"\"%.8s-gz\"",etag+1);
+    svr->sendHeader("ETag",gzEtag);
+    if( notModified(svr,gzEtag,TEXT_CSS) ) return;
+    svr->sendHeader("Content-Encoding","gzip");
+    Metrics::timeSend(styles_css_gz_size,[svr](){svr->send_P(200,TEXT_CSS,(PGM_P)styles_css_gz,styles_css_gz_size);});
+    return;
+  }
+#endif
+  svr->sendHeader("ETag",etag);
+  if( notModified(svr,etag,TEXT_CSS) ) return;
+  Metrics::timeSend(strlen_P(styles_css),[svr](){svr->send_P(200,TEXT_CSS,styles_css);});
 }
 
 void RootDevice::display(WebContext* svr) {
-  char buffer[DISPLAY_SIZE];
-  int size = sizeof(buffer);
-  int pos = formatHeader(buffer,size,getDisplayName());
-  char pathBuff[100];
-  for( int i=0; (i<_numDevices) && (size>0); i++ ) {
+  ResponseStream out(svr);
+  out.begin(200,"text/html");
+  out.formatHeader(getDisplayName());
+  for( int i=0; i<_numDevices; i++ ) {
     UPnPDevice* d = device(i);
-    if( d != NULL ) {
-       d->getPath(pathBuff,100);
-       pos = formatBuffer_P(buffer,size,pos,app_button,pathBuff,d->getDisplayName());
-    }
+    if( d != NULL ) AppButton::render(out,d->path(),d->getDisplayName());
   }
-  formatTail(buffer,size,pos);
-  svr->send(200,"text/html",buffer);
+  out.formatTail();
 }
 
-void RootDevice::formatContent(char buffer[], int size) {
+void RootDevice::formatContent(ResponseStream& out) {
 
-/** Add Sensor/Control display directly into the buffer. Sensors are displayed directly into the buffer supplied 
- *  and Controls are displayed in an iFrame with Level 2 title. Devices that are neither Sensor or Control are
+/** Stream Sensor/Control display directly into the response. Sensors insert their content and Controls 
+ *  are displayed in an iFrame with Level 3 title. Devices that are neither Sensor or Control are
  *  displayed as an app_button with it's display as trigger.
  */
-  int pos = 0;
   char pathBuff[100];
   int numDev = numDevices();
   for(int i=0; i<numDev; i++ ) {
@@ -233,81 +378,203 @@ void RootDevice::formatContent(char buffer[], int size) {
      Sensor*     s = ((d!=NULL)?((Sensor*)(d->as(Sensor::classType()))):(NULL));
      Control*    c = ((d!=NULL)?((Control*)(d->as(Control::classType()))):(NULL));
      if( s != NULL ) {
-        s->content(buffer+pos,size-pos);
-        pos = strlen(buffer);
+        EventStream::beginFragment(out,s);
+        s->renderContent(out);
+        EventStream::endFragment(out);
      }
      else if( c != NULL ) {
-        pos = formatBuffer_P(buffer,size,pos,html_L3_title,c->getDisplayName());
-        char pathBuff[100];
+        L3Title::render(out,c->getDisplayName());
         c->contentPath(pathBuff,100);
-        pos = formatBuffer_P(buffer,size,pos,iframe_html,pathBuff,c->frameHeight(),c->frameWidth());
-     }
-     else if( d != NULL ) {
-       d->getPath(pathBuff,100);
-       pos = formatBuffer_P(buffer,size,pos,app_button,pathBuff,d->getDisplayName());      
+        IFrame::render(out,pathBuff,c->frameHeight(),c->frameWidth());
      }
+     else if( d != NULL ) AppButton::render(out,d->path(),d->getDisplayName());
   }
   
 /**
  *   Add a "This Device" button
  */
-  getPath(pathBuff,100);  
-  pos = formatBuffer_P(buffer,size,pos,app_button,pathBuff,"This Device"); 
-     
+  AppButton::render(out,path(),"This Device"); 
+}
+
+/**
+ *  Render streamed content into buffer, truncating to size
+ */
+void RootDevice::formatContent(char buffer[], int size) {
+  if( size <= 0 ) return;
+  int pos = 0;
+  buffer[0] = '\0';
+  ResponseStream out([buffer,size,&pos](const char* data, size_t len) {
+    int n = (((int)len < size-1-pos)?((int)len):(size-1-pos));
+    memcpy(buffer+pos,data,n);
+    pos += n;
+    buffer[pos] = '\0';
+  });
+  formatContent(out);
+  out.end();
 }
 
 void RootDevice::displayRoot(WebContext* svr) {  
-  char buffer[DISPLAY_SIZE];
-  int size = sizeof(buffer);
+  ResponseStream out(svr);
+  out.begin(200,"text/html");
 
 /** Add HTML Header Title with Display Name
  */
-  int pos = formatHeader(buffer,size,getDisplayName());
+  out.formatHeader(getDisplayName());
   
 /** Add Content
  *  
  */
-  formatContent(buffer+pos,size-pos);
-  pos = strlen(buffer);
+  formatContent(out);
   
-/** Add the HTML tail
+/** Follow the event stream, then add the HTML tail
  */ 
-  formatTail(buffer,size,pos);
-  svr->send(200,"text/html",buffer);
+  EventStream::formatScript(out,this);
+  out.formatTail();
+}
+
+void RootDevice::collectHeaders(const char* names[], size_t count) {
+  _headers    = names;
+  _numHeaders = ((names != NULL)?(count):(0));
+  if( _context != NULL ) requestHeaders(_context);
+}
+
+/**
+ *  The Web server keeps one list, so the library's headers and the sketch's are named in a single call. Servers copy
+ *  the names, so the merged list is only held for the call.
+ */
+void RootDevice::requestHeaders(WebContext* svr) {
+  const size_t  n     = sizeof(collectedHeaders)/sizeof(collectedHeaders[0]);
+  const char**  names = (const char**)malloc((n+_numHeaders)*sizeof(const char*));
+  if( names == NULL ) {
+    svr->collectHeaders(collectedHeaders,n);
+    return;
+  }
+  size_t count = 0;
+  for( size_t i=0; i<n; i++ ) names[count++] = collectedHeaders[i];
+  for( size_t i=0; i<_numHeaders; i++ ) {
+    boolean found = false;
+    for( size_t j=0; (j<n) && !found; j++ ) found = (strcasecmp(_headers[i],collectedHeaders[j]) == 0);
+    if( !found ) names[count++] = _headers[i];
+  }
+  svr->collectHeaders(names,count);
+  free(names);
 }
 
 void RootDevice::setup(WebContext* svr) {
   _context = svr;
   _serverPort = svr->getLocalPort();
-  char pathBuffer[50];
-  svr->on("/styles.css",[this](WebContext* svr){this->styles(svr);});
-  svr->on("/",[this](WebContext* svr){this->displayRoot(svr);});
-  pathBuffer[0] = '\0';
-  sprintf(pathBuffer,"/%s",getTarget());
-  svr->on(pathBuffer,[this](WebContext* svr){this->display(svr);});
+  invalidatePaths();                      // Server port is part of every location
+  requestHeaders(svr);
+  if( routerMode() ) {
+    svr->onNotFound([this](WebContext* svr){
+      MetricsScope scope(&_metrics);
+      if( this->route(svr) ) scope.setRoute(_metrics.route(svr->uri().c_str()));
+      else svr->send(404,"text/plain","Not Found");
+    });
+  }
+  else {
+    RouteMetrics* styles = _metrics.route("/styles.css");
+    RouteMetrics* root   = _metrics.route("/");
+    svr->on("/styles.css",[this,styles](WebContext* svr){MetricsScope scope(&_metrics,styles); this->styles(svr);});
+    svr->on("/",[this,root](WebContext* svr){MetricsScope scope(&_metrics,root); this->displayRoot(svr);});
+  }
+  registerHandler(svr);
+  registerHandler(svr,"description.xml");
+  registerHandler(svr,"events");
+  registerHandler(svr,"configure");
+  if( _metrics.enabled() ) registerHandler(svr,"metrics");
   for( int i=0; i<numServices(); i++ ) {service(i)->setup(svr);}
   for( int i=0; i<_numDevices; i++ )   {device(i)->setup(svr);}
 }
 
+boolean RootDevice::dispatch(WebContext* svr, const char* handlerName) {
+  if( strcmp(handlerName,"description.xml") == 0 )  description(svr);
+  else if( strcmp(handlerName,"events") == 0 )      _stream.handleRequest(svr,this);
+  else if( strcmp(handlerName,"configure") == 0 )   configure(svr);
+  else if( (strcmp(handlerName,"metrics") == 0) && _metrics.enabled() ) _metrics.handleRequest(svr);
+  else return UPnPDevice::dispatch(svr,handlerName);
+  return true;
+}
+
+/**
+ *  Rendered twice when stale: once to size the document and once into an exact size heap buffer. The ETag is the 
+ *  FNV-1a hash and length of the document, so it changes whenever the content does.
+ */
+const char* RootDevice::getDescription() {
+  if( (_description != NULL) && (_descriptionVersion == hierarchyVersion()) ) return _description;
+  size_t length = 0;
+  {
+    ResponseStream out([](const char* data, size_t len) {});
+    out.print_P(description_head);
+    formatDescription(out);
+    out.print_P(description_tail);
+    out.end();
+    length = out.bytesWritten();
+  }
+  char* d = (char*)realloc(_description,length+1);
+  if( d == NULL ) {
+    free(_description);
+    _description = NULL;
+    _etag[0]     = '\0';
+    return "";
+  }
+  size_t pos = 0;
+  {
+    ResponseStream out([d,length,&pos](const char* data, size_t len) {
+      size_t n = ((len < length-pos)?(len):(length-pos));
+      memcpy(d+pos,data,n);
+      pos += n;
+    });
+    out.print_P(description_head);
+    formatDescription(out);
+    out.print_P(description_tail);
+  }
+  d[pos] = '\0';
+  _description        = d;
+  _descriptionLength  = pos;
+  _descriptionVersion = hierarchyVersion();
+  snprintf(_etag,sizeof(_etag),"\"%08x-%x\"",(unsigned int)hashTarget(d,pos),(unsigned int)pos);
+  return _description;
+}
+
+void RootDevice::description(WebContext* svr) {
+  const char* doc = getDescription();
+  if( _description == NULL ) {
+    svr->send(503,TEXT_PLAIN,"Out of memory");
+    return;
+  }
+  svr->sendHeader("ETag",_etag);
+  svr->sendHeader("Cache-Control","no-cache");
+  if( notModified(svr,_etag,TEXT_XML) ) return;
+  svr->setContentLength(_descriptionLength);
+  Metrics::timeSend(_descriptionLength,[svr,doc,this](){
+    svr->send(200,TEXT_XML,"");
+    svr->sendContent(doc,_descriptionLength);
+  });
+}
+
 /** Add a UPnPDevice to this root device
  *  If a target hasn't been set on the device, set a default target as "deviceN" where N is it's position in the _devices 
  *  array. If context has been set on RootDevice, then setup has been called. Devices added after RootDevice setup also  
  *  have to be setup().
  */
-void RootDevice::addDevice(UPnPDevice* dvc) {
-  if( dvc != NULL ) {
-     if(_numDevices < MAX_DEVICES) {
-       if( strlen(dvc->_target) == 0 ) sprintf(dvc->_target,"device%d",_numDevices);
-       if( strlen( dvc->_uuid ) == 0 ) generateUUID(dvc->_uuid);
-       _devices[_numDevices++] = dvc;
-       dvc->setParent(this);
+boolean RootDevice::addDevice(UPnPDevice* dvc) {
+  if( (dvc == NULL) || !ensureCapacity(_devices,_deviceCapacity,_numDevices,MAX_DEVICES) ) return false;
+  if( strlen(dvc->_target) == 0 ) {
+    char target[TARGET_SIZE];
+    snprintf(target,sizeof(target),"device%d",_numDevices);
+    dvc->setTarget(target);
+  }
+  _devices[_numDevices++] = dvc;
+  dvc->setParent(this);
+  indexObject(dvc);
+  for( int i=0; i<dvc->numServices(); i++ ) indexObject(dvc->service(i));
 /**
- *     Late binding setup. Setup() has already been called on this RootDevice so any device added
- *     must also be setup();
+ *  Late binding setup. Setup() has already been called on this RootDevice so any device added
+ *  must also be setup();
  */
-       if(getContext() != NULL) dvc->setup(getContext());
-     }
-  }
+  if(getContext() != NULL) dvc->setup(getContext());
+  return true;
 }
 
 /**
@@ -328,22 +595,312 @@ UPnPDevice* RootDevice::getDevice(const ClassType* t) {
  *  embedded devices for a match. Returns NULL if none are found.
  */
 UPnPDevice* RootDevice::getDevice(const char* u) {
+  UUID id;
+  return ((id.parse(u))?(getDevice(id)):(NULL));
+}
+
+UPnPDevice* RootDevice::getDevice(const UUID& id) {
   UPnPDevice* result = NULL;
-  if(this->isDevice(u)) result = this;
-  else {
-     for( int i=0; (i<numDevices()) && (result == NULL); i++ ) {if(device(i)->isDevice(u)) {result = device(i);break;}}
+  forEachMatch(id.hash(),NULL,&id,[&result](UPnPObject* obj) {if( result == NULL ) result = obj->asDevice();});
+  return result;
+}
+
+UPnPObject* RootDevice::getObject(const char* key) {
+  UPnPObject* result = NULL;
+  forEachObject(key,[&result](UPnPObject* obj) {if( result == NULL ) result = obj;});
+  return result;
+}
+
+/**
+ *  Probe from the slot for hash(key) to the first empty slot. Slots with a matching hash are confirmed with a 
+ *  single string compare, so a lookup costs one compare per match rather than one per Object.
+ */
+int RootDevice::forEachObject(const char* key, ObjectFunction f) {
+  if( key == NULL ) return 0;
+  UUID id;
+  if( id.parse(key) ) return forEachMatch(id.hash(),NULL,&id,f);
+  return forEachMatch(hashTarget(key,strlen(key)),key,NULL,f);
+}
+
+/**
+ *  Matches either UUID uuid or, when uuid is NULL, UPnP type key
+ */
+int RootDevice::forEachMatch(uint32_t hash, const char* key, const UUID* uuid, ObjectFunction f) {
+  if( !indexCurrent() ) buildIndex();
+  int count = 0;
+  if( !_indexValid ) {
+/**
+ *  Out of memory for the index, scan the hierarchy instead
+ */
+    for( int i=-1; i<numDevices(); i++ ) {
+      UPnPDevice* d = ((i<0)?(this):(device(i)));
+      if( hasKey(d,key,uuid) ) {f(d); count++;}
+      for( int j=0; j<d->numServices(); j++ ) {if( hasKey(d->service(j),key,uuid) ) {f(d->service(j)); count++;}}
+    }
+    return count;
+  }
+  IndexSlot* slots = _objects.slots;
+  uint32_t   mask  = _objects.capacity - 1;
+  for( uint32_t i=hash&mask; slots[i].object != NULL; i=(i+1)&mask ) {
+    if( (slots[i].hash == hash) && hasKey(slots[i].object,key,uuid) ) {
+      f(slots[i].object);
+      count++;
+    }
   }
+  return count;
+}
+
+/**
+ *  key is a UUID when id is non-NULL, and a UPnP type otherwise
+ */
+boolean RootDevice::hasKey(UPnPObject* obj, const char* key, const UUID* id) {
+  UPnPDevice* d = obj->asDevice();
+  if( id != NULL ) return (d != NULL) && d->isDevice(*id);
+  return (key != NULL) && (strcmp(obj->getType(),key) == 0);
+}
+
+void RootDevice::buildIndex() {
+  _objects.count  = 0;
+  _children.count = 0;
+  if( _objects.slots != NULL )  memset(_objects.slots,0,_objects.capacity*sizeof(IndexSlot));
+  if( _children.slots != NULL ) memset(_children.slots,0,_children.capacity*sizeof(IndexSlot));
+  _indexValid      = true;
+  _indexGeneration = pathGeneration();
+  indexObject(this);
+  for( int i=0; i<numServices(); i++ ) indexObject(service(i));
+  for( int i=0; i<numDevices(); i++ ) {
+    UPnPDevice* d = device(i);
+    indexObject(d);
+    for( int j=0; j<d->numServices(); j++ ) indexObject(d->service(j));
+  }
+}
+
+/**
+ *  Types are virtual, so the indexes are only built once Objects are fully constructed: on first lookup, then 
+ *  maintained as Objects are added. Devices are indexed by type and UUID, services by type, and both by target
+ *  under their parent.
+ */
+void RootDevice::indexObject(UPnPObject* obj) {
+  if( !_indexValid || (obj == NULL) ) return;
+  const char* type = obj->getType();
+  indexInsert(_objects,hashTarget(type,strlen(type)),obj);
+  UPnPDevice* d = obj->asDevice();
+  if( d != NULL ) indexInsert(_objects,d->getUUID().hash(),obj);
+  if( obj->getParent() != NULL ) indexInsert(_children,childKey(obj->getParent(),obj->targetHash()),obj);
+}
+
+/**
+ *  Capacity is a power of 2, doubled when the index would be more than 3/4 full
+ */
+void RootDevice::indexInsert(Index& index, uint32_t hash, UPnPObject* obj) {
+  if( !_indexValid ) return;
+  if( (index.count+1)*4 > index.capacity*3 ) {
+    int        capacity = ((index.capacity == 0)?(16):(index.capacity*2));
+    IndexSlot* slots    = (IndexSlot*)calloc(capacity,sizeof(IndexSlot));
+    if( slots == NULL ) {_indexValid = false; return;}
+    IndexSlot* old      = index.slots;
+    int        oldCap   = index.capacity;
+    index.slots    = slots;
+    index.capacity = capacity;
+    index.count    = 0;
+    for( int i=0; i<oldCap; i++ ) {if( old[i].object != NULL ) indexInsert(index,old[i].hash,old[i].object);}
+    free(old);
+  }
+  uint32_t mask = index.capacity - 1;
+  uint32_t i    = hash&mask;
+  for( ; index.slots[i].object != NULL; i=(i+1)&mask ) {if( (index.slots[i].hash == hash) && (index.slots[i].object == obj) ) return;}
+  index.slots[i].hash   = hash;
+  index.slots[i].object = obj;
+  index.count++;
+}
+
+/**
+ *  Siblings have distinct targets, so a target hash mixed with the address of the parent keys a child across the
+ *  whole hierarchy. Matches are confirmed by parent and target.
+ */
+uint32_t RootDevice::childKey(UPnPObject* parent, uint32_t hash) {return hash ^ ((uint32_t)((uintptr_t)parent >> 2) * 2654435761u);}
+
+UPnPObject* RootDevice::findChild(UPnPObject* parent, const char* segment, size_t len, uint32_t hash) {
+  if( !indexCurrent() ) buildIndex();
+  if( !_indexValid ) return parent->child(segment,len,hash);
+  if( _children.slots == NULL ) return NULL;
+  uint32_t key  = childKey(parent,hash);
+  uint32_t mask = _children.capacity - 1;
+  for( uint32_t i=key&mask; _children.slots[i].object != NULL; i=(i+1)&mask ) {
+    UPnPObject* obj = _children.slots[i].object;
+    if( (_children.slots[i].hash == key) && (obj->getParent() == parent) && obj->isTarget(segment,len,hash) ) return obj;
+  }
+  return NULL;
+}
+
+UPnPObject* RootDevice::child(const char* segment, size_t len, uint32_t hash) {
+  UPnPObject* result = UPnPDevice::child(segment,len,hash);
+  for( int i=0; (i<_numDevices) && (result == NULL); i++ ) {if( _devices[i]->isTarget(segment,len,hash) ) result = _devices[i];}
   return result;
 }
 
-void RootDevice::doDevice() {for( int i=0; i<numDevices(); i++ ) {device(i)->doDevice();}}
+/**
+ *  Walk the URI one target at a time from this RootDevice, each segment a single probe of the child index. The first 
+ *  segment that is not an embedded Object's target must be the last, and names a handler on the last Object matched, 
+ *  e.g. "/root/device/setConfiguration/configForm".
+ */
+boolean RootDevice::route(WebContext* svr) {
+  const String& uri = svr->uri();
+  const char*   seg = uri.c_str();
+  if( strcmp(seg,"/") == 0 )           {displayRoot(svr); return true;}
+  if( strcmp(seg,"/styles.css") == 0 ) {styles(svr); return true;}
+
+  UPnPObject* obj = NULL;
+  while( *seg == '/' ) {
+    seg++;
+    size_t      len  = strcspn(seg,"/");
+    uint32_t    hash = hashTarget(seg,len);
+    UPnPObject* next = ((obj == NULL)?((isTarget(seg,len,hash))?(this):(NULL)):(findChild(obj,seg,len,hash)));
+    if( next == NULL ) return ((obj != NULL) && (seg[len] == '\0') && obj->dispatch(svr,seg));
+    obj  = next;
+    seg += len;
+  }
+  return ((obj != NULL) && (*seg == '\0') && obj->dispatch(svr,""));
+}
+
+/**
+ *  Batch configuration. The first phase resolves and checks every argument into a BatchSetting; the second applies them,
+ *  one object at a time, only if none was rejected. Setting names are matched in full, and a value must decode as the
+ *  Parameter the device puts the setting with, if any. Settings other than displayName reach the device through 
+ *  restoreSettings(), from a buffer sized and allocated in the first phase, so the second phase cannot fail part way.
+ */
+struct BatchSetting {
+  UPnPObject*  object;
+  uint32_t     hash;         // Parameter::hash() of the setting name
+  boolean      displayName;
+  uint8_t      error;        // Index into batch_errors, 0 if accepted
+};
+
+static const char* const batch_errors[] = {"","malformed","unknown-object","unknown-setting","invalid-value"};
+#define BATCH_MALFORMED        1
+#define BATCH_UNKNOWN_OBJECT   2
+#define BATCH_UNKNOWN_SETTING  3
+#define BATCH_INVALID_VALUE    4
+
+void RootDevice::configure(WebContext* svr) {
+  int numArgs = svr->argCount();
+  if( numArgs > MAX_BATCH_SETTINGS ) {svr->send(413,TEXT_PLAIN,"too many settings\n"); return;}
+  BatchSetting* settings = (BatchSetting*)malloc(((numArgs>0)?(numArgs):(1))*sizeof(BatchSetting));
+  if( settings == NULL ) {svr->send(503,TEXT_PLAIN,"out of memory\n"); return;}
+
+  int     rejected = 0;
+  size_t  size     = 0;
+  for( int i=0; i<numArgs; i++ ) {
+    BatchSetting& s = settings[i];
+    const String& argName = svr->argName(i);
+    const char*   name = argName.c_str();
+    const char*   dot  = strrchr(name,'.');
+    size_t        len  = svr->arg(i).length();
+    s.object      = NULL;
+    s.displayName = false;
+    s.error       = 0;
+    if( (dot == NULL) || (dot == name) || (dot[1] == '\0') ) s.error = BATCH_MALFORMED;
+    else if( (s.object = resolve(name,dot-name)) == NULL ) s.error = BATCH_UNKNOWN_OBJECT;
+    else if( (s.displayName = (strcasecmp(dot+1,"displayName") == 0)) ) {if( (len == 0) || (len >= NAME_SIZE) ) s.error = BATCH_INVALID_VALUE;}
+    else {
+      UPnPDevice*  d = s.object->asDevice();
+      ConfigProbe  w(dot+1);
+      s.hash = Parameter::hash(dot+1);
+      if( d != NULL ) d->saveSettings(w);
+      if( !w.found() ) s.error = BATCH_UNKNOWN_SETTING;
+      else if( (len > 255) || ((w.parameter() != NULL) && !w.parameter()->decode(svr->arg(i).c_str(),len,NULL)) ) s.error = BATCH_INVALID_VALUE;
+      else size += 5 + len + 1;
+    }
+    if( s.error != 0 ) rejected++;
+  }
+
+  uint8_t* buffer = NULL;
+  if( (rejected == 0) && (size > 0) && ((buffer = (uint8_t*)malloc(size)) == NULL) ) {
+    free(settings);
+    svr->send(503,TEXT_PLAIN,"out of memory\n");
+    return;
+  }
+
+  ResponseStream out(svr);
+  out.begin(((rejected == 0)?(200):(400)),TEXT_PLAIN);
+  if( rejected > 0 ) {
+    out.printf_P(PSTR("rejected %d of %d settings, none applied\n"),rejected,numArgs);
+    for( int i=0; i<numArgs; i++ ) {if( settings[i].error != 0 ) out.printf_P(PSTR("%s %s\n"),svr->argName(i).c_str(),batch_errors[settings[i].error]);}
+    free(settings);
+    return;
+  }
+
+  int objects = 0;
+  for( int i=0; i<numArgs; i++ ) {
+    UPnPObject* obj = settings[i].object;
+    if( obj == NULL ) continue;
+    ConfigWriter w(buffer,0);
+    for( int j=i; j<numArgs; j++ ) {
+      if( settings[j].object != obj ) continue;
+      if( settings[j].displayName ) obj->setDisplayName(svr->arg(j).c_str());
+      else w.put(settings[j].hash,svr->arg(j).c_str());
+      settings[j].object = NULL;
+    }
+    UPnPDevice* d = obj->asDevice();
+    if( (d != NULL) && (w.count() > 0) ) {
+      ConfigReader r(buffer,w.count());
+      d->restoreSettings(r);
+    }
+    if( d == NULL ) d = ((obj->getParent() != NULL)?(obj->getParent()->asDevice()):(NULL));
+    obj->markDirty();
+    if( d != NULL ) {
+      d->markDirty();
+      for( int k=0; k<d->numServices(); k++ ) d->service(k)->propertiesChanged();
+    }
+    objects++;
+  }
+  free(buffer);
+  free(settings);
+  if( objects > 0 ) _config.changed();
+  out.printf_P(PSTR("applied %d settings to %d objects\n"),numArgs,objects);
+}
+
+/**
+ *  A UUID, with or without "uuid:", names a device; otherwise address is a target path walked from this RootDevice, whose
+ *  own target may be left out
+ */
+UPnPObject* RootDevice::resolve(const char* address, size_t len) {
+  char id[UUID_SIZE+5];
+  if( len < sizeof(id) ) {
+    memcpy(id,address,len);
+    id[len] = '\0';
+    UUID u;
+    if( u.parse(id) ) return getDevice(u);
+  }
+  const char* seg = address;
+  const char* end = address + len;
+  UPnPObject* obj = NULL;
+  while( seg < end ) {
+    if( *seg == '/' ) {seg++; continue;}
+    size_t n = 0;
+    while( (seg+n < end) && (seg[n] != '/') ) n++;
+    uint32_t    hash = hashTarget(seg,n);
+    UPnPObject* next = ((obj == NULL)?((isTarget(seg,n,hash))?(this):(findChild(this,seg,n,hash))):(findChild(obj,seg,n,hash)));
+    if( next == NULL ) return NULL;
+    obj  = next;
+    seg += n;
+  }
+  return obj;
+}
+
+void RootDevice::doDevice() {
+  _scheduler.run(this);
+  _events.publish();
+  _stream.publish(this);
+  _config.run(this);
+}
 
 void RootDevice::rootLocation(char buffer[], int buffSize, IPAddress ifc) {
-  snprintf(buffer,buffSize,"http://%s:%d/",ifc.toString().c_str(),serverPort());
+  snprintf(buffer,buffSize,"http://%u.%u.%u.%u:%d/",ifc[0],ifc[1],ifc[2],ifc[3],serverPort());
 }
 
-void RootDevice::location(char buffer[], int buffSize, IPAddress ifc) {
-  snprintf(buffer,buffSize,"http://%s:%d/%s",ifc.toString().c_str(),serverPort(),getTarget());
+void RootDevice::descriptionLocation(char buffer[], int buffSize, IPAddress ifc) {
+  snprintf(buffer,buffSize,"%s/description.xml",getLocation(ifc));
 }
 
 /**
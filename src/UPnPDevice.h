@@ -24,23 +24,56 @@
 #define UPNP_DEVICE_H
 #include <CommonProgmem.h>
 #include "UPnPService.h"
+#include "ResponseStream.h"
+#include "PageTemplate.h"
+#include "UUID.h"
+#include "Eventing.h"
+#include "Scheduler.h"
+#include "Metrics.h"
+#include "ConfigStore.h"
 
 /** Leelanau Software Company namespace 
 *  
 */
 namespace lsc {
   
-#define MAX_SERVICES 8
-#define MAX_DEVICES  8
-#define UUID_SIZE    37
+/**
+ *   Maximum number of UPnPServices per UPnPDevice and UPnPDevices per RootDevice. Services and devices are held in heap 
+ *   arrays that grow as they are added (in steps of CAPACITY_INCREMENT), so memory is used only for what is added and 
+ *   these limits only bound growth. Either can be overridden at compile time, for example -DMAX_DEVICES=64.
+ */
+#ifndef MAX_SERVICES
+#define MAX_SERVICES 32
+#endif
+#ifndef MAX_DEVICES
+#define MAX_DEVICES  64
+#endif
+#define CAPACITY_INCREMENT 4
+
+/**
+ *   Most settings accepted by one RootDevice configure() request. Override with -DMAX_BATCH_SETTINGS=n.
+ */
+#ifndef MAX_BATCH_SETTINGS
+#define MAX_BATCH_SETTINGS 64
+#endif
+
+typedef std::function<void(UPnPObject*)> ObjectFunction;
 #define DISPLAY_SIZE 1280
 
+/**
+ *   Seconds browsers may use /styles.css without revalidating. The stylesheet url does not change when firmware does,
+ *   so this bounds how long a browser can show a stale stylesheet after an update. Override with -DSTYLES_MAX_AGE=n.
+ */
+#ifndef STYLES_MAX_AGE
+#define STYLES_MAX_AGE 86400
+#endif
+
 
  /** UPnPDevice class definition
   *  A UPnPDevice may have up to MAX_SERVICES UPnPServices and can display itself.
   *  Class members are as follows:
   *    numServices()                := Returns the number of UPnPServices
-  *    services()                   := Returns an array of MAX_SERVICES UPnPService pointers
+  *    services()                   := Returns an array of numServices() UPnPService pointers
   *    display()                    := Responds with an HTML interface for the Object, set on the Web Server as response to target
   *                                    As in: server.on(rootPath,[this,svr]{this->display(svr);});
   *                                    By default, will display a set of buttons for each of the device's UPnPServices. 
@@ -49,9 +82,28 @@ namespace lsc {
   *                                    as a request handler for /rootTarget/deviceTarget/serviceTarget. Note that all targets must be set prior to 
   *                                    the call to setup().
   *    doDevice()                   := Called in the Arduino loop(); an opportunity to do a unit of work
-  *    addService(UPnPService*)     := Adds the next service
+  *    setSchedule(period,deadline) := Has the RootDevice call doDevice() every period ms rather than on every loop (period 0,
+  *                                    the default). A run found more than deadline ms late is skipped; deadline 0 never skips.
+  *    period(), deadline()         := Schedule set with setSchedule()
+  *    addService(UPnPService*)     := Adds the next service. Returns false if the service is NULL, MAX_SERVICES have already
+  *                                    been added, or memory is exhausted
   *    addServices(UPnPService*...) := Adds up to MAX_SERVICES UPnPServices
   *    service(int n)               := Returns a pointer to the n'th UPnPService when 0 <= n < numServices() and NULL otherwise
+  *    getUUID()                    := Returns the device UUID. Unless set with setUUID(), the UUID is a name based (version 5) UUID
+  *                                    derived from the chip ID and path(), so a device keeps the same UUID across restarts as long as
+  *                                    its place in the hierarchy is unchanged. It is derived again whenever the path changes, so it
+  *                                    may be used before targets are set. setUUID() with a null UUID returns to derived UUIDs.
+  *    uuid()                       := Returns the canonical UUID string, formatted on first use
+  *    isDevice(u)                  := True if u is the UUID of this device
+  *    formatDescription(out)       := Writes the <device> element of the UPnP device description for this device, its services
+  *                                    and (for a RootDevice) its embedded devices
+  *    saveSettings(w)              := Adds settings of this device beyond target, display name and UUID to the RootDevice
+  *                                    configStore() record, with w.put(name,value). Default is none.
+  *    restoreSettings(r)           := Applies settings read back from the record, with r.get(name), which returns NULL for a
+  *                                    setting not stored. Called from ConfigStore::begin(), before setup(), so defaults should
+  *                                    be set in the constructor rather than in setup().
+  *    eventDisplayName(svc)        := (protected) Has svc event this device's display name, as the GetConfiguration services of 
+  *                                    Sensor and Control do
   */
 
 class UPnPDevice : public UPnPObject {
@@ -59,19 +111,30 @@ class UPnPDevice : public UPnPObject {
      public:
      UPnPDevice();
      UPnPDevice(const char* target);
+     virtual ~UPnPDevice();
   
-     const char*    uuid()                         {return _uuid;}
+     const char*    uuid();
+     const UUID&    getUUID();
      int            numServices()                  {return _numServices;}
-     boolean        isDevice(const char* u)        {return (strcmp(u,uuid()) == 0);} 
+     boolean        isDevice(const UUID& u)        {return getUUID() == u;}
+     boolean        isDevice(const char* u)        {UUID id; return id.parse(u) && isDevice(id);} 
      UPnPService**  services()                     {return _services;}
      UPnPService*   service(int i)                 {return (((i<_numServices)&&(i>=0))?(_services[i]):(NULL));}
      boolean        setUUID(String uuid);
-     void           addService(UPnPService* svc);
+     void           setUUID(const UUID& uuid);
+     boolean        addService(UPnPService* svc);
+     void           setSchedule(uint32_t period, uint32_t deadline = 0);
+     uint32_t       period()                       {return _period;}
+     uint32_t       deadline()                     {return _deadline;}
      
      virtual void         doDevice() {}  
      virtual void         display(WebContext* svr);
      virtual void         setup(WebContext* svr);
-     virtual void         location(char buffer[], int buffSize, IPAddress ifc);
+     virtual boolean      dispatch(WebContext* svr, const char* handlerName);
+     virtual UPnPObject*  child(const char* segment, size_t len, uint32_t hash);
+     virtual void         formatDescription(ResponseStream& out);
+     virtual void         saveSettings(ConfigWriter& w)           {}
+     virtual void         restoreSettings(const ConfigReader& r)  {}
   
      template<typename T>
      void addServices( T ptr) {addService(ptr);}
@@ -104,9 +167,17 @@ class UPnPDevice : public UPnPObject {
      
      protected:
      
-     UPnPService*       _services[MAX_SERVICES];
+     UPnPService**      _services = NULL;
      int                _numServices = 0;
-     char               _uuid[UUID_SIZE];
+     int                _serviceCapacity = 0;
+     UUID               _uuid;
+     char*              _uuidString = NULL;
+     uint32_t           _uuidGen = 0;                  // pathGeneration() the UUID was derived at; 0 before it is derived
+     boolean            _uuidSet = false;              // Set with setUUID() rather than derived
+     uint32_t           _period = 0;
+     uint32_t           _deadline = 0;
+
+     void               eventDisplayName(UPnPService* svc);
      
      friend class RootDevice;
 
@@ -121,41 +192,114 @@ class UPnPDevice : public UPnPObject {
  *  A RootDevice is a UPnPDevice that can have embedded UPnPDevices.
  *  Class members are as follows:
  *    numDevices()                 := Returns the number of UPnPDevices
- *    devices()                    := Returns an array of MAX_DEVICES UPnPDevice pointers
+ *    devices()                    := Returns an array of numDevices() UPnPDevice pointers
  *    displayRoot()                := Displays a single HTML Button with the displayName of this RootDevice. Selecting the button
  *                                    will trigger the display() function to be called
  *    setUp()                      := Device specific setup, like setting Web Server request handlers. Default is to set display()
  *                                    as a request handler for target() and to set the CSS styles from styles()
- *    addDevice(UPnPDevice*)       := Adds the next service
+ *    addDevice(UPnPDevice*)       := Adds the next device. Returns false if the device is NULL, MAX_DEVICES have already
+ *                                    been added, or memory is exhausted
  *    addDevices(UPnPDevice*...)   := Adds up to MAX_DEVICES UPnPDevices
  *    service(int)                 := Returns a pointer to the n'th UPnPDevice
- *    styles()                     := Responds with the CSS styles for this RootDevice.
+ *    styles()                     := Responds with the CSS styles for this RootDevice, with a strong ETag (computed once, on first 
+ *                                    request) and Cache-Control: max-age=STYLES_MAX_AGE, immutable. A request whose If-None-Match 
+ *                                    header matches is answered with 304 Not Modified and no body.
+ *    collectHeaders(names,count)  := Request headers the sketch reads itself. The ESP Web servers keep only the headers named in
+ *                                    one collectHeaders() call, and setup() names those the library reads, so a sketch must name
+ *                                    its own here rather than on the Web server; they are collected along with the library's.
+ *                                    names must outlive the RootDevice.
+ *    setRouterMode(flag)          := When set prior to setup(), the RootDevice registers a single catch-all (onNotFound) request handler 
+ *                                    with the Web server rather than one handler per path. Requests are routed by route(), which 
+ *                                    walks the Object hierarchy one target at a time, so lookup cost is proportional to path depth, 
+ *                                    and devices and services added after setup() need no Web server registration. Paths registered 
+ *                                    directly with WebContext::on() still take precedence. Router mode assumes this is the only 
+ *                                    RootDevice on the Web server, and replaces any existing onNotFound handler.
+ *    route(svr)                   := Dispatches the current request to the Object and handler named by its URI. Returns false if
+ *                                    no Object handles the URI. May be called from an application's own onNotFound handler.
+ *    getDevice(uuid)              := Returns the device (this RootDevice or an embedded device) with UUID uuid, or NULL
+ *    getObject(key)               := Returns the first device or service whose UUID or UPnP type is key, or NULL
+ *    forEachObject(key,f)         := Calls f for every device and service whose UUID or UPnP type is key, and returns the number
+ *                                    of matches. For example, an SSDP search target of urn:schemas-upnp-org:device:Basic:1.
+ *    description(svr)             := Responds with the UPnP device description document, /rootTarget/description.xml. The response
+ *                                    carries a strong ETag, and a request whose If-None-Match header matches it is answered with 
+ *                                    304 Not Modified and no body.
+ *    configure(svr)               := Responds to /rootTarget/configure, which sets configuration across the hierarchy in one request.
+ *                                    Each argument is address.setting=value, where address is a device UUID or the target path of
+ *                                    a device or service (with or without the root target), and setting is displayName or, for a
+ *                                    device, a setting it saves in saveSettings(). Every argument is checked before any is applied:
+ *                                    if any address, setting or value is not accepted, nothing is applied and the response is 400
+ *                                    with a line per rejected argument. Otherwise all are applied, the changed devices are marked
+ *                                    dirty, their subscribers notified and configStore() told of the change, and the response is a
+ *                                    single text/plain status line.
+ *    resolve(address,len)         := Returns the device with UUID, or the device or service at target path, address, or NULL
+ *    getDescription()             := Returns the description document, rendered on first use and cached on the heap at exact size.
+ *                                    It is re-rendered only when hierarchyVersion() changes, i.e. when a device or service is added,
+ *                                    or a target, display name, UUID or server port changes.
+ *    descriptionETag()            := Returns the quoted strong ETag of getDescription()
+ *    descriptionLocation()        := Formats the description URL for an interface address, for SSDP LOCATION headers
+ *    doDevice()                   := Calls doDevice() on embedded devices as scheduled (see scheduler()), then sends pending GENA
+ *                                    and Server-Sent events and writes pending configuration. Call it from the sketch loop().
+ *    metrics()                    := Request Metrics for the routes of this hierarchy. Off until metrics()->setEnabled(true), which 
+ *                                    must precede setup(); once on, /rootTarget/metrics responds in Prometheus text format.
+ *    scheduler()                  := The Scheduler deciding which devices run on each doDevice(), with its statistics
+ *    configStore()                := The ConfigStore keeping the configuration of this hierarchy across restarts. Off until 
+ *                                    configStore()->begin(this), which restores it and must precede setup(); changes are then 
+ *                                    written, debounced, from doDevice().
+ *    events()                     := The EventPublisher holding GENA subscriptions to the services of this hierarchy. Pending
+ *                                    NOTIFY messages are sent from doDevice(), so the sketch loop() must call doDevice().
+ *    eventStream()                := The EventStream pushing Sensor and Control content changes to browsers, on /rootTarget/events.
+ *                                    Pages displayed by displayRoot(), Sensor::display() and Control::display() follow it, so a
+ *                                    change is redrawn in place without a reload. Changes are streamed from doDevice().
+ *
+ *  UUID and type lookups, and each segment of a routed URI, use hash indexes of the hierarchy, built on first lookup and
+ *  rebuilt after any change of target or parent, so lookups do not scan the hierarchy or string compare against every 
+ *  Object, and routing a URI costs one probe per segment however many siblings each level has.
  */
 class RootDevice : public UPnPDevice {
 
      public:
      RootDevice();
      RootDevice(const char* target);
+     virtual ~RootDevice();
 
      int               serverPort()                 {return _serverPort;}
      int               numDevices()                 {return _numDevices;}
      UPnPDevice**      devices()                    {return _devices;}
-     UPnPDevice*       device(int i)                {return ((i<_numDevices)?(_devices[i]):(NULL));}
+     UPnPDevice*       device(int i)                {return (((i<_numDevices)&&(i>=0))?(_devices[i]):(NULL));}
      WebContext*       getContext()                 {return _context;}
+     EventPublisher*   events()                     {return &_events;}
+     EventStream*      eventStream()                {return &_stream;}
+     Scheduler*        scheduler()                  {return &_scheduler;}
+     Metrics*          metrics()                    {return &_metrics;}
+     ConfigStore*      configStore()                {return &_config;}
+     boolean           routerMode()                 {return _routerMode;}
+     void              setRouterMode(boolean flag)  {_routerMode = flag;}
+     void              collectHeaders(const char* names[], size_t count);
+     boolean           route(WebContext* svr);
      
      void              rootLocation(char buffer[], int buffSize, IPAddress ifc);
-     void              addDevice(UPnPDevice* dvc);
+     void              descriptionLocation(char buffer[], int buffSize, IPAddress ifc);
+     const char*       getDescription();
+     const char*       descriptionETag()            {getDescription(); return _etag;}
+     boolean           addDevice(UPnPDevice* dvc);
      UPnPDevice*       getDevice(const ClassType* t);
      UPnPDevice*       getDevice(const char* uuid);
+     UPnPDevice*       getDevice(const UUID& uuid);
+     UPnPObject*       getObject(const char* key);
+     int               forEachObject(const char* key, ObjectFunction f);
 
     static UPnPDevice* getDevice(RootDevice* root, const ClassType* type) {return((root!=NULL)?(root->getDevice(type)):(NULL));}
 
      void              setup(WebContext* svr);
      void              display(WebContext* svr);
      void              doDevice();
-     virtual void      location(char buffer[], int buffSize, IPAddress addr);
+     virtual boolean   dispatch(WebContext* svr, const char* handlerName);
+     virtual UPnPObject* child(const char* segment, size_t len, uint32_t hash);
+     virtual void      description(WebContext* svr);
      virtual void      displayRoot(WebContext* svr);
      virtual void      styles(WebContext* svr); 
+     virtual void      configure(WebContext* svr);
+     UPnPObject*       resolve(const char* address, size_t len);
   
      template<typename T>
      void addDevices( T ptr) {addDevice(ptr);}
@@ -185,13 +329,64 @@ class RootDevice : public UPnPDevice {
 /**
  *   Format content for base URL display, where Sensors insert their HTML and Controls 
  *   are linked with an iFrame, mitigating the need for a large display buffer.
+ *   displayRoot() streams content through the ResponseStream form, so subclasses customizing
+ *   the base URL display must override that form. 
+ *   Deprecated: the buffer form renders the same content into buffer, truncated to size. It is no longer
+ *   virtual and displayRoot() does not call it, so a sketch overriding it must move its markup to the 
+ *   ResponseStream form.
  */
-     virtual void            formatContent(char buffer[], int size);
+     virtual void            formatContent(ResponseStream& out);
+     void                    formatContent(char buffer[], int size);
      
-     UPnPDevice*             _devices[MAX_DEVICES];
+     UPnPDevice**            _devices = NULL;
      int                     _numDevices = 0;
+     int                     _deviceCapacity = 0;
      WebContext*             _context = NULL;
      int                     _serverPort = 0;
+     boolean                 _routerMode = false;
+     const char**            _headers = NULL;            // Headers collected for the sketch, see collectHeaders()
+     size_t                  _numHeaders = 0;
+     char*                   _description = NULL;
+     size_t                  _descriptionLength = 0;
+     uint32_t                _descriptionVersion = 0;
+     char                    _etag[24] = "";
+     EventPublisher          _events;
+     EventStream             _stream;
+     Scheduler               _scheduler;
+     Metrics                 _metrics;
+     ConfigStore             _config;
+
+/**
+ *   Open addressing hash indexes. Each slot holds the hash of a key and an Object with that key; a NULL Object marks an 
+ *   empty slot. In _objects an Object appears once for its type and, for devices, once for its UUID. In _children every
+ *   Object but this appears once, under its target hash mixed with its parent (see childKey()).
+ */
+     struct IndexSlot {
+       uint32_t     hash;
+       UPnPObject*  object;
+     };
+     struct Index {
+       IndexSlot*   slots    = NULL;
+       int          capacity = 0;
+       int          count    = 0;
+     };
+     Index                   _objects;
+     Index                   _children;
+     boolean                 _indexValid = false;
+     uint32_t                _indexGeneration = 0;       // pathGeneration() when the indexes were built
+
+     void                    requestHeaders(WebContext* svr);
+     void                    buildIndex();
+     boolean                 indexCurrent()      {return _indexValid && (_indexGeneration == pathGeneration());}
+     void                    indexObject(UPnPObject* obj);
+     void                    indexInsert(Index& index, uint32_t hash, UPnPObject* obj);
+     void                    invalidateIndex()   {_indexValid = false;}
+     UPnPObject*             findChild(UPnPObject* parent, const char* segment, size_t len, uint32_t hash);
+     static uint32_t         childKey(UPnPObject* parent, uint32_t hash);
+     int                     forEachMatch(uint32_t hash, const char* key, const UUID* id, ObjectFunction f);
+     static boolean          hasKey(UPnPObject* obj, const char* key, const UUID* id);
+
+     friend class UPnPDevice;
      
 /**
  *   Copy construction and destruction are not allowed
@@ -21,6 +21,7 @@
  */
 
 #include "UPnPService.h"
+#include "UPnPDevice.h"
 /** Leelanau Software Company namespace 
 *  
 */
@@ -29,7 +30,6 @@ namespace lsc {
 /**
  *  Static initializers for runtime type identification
  */
-int ClassType::_numTypes = 0;
 INITIALIZE_STATIC_TYPE(UPnPObject);
 INITIALIZE_STATIC_TYPE(UPnPService);
 
@@ -39,12 +39,87 @@ INITIALIZE_STATIC_TYPE(UPnPService);
 INITIALIZE_UPnP_TYPE(UPnPService,urn:LeelanauSoftware-com:service:Basic:1);
 INITIALIZE_UPnP_TYPE(UPnPObject,urn:LeelanauSoftware-com:device:Object:1);
 
-UPnPObject::UPnPObject() {
-  _target[0]      = '\0';
-  strlcpy(_displayName," ", sizeof(_displayName));  // Display name defaults to blank
+/**
+ *  Path cache generation; starts at 1 so that no Object cache is initially valid
+ */
+uint32_t UPnPObject::_pathGeneration = 1;
+uint32_t UPnPObject::_hierarchyVersion = 1;
+
+StringTable::Entry* StringTable::_entries = NULL;
+int                 StringTable::_count   = 0;
+size_t              StringTable::_bytes   = 0;
+
+/**
+ *  Strings are interned when Objects are built or renamed, never per request, so the table is a list searched in order.
+ *  A reference count that reaches its limit is left there, and that string is never freed.
+ */
+const char* StringTable::intern(const char* s, size_t size) {
+  size_t len = strnlen(s,size-1);
+  for( Entry* e=_entries; e!=NULL; e=e->next ) {
+    if( (strncmp(e->text,s,len) == 0) && (e->text[len] == '\0') ) {
+      if( e->refs < UINT16_MAX ) e->refs++;
+      return e->text;
+    }
+  }
+  size_t n = offsetof(Entry,text) + len + 1;
+  Entry* e = (Entry*)malloc(n);
+  if( e == NULL ) return "";
+  memcpy(e->text,s,len);
+  e->text[len] = '\0';
+  e->refs      = 1;
+  e->next      = _entries;
+  _entries     = e;
+  _count++;
+  _bytes += n;
+  return e->text;
 }
 
-void UPnPObject::setDisplayName(const char* name) {strlcpy(_displayName, name, sizeof(_displayName));}
+void StringTable::release(const char* s) {
+  for( Entry** p=&_entries; *p!=NULL; p=&(*p)->next ) {
+    Entry* e = *p;
+    if( e->text != s ) continue;
+    if( e->refs == UINT16_MAX ) return;
+    if( --e->refs == 0 ) {
+      *p = e->next;
+      _count--;
+      _bytes -= offsetof(Entry,text) + strlen(e->text) + 1;
+      free(e);
+    }
+    return;
+  }
+}
+
+const char service_description[] PROGMEM = "<service><serviceType>%s</serviceType><serviceId>urn:LeelanauSoftware-com:serviceId:%s</serviceId>"
+                                           "<SCPDURL>%s</SCPDURL><controlURL>%s</controlURL><eventSubURL>%s%s</eventSubURL></service>";
+
+/**
+ *  Walk base() from this to the ancestor at depth d, used only beyond RTTI_MAX_DEPTH
+ */
+const ClassType* ClassType::ancestor(int d) const {
+  const ClassType* t = this;
+  for( int i=_depth; (i>d) && (t!=NULL); i-- ) t = t->_base;
+  return t;
+}
+
+UPnPObject::UPnPObject() {_targetHash = hashTarget(_target,0);}
+
+UPnPObject::~UPnPObject() {
+  StringTable::release(_target);
+  StringTable::release(_displayName);
+  free(_path);
+  free(_location);
+}
+
+/**
+ *  The new name is interned before the old one is released, so setting a name an Object already has never frees it
+ */
+void UPnPObject::setDisplayName(const char* name) {
+  const char* old = _displayName;
+  _displayName = StringTable::intern(name,NAME_SIZE);
+  StringTable::release(old);
+  markDirty();
+  hierarchyChanged();
+}
 
 /** 
  *  Target is the relative URL for this Object (RootDevice, Device, or Service). The complete URL can be constructed as 
@@ -52,8 +127,36 @@ void UPnPObject::setDisplayName(const char* name) {strlcpy(_displayName, name, s
  *  in setting HTTP handlers, so target must be set prior to RootDevice setup.
  */
 void UPnPObject::setTarget(const char* target) {
-  if( target[0] == '/' ) strlcpy(_target, target+1, sizeof(_target));
-  else strlcpy(_target, target, sizeof(_target));
+  const char* old = _target;
+  _target = StringTable::intern(((target[0] == '/')?(target+1):(target)),TARGET_SIZE);
+  StringTable::release(old);
+  _targetHash = hashTarget(_target,strlen(_target));
+  invalidatePaths();
+}
+
+uint32_t UPnPObject::hashTarget(const char* s, size_t len) {
+  uint32_t h = 2166136261u;
+  for( size_t i=0; i<len; i++ ) {h ^= (uint8_t)s[i]; h *= 16777619u;}
+  return h;
+}
+
+/**
+ *  In router mode the RootDevice finds this Object by walking targets, so nothing is registered with the Web server
+ */
+void UPnPObject::registerHandler(WebContext* svr, const char* handlerName) {
+  RootDevice* root = rootDevice();
+  if( (root != NULL) && root->routerMode() ) return;
+  Metrics*    metrics = ((root != NULL)?(root->metrics()):(NULL));
+  if( handlerName[0] == '\0' ) {
+    RouteMetrics* m = ((metrics != NULL)?(metrics->route(path())):(NULL));
+    svr->on(path(),[this,metrics,m](WebContext* svr){MetricsScope scope(metrics,m); this->dispatch(svr,"");});
+  }
+  else {
+    char pathBuffer[100];
+    handlerPath(pathBuffer,100,handlerName);
+    RouteMetrics* m = ((metrics != NULL)?(metrics->route(pathBuffer)):(NULL));
+    svr->on(pathBuffer,[this,handlerName,metrics,m](WebContext* svr){MetricsScope scope(metrics,m); this->dispatch(svr,handlerName);});
+  }
 }
 
 RootDevice* UPnPObject::rootDevice() {
@@ -66,24 +169,49 @@ RootDevice* UPnPObject::rootDevice() {
   return result->asRootDevice();
 }
 
-void UPnPObject::getPath(char buffer[], size_t size) {
-  buffer[0] = '\0';
-  if( getParent() != NULL ) {
-    UPnPObject* d = getParent();
-    if( d->getParent() != NULL ) {
-       UPnPObject* r = d->getParent();
-       snprintf(buffer,size,"/%s/%s/%s",r->getTarget(),d->getTarget(),getTarget());
-    }
-    else snprintf(buffer,size,"/%s/%s",d->getTarget(),getTarget());
+/**
+ *  Path is the parent path followed by "/target", formatted once per hierarchy change
+ */
+const char* UPnPObject::path() {
+  if( (_path == NULL) || (_pathGen != _pathGeneration) ) {
+    const char* parentPath = ((getParent()!=NULL)?(getParent()->path()):(""));
+    size_t      size       = strlen(parentPath) + strlen(getTarget()) + 2;
+    char*       p          = (char*)realloc(_path,size);
+    if( p == NULL ) return "";
+    snprintf(p,size,"%s/%s",parentPath,getTarget());
+    _path    = p;
+    _pathGen = _pathGeneration;
   }
-  else snprintf(buffer,size,"/%s",getTarget());
+  return _path;
 }
 
+/**
+ *  Location is "http://address:port" followed by path(). Objects that are not (yet) part of a RootDevice
+ *  hierarchy have no server, so their location is just path().
+ */
+const char* UPnPObject::getLocation(IPAddress ifc) {
+  uint32_t addr = (uint32_t)ifc;
+  if( (_location == NULL) || (_locationGen != _pathGeneration) || (_locationAddr != addr) ) {
+    RootDevice* root = rootDevice();
+    char        prefix[32];
+    prefix[0] = '\0';
+    if( root != NULL ) snprintf(prefix,sizeof(prefix),"http://%u.%u.%u.%u:%d",ifc[0],ifc[1],ifc[2],ifc[3],root->serverPort());
+    const char* p    = path();
+    size_t      size = strlen(prefix) + strlen(p) + 1;
+    char*       loc  = (char*)realloc(_location,size);
+    if( loc == NULL ) return "";
+    snprintf(loc,size,"%s%s",prefix,p);
+    _location     = loc;
+    _locationGen  = _pathGeneration;
+    _locationAddr = addr;
+  }
+  return _location;
+}
+
+void UPnPObject::getPath(char buffer[], size_t size) {strlcpy(buffer,path(),size);}
+
 void UPnPObject::handlerPath(char buffer[], size_t bufferSize, const char* handlerName) {
-  getPath(buffer,bufferSize);
-  int len = strlen(buffer);
-  int size = bufferSize - len;
-  snprintf(buffer+len,size,"/%s",handlerName);
+  snprintf(buffer,bufferSize,"%s/%s",path(),handlerName);
 }
 
 /** % encodes ULR string
@@ -107,21 +235,37 @@ void UPnPObject::encodePath(char buffer[], size_t bufferSize, const char* path)
   else buffer[bufferSize-1] = '\0';
 }
 
-void UPnPService::location(char buffer[], int buffSize, IPAddress ifc) {
-  UPnPObject* p = getParent();
-  if( p != NULL ) {
-    p->location(buffer,buffSize,ifc);
-    int pos = strlen(buffer);
-    int size = buffSize-pos;
-    snprintf(buffer+pos,size,"/%s",getTarget());
-  }
-  else snprintf(buffer, buffSize,"/%s",getTarget());
+void  UPnPService::setup(WebContext* svr) {
+  registerHandler(svr);
+  if( isEvented() ) registerHandler(svr,"event");
 }
 
-void  UPnPService::setup(WebContext* svr) {
-  char pathBuffer[100];
-  getPath(pathBuffer,100);
-  svr->on(pathBuffer,[this](WebContext* svr){this->handleRequest(svr);});
+/**
+ *  Services have no SCPD document of their own, so the service path serves as both SCPD and control URL
+ */
+void UPnPService::formatDescription(ResponseStream& out) {
+  out.printf_P(service_description,getType(),getTarget(),path(),path(),((isEvented())?(path()):("")),((isEvented())?("/event"):("")));
+}
+
+void UPnPService::formatProperty(ResponseStream& out, const char* name, const char* value) {
+  out.printf_P(PSTR("<e:property><%s>"),name);
+  out.printEscaped(value);
+  out.printf_P(PSTR("</%s></e:property>"),name);
+}
+
+/**
+ *  Event subscriptions are held by the RootDevice
+ */
+boolean UPnPService::dispatch(WebContext* svr, const char* handlerName) {
+  if( strcmp(handlerName,"event") == 0 ) {
+    RootDevice* root = rootDevice();
+    if( !isEvented() || (root == NULL) ) return false;
+    root->events()->handleRequest(svr,this);
+    return true;
+  }
+  if( handlerName[0] != '\0' ) return false;
+  handleRequest(svr);
+  return true;
 }
 
 } // End of namespace lsc
@@ -26,6 +26,8 @@
 #include <Arduino.h>
 #include <ctype.h>
 #include <WebContext.h>
+#include "ResponseStream.h"
+#include "Parameters.h"
 
 /** Leelanau Software Company namespace 
 *  
@@ -42,36 +44,48 @@ typedef std::function<void(void)> CallbackFunction;
  *   Note that the static upnpType() is tied to the class and virtual getType() is tied to the instance of an Object
  *   the same way that classType() is tied to the class and isClassType() tied to the instance
  */
-#define DEFINE_RTTI     private: static const ClassType  _classType;                                                           \
-                        public:  static const ClassType* classType()                 {return &_classType;}                     \
-                        public:  virtual void*           as(const ClassType* t)      {return((isClassType(t))?(this):(NULL));} \
-                        private: static const char*      _upnpType;                                                            \
-                        public:  static const char*      upnpType()                  {return _upnpType;}                       \
-                        public:  virtual const char*     getType()                   {return upnpType();}                      \
+#define DEFINE_RTTI     private: static const ClassType  _classType;                                                                        \
+                        public:  static constexpr const ClassType* classType()       {return &_classType;}                                \
+                        public:  virtual void*           as(const ClassType* t)      {return((_classType.isClassType(t))?(this):(NULL));} \
+                        private: static const char*      _upnpType;                                                                         \
+                        public:  static const char*      upnpType()                  {return _upnpType;}                                    \
+                        public:  virtual const char*     getType()                   {return upnpType();}                                   \
                         public:  virtual boolean         isType(const char* t)       {return(strcmp(t,getType()) == 0);}  
 
 /**
- *   Define type check for classes derived from a single Base Class
+ *   Define type check for classes derived from a single Base Class. BaseClass is recorded as the base of this class's ClassType,
+ *   so every class using DEFINE_RTTI must also declare its base with DERIVED_TYPE_CHECK (or BASE_TYPE_CHECK).
  */
-#define DERIVED_TYPE_CHECK(BaseClass) public: virtual boolean isClassType( const ClassType* t) {return (_classType.isClassType(t) || BaseClass::isClassType(t));}
+#define DERIVED_TYPE_CHECK(BaseClass) public: virtual boolean isClassType( const ClassType* t) {return _classType.isClassType(t);}           \
+                                      public: static constexpr const ClassType* baseClassType() {return BaseClass::classType();}           \
+                                      public: static constexpr int classDepth()                 {return BaseClass::classDepth()+1;}        \
+                                      public: static constexpr const ClassType* ancestorType(int d)                                        \
+                                                {return ((d == classDepth())?(&_classType):(BaseClass::ancestorType(d)));}
 
 /**
- *   Note that isClassType() could be defined for multiple inheritance, however the as() operator will not work correctly when the second (or subsequent) class
+ *   Note that the as() operator will not work correctly for multiple inheritance when the second (or subsequent) class
  *   has one or more virtual methods. The virtual methods will not properly resolve.  This RTTI subsystem is therefore to be used ONLY in single inheritance
- *   class hierarchys. Multiple inheritance type check would look like:
- *   virtual boolean   isClassType( const ClassType* t) {return (_classType.isClassType(t) || ClassName1::isClassType(t) || ... || ClassNameN::isClassType(t));}
+ *   class hierarchys, and a ClassType records only a single base.
  */
 
 /**
  *   Define type check for base classes
  *   Note: This should only be necessary for classes that are NOT subclasses of UPnPObject
  */
-#define BASE_TYPE_CHECK  public: virtual boolean isClassType( const ClassType* t) {return _classType.isClassType(t);}
+#define BASE_TYPE_CHECK  public: virtual boolean isClassType( const ClassType* t) {return _classType.isClassType(t);}         \
+                         public: static constexpr const ClassType* baseClassType() {return NULL;}                            \
+                         public: static constexpr int classDepth()                 {return 0;}                               \
+                         public: static constexpr const ClassType* ancestorType(int d) {return ((d == 0)?(&_classType):(NULL));}
 
 /**
- *   Define static initializer for className::_classType; this should appear at the top of the .cpp file when using DEFINE_RTTI
+ *   Define static initializer for className::_classType; this should appear at the top of the .cpp file when using DEFINE_RTTI.
+ *   The initializer is a constant expression, so _classType, including its depth and ancestor table, is initialized at compile time 
+ *   regardless of static initialization order. There is one ancestorType() entry for each of the RTTI_MAX_DEPTH levels.
  */
-#define INITIALIZE_STATIC_TYPE(className)  const ClassType className::_classType = ClassType()
+#define INITIALIZE_STATIC_TYPE(className)  const ClassType className::_classType = ClassType(#className,className::baseClassType(),       \
+                                             className::classDepth(),{{className::ancestorType(0),className::ancestorType(1),                 \
+                                                                       className::ancestorType(2),className::ancestorType(3),                 \
+                                                                       className::ancestorType(4),className::ancestorType(5)}})
 
 /**
  *   Define static initializer for device type className::_upnpType; this should appear at the top of the .cpp file when using DEFINE_RTTI
@@ -94,17 +108,78 @@ class UPnPService;
 class UPnPDevice;
 class RootDevice;
 
+/** ClassType class definition
+ *  A ClassType identifies a class in a single inheritance hierarchy by name and base ClassType. Construction is constexpr, so 
+ *  ClassTypes are fixed at compile time and identity does not depend on static initialization order.
+ *  Class members are as follows:
+ *    typeID()          := Deterministic ID, the FNV-1a hash of the class name
+ *    name()            := Class name
+ *    base()            := ClassType of the base class, or NULL
+ *    depth()           := Depth in the hierarchy, 0 for a base class
+ *    isClassType(t)    := True if this is t or is derived from t. Each ClassType holds its ancestors indexed by depth, computed at 
+ *                         compile time by INITIALIZE_STATIC_TYPE, so the test is a single comparison: the ancestor of this at the 
+ *                         depth of t must be t. Hierarchies deeper than RTTI_MAX_DEPTH walk base() for the deeper levels.
+ */
+#define RTTI_MAX_DEPTH 6
+
 class ClassType {
   public:
-    ClassType() {_typeID=++_numTypes;}
+    struct Ancestors {const ClassType* type[RTTI_MAX_DEPTH];};
 
-    int         typeID() const               {return _typeID;}
-    
-    boolean     isClassType( const ClassType* t) const {return ((t!=NULL)?(this->typeID() == t->typeID()):(false));}
+    constexpr ClassType(const char* name, const ClassType* base, int depth, Ancestors ancestors) 
+                      : _name(name), _base(base), _typeID(hash(name)), _depth(depth), _ancestors(ancestors) {}
+
+    uint32_t          typeID() const                          {return _typeID;}
+    const char*       name() const                            {return _name;}
+    const ClassType*  base() const                            {return _base;}
+    int               depth() const                           {return _depth;}
+
+    boolean           isClassType( const ClassType* t) const  {
+      if( t == NULL || t->_depth > _depth ) return false;
+      return ((t->_depth < RTTI_MAX_DEPTH)?(_ancestors.type[t->_depth] == t):(ancestor(t->_depth) == t));
+    }
+
+    static constexpr uint32_t hash(const char* s, uint32_t h = 2166136261u) {return ((*s == '\0')?(h):(hash(s+1,(h ^ (uint8_t)*s) * 16777619u)));}
 
   private:
-    static int   _numTypes;
-    int          _typeID;
+    const ClassType*   ancestor(int d) const;
+
+    const char*        _name;
+    const ClassType*   _base;
+    uint32_t           _typeID;
+    int                _depth;
+    Ancestors          _ancestors;
+};
+
+/** StringTable class definition
+ *  Targets and display names of every Object are interned in one table of reference counted heap strings, each held 
+ *  once at exact size however many Objects share it; an Object holds only pointers. Every GetConfiguration and 
+ *  SetConfiguration service in a hierarchy, for example, shares one copy of its target and one of its display name.
+ *  Class members are as follows:
+ *    intern(s,size)     := Returns the table's copy of the first size-1 characters of s, adding it if it is not already
+ *                          held, and takes a reference to it. Returns an empty string if memory runs out
+ *    release(s)         := Drops a reference taken by intern(); a string is freed with its last reference. Strings not
+ *                          held by the table, such as constant defaults, are ignored
+ *    count()            := Number of strings held
+ *    bytes()            := Heap bytes held, entry headers included
+ */
+class StringTable {
+  public:
+    static const char*  intern(const char* s, size_t size);
+    static void         release(const char* s);
+    static int          count()             {return _count;}
+    static size_t       bytes()             {return _bytes;}
+
+  private:
+    struct Entry {
+      Entry*    next;
+      uint16_t  refs;
+      char      text[1];                    // Allocated at the length of the string
+    };
+
+    static Entry*       _entries;
+    static int          _count;
+    static size_t       _bytes;
 };
 
 /** UPnPObject class definition.
@@ -113,6 +188,25 @@ class ClassType {
  *                      or "/rootTarget/serviceTarget"
  *     _parent       := A pointer to the UPnPDevice containing this service
  *     _displayName  := Name of Object for display purposes
+ *
+ *  Target and display name point into the StringTable (or to constant defaults), so they cost an Object two pointers
+ *  rather than TARGET_SIZE and NAME_SIZE bytes. They are still limited to TARGET_SIZE-1 and NAME_SIZE-1 characters, and
+ *  the pointers returned by getTarget() and getDisplayName() are valid until the next setTarget() or setDisplayName() on
+ *  the same Object; copy a name that must outlive a rename. The new value is interned before the old is released, so a
+ *  setter may be passed the current value, or another Object's.
+ *     path()        := Complete target path from root, e.g. "/rootTarget/deviceTarget/serviceTarget"
+ *     getLocation() := Complete URL for an interface address, e.g. "http://192.168.1.10:80/rootTarget/deviceTarget"
+ *
+ *  Path and location are formatted on first use and cached on the heap at exact size. Caches are invalidated by any change 
+ *  of target, parent, or server port anywhere in the hierarchy (tracked by the static _pathGeneration), and the location cache 
+ *  is also rebuilt when requested for a different interface address. Returned pointers are valid until the next such change.
+ *
+ *  stateVersion() changes whenever the Object's display name changes or markDirty() is called, and keys content cached 
+ *  from the Object (see RenderCache). Subclasses call markDirty() when anything they render changes.
+ *
+ *  hierarchyVersion() changes whenever anything described by the UPnP description document changes: any path change, 
+ *  a display name, or a device UUID. Content cached from the hierarchy (see RootDevice::getDescription()) is rebuilt 
+ *  when the version it was built from is no longer current.
  *    
  *  Static Members defined in the macro DEFINE_RTTI 
  *     _classType    := Bespoke RTTI class type and associated methods    
@@ -133,7 +227,8 @@ class UPnPObject {
    public:
 
      UPnPObject();
-     UPnPObject(const char* target) {setTarget(target);}
+     UPnPObject(const char* target) : UPnPObject() {setTarget(target);}
+     virtual ~UPnPObject();
 
      void           setTarget(const char* target);
      void           setDisplayName(const char* name);
@@ -144,10 +239,36 @@ class UPnPObject {
      UPnPDevice*    parentAsDevice()      {return ((_parent!=NULL)?(_parent->asDevice()):(NULL));}
      boolean        hasParent()           {return getParent() != NULL;}
      RootDevice*    rootDevice();
-     void           getPath(char buffer[], size_t size);                              // Returns a complete target path from root, including this target
+     uint32_t       targetHash()          {return _targetHash;}
+     static uint32_t hierarchyVersion()   {return _hierarchyVersion;}
+     uint32_t       stateVersion()        {return _stateVersion;}
+     void           markDirty()           {_stateVersion++;}
+     const char*    path();                                                           // Cached complete target path from root, including this target
+     const char*    getLocation(IPAddress addr);                                      // Cached complete URL of this Object for interface addr
+     void           getPath(char buffer[], size_t size);                              // Copies path() into buffer
      void           handlerPath(char buffer[], size_t size, const char* handlerName); // Concatenate handlerName to path
 
      static void    encodePath(char buffer[], size_t size, const char* path);         // URL Encode path into buffer. Replaces '/' with "%2F"
+     static uint32_t hashTarget(const char* s, size_t len);                          // FNV-1a hash of the first len characters of s
+
+/**
+ *   Request routing. Each Object handles requests for its own path and for handler names appended to it,
+ *   e.g. "/rootTarget/deviceTarget/displayControl". 
+ *     registerHandler(svr,name) := Called from setup(); arranges for requests to path()/name (or path() when name is empty) 
+ *                                  to be handed to dispatch(). Registers the path with the Web server unless the RootDevice 
+ *                                  is in router mode, in which case the RootDevice routes requests itself (see RootDevice::route()).
+ *                                  name must be a string literal or otherwise outlive the Object. Requests are measured
+ *                                  when the RootDevice has metrics on (see RootDevice::metrics()).
+ *     dispatch(svr,name)        := Handle a request for handler name ("" for this Object's own path). Returns false if the
+ *                                  name is not handled. Subclasses adding handlers override dispatch() and fall back to
+ *                                  their base class.
+ *     child(s,len,hash)         := Returns the embedded Object whose target is the len characters at s (with hashTarget() 
+ *                                  equal to hash), or NULL
+ */
+     void                    registerHandler(WebContext* svr, const char* handlerName = "");
+     virtual boolean         dispatch(WebContext* svr, const char* handlerName)           {return false;}
+     virtual UPnPObject*     child(const char* segment, size_t len, uint32_t hash)        {return NULL;}
+     boolean                 isTarget(const char* segment, size_t len, uint32_t hash)     {return (hash == _targetHash) && (strncmp(_target,segment,len) == 0) && (_target[len] == '\0');}
 
      public:
      DEFINE_RTTI;
@@ -156,15 +277,29 @@ class UPnPObject {
      virtual RootDevice*     asRootDevice()                        = 0;
      virtual UPnPService*    asService()                           = 0;
      virtual UPnPDevice*     asDevice()                            = 0;
-     virtual void            location(char buffer[], int buffSize, IPAddress addr) = 0;
+     virtual void            location(char buffer[], int buffSize, IPAddress addr) {strlcpy(buffer,getLocation(addr),buffSize);}
      DEFINE_EXCLUSIONS(UPnPObject);         
 
    protected:
-     char                  _target[TARGET_SIZE];
-     char                  _displayName[NAME_SIZE];
+     const char*           _target      = "";
+     const char*           _displayName = " ";                                    // Display name defaults to blank
      UPnPObject*           _parent = NULL;
-
-     void           setParent(UPnPObject* parent)  {_parent = parent;}
+     uint32_t              _targetHash = 0;
+     uint32_t              _stateVersion = 1;
+
+     void           setParent(UPnPObject* parent)  {_parent = parent; invalidatePaths();}
+     static void    invalidatePaths()              {_pathGeneration++; _hierarchyVersion++;}
+     static void    hierarchyChanged()             {_hierarchyVersion++;}
+     static uint32_t pathGeneration()              {return _pathGeneration;}
+
+   private:
+     char*                 _path            = NULL;
+     char*                 _location        = NULL;
+     uint32_t              _pathGen         = 0;
+     uint32_t              _locationGen     = 0;
+     uint32_t              _locationAddr    = 0;
+     static uint32_t       _pathGeneration;
+     static uint32_t       _hierarchyVersion;
 
 };
 
@@ -172,6 +307,13 @@ class UPnPObject {
  *  UPnPService is set up to hanele HTTP requests to the target /rootTarget/deviceTarget/serviceTarget
  *  Service implementations can either subclass UPnPService and override handleRequest(), or set a
  *  handler function from the parent UPnPDevice, for example see the GetConfiguration service.
+ *
+ *  A service is evented (GENA) once it has a properties function, set with setEventProperties() prior to setup(). Control points
+ *  then subscribe at /rootTarget/deviceTarget/serviceTarget/event and are sent the properties it writes whenever they change:
+ *    setEventProperties(f)        := Sets the function that writes the evented properties, typically with formatProperty()
+ *    formatProperty(out,n,v)      := Writes one property, <e:property><n>v</n></e:property>, escaping v
+ *    propertiesChanged()          := Records that property values have changed; subscribers are notified from the loop()
+ *    eventVersion()               := Incremented by propertiesChanged()
  */
 
 class UPnPService : public UPnPObject {
@@ -200,10 +342,20 @@ class UPnPService : public UPnPObject {
      virtual RootDevice*      asRootDevice()  {return NULL;}
      virtual UPnPDevice*      asDevice()      {return NULL;}
      virtual UPnPService*     asService()     {return this;}
-     virtual void             location(char buffer[], int buffSize, IPAddress addr);
      virtual void             setup(WebContext* svr);
+     virtual boolean          dispatch(WebContext* svr, const char* handlerName);
+     virtual void             formatDescription(ResponseStream& out);       // <service> element of the device description
+
+     boolean                  isEvented()                          {return (bool)_properties;}
+     void                     setEventProperties(RenderFunction f) {_properties = f;}
+     void                     formatProperties(ResponseStream& out) {if( isEvented() ) _properties(out);}
+     void                     propertiesChanged()                  {_eventVersion++;}
+     uint32_t                 eventVersion()                       {return _eventVersion;}
+     static void              formatProperty(ResponseStream& out, const char* name, const char* value);
 
      HandlerFunction          _handler = [](WebContext* svr) {};
+     RenderFunction           _properties = NULL;
+     uint32_t                 _eventVersion = 1;
 
      friend class             UPnPDevice;
 
@@ -0,0 +1,158 @@
+/**
+ * 
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+#include "UUID.h"
+
+#ifdef ESP32
+#include <esp_random.h>
+#endif
+
+/** Leelanau Software Company namespace 
+*  
+*/
+namespace lsc {
+
+static int hexValue(char c) {
+  if( (c >= '0') && (c <= '9') ) return c - '0';
+  if( (c >= 'a') && (c <= 'f') ) return c - 'a' + 10;
+  if( (c >= 'A') && (c <= 'F') ) return c - 'A' + 10;
+  return -1;
+}
+
+/**
+ *  Hyphens are at positions 8, 13, 18 and 23 of the canonical form; every other character is a hex digit
+ */
+boolean UUID::parse(const char* s) {
+  if( s == NULL ) return false;
+  if( strncasecmp(s,"uuid:",5) == 0 ) s += 5;
+  uint8_t b[16];
+  int     n = 0;
+  for( int i=0; i<UUID_SIZE-1; i++ ) {
+    if( (i == 8) || (i == 13) || (i == 18) || (i == 23) ) {
+      if( s[i] != '-' ) return false;
+      continue;
+    }
+    int hi = hexValue(s[i]);
+    int lo = ((hi < 0)?(-1):(hexValue(s[++i])));
+    if( lo < 0 ) return false;
+    b[n++] = (uint8_t)((hi << 4) | lo);
+  }
+  if( s[UUID_SIZE-1] != '\0' ) return false;
+  memcpy(_words,b,16);
+  return true;
+}
+
+void UUID::format(char buffer[]) const {
+  static const char hex[] = "0123456789abcdef";
+  const uint8_t* b = bytes();
+  int j = 0;
+  for( int i=0; i<16; i++ ) {
+    if( (i == 4) || (i == 6) || (i == 8) || (i == 10) ) buffer[j++] = '-';
+    buffer[j++] = hex[b[i] >> 4];
+    buffer[j++] = hex[b[i] & 0x0F];
+  }
+  buffer[j] = '\0';
+}
+
+/**
+ *  SHA-1 (FIPS 180-4), only as needed for name based UUIDs: hashes the concatenation of prefix and name
+ */
+static inline uint32_t rol(uint32_t x, int n) {return (x << n) | (x >> (32-n));}
+
+static void sha1Block(uint32_t h[5], const uint8_t block[64]) {
+  uint32_t w[80];
+  for( int i=0; i<16; i++ ) w[i] = ((uint32_t)block[4*i] << 24) | ((uint32_t)block[4*i+1] << 16) | ((uint32_t)block[4*i+2] << 8) | block[4*i+3];
+  for( int i=16; i<80; i++ ) w[i] = rol(w[i-3] ^ w[i-8] ^ w[i-14] ^ w[i-16],1);
+  uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+  for( int i=0; i<80; i++ ) {
+    uint32_t f, k;
+    if( i < 20 )      {f = (b & c) | (~b & d);          k = 0x5A827999;}
+    else if( i < 40 ) {f = b ^ c ^ d;                   k = 0x6ED9EBA1;}
+    else if( i < 60 ) {f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC;}
+    else              {f = b ^ c ^ d;                   k = 0xCA62C1D6;}
+    uint32_t t = rol(a,5) + f + e + k + w[i];
+    e = d; d = c; c = rol(b,30); b = a; a = t;
+  }
+  h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+}
+
+static void sha1(const uint8_t* prefix, size_t prefixLen, const char* name, size_t nameLen, uint8_t digest[20]) {
+  uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+  uint8_t  block[64];
+  size_t   total = prefixLen + nameLen;
+  size_t   pos   = 0;
+  for( size_t i=0; i<total; i++ ) {
+    block[pos++] = ((i < prefixLen)?(prefix[i]):((uint8_t)name[i-prefixLen]));
+    if( pos == 64 ) {sha1Block(h,block); pos = 0;}
+  }
+  block[pos++] = 0x80;
+  if( pos > 56 ) {
+    while( pos < 64 ) block[pos++] = 0;
+    sha1Block(h,block);
+    pos = 0;
+  }
+  while( pos < 56 ) block[pos++] = 0;
+  uint64_t bits = (uint64_t)total * 8;
+  for( int i=7; i>=0; i-- ) block[pos++] = (uint8_t)(bits >> (8*i));
+  sha1Block(h,block);
+  for( int i=0; i<20; i++ ) digest[i] = (uint8_t)(h[i/4] >> (24 - 8*(i%4)));
+}
+
+void UUID::nameBased(const UUID& ns, const char* name) {
+  uint8_t digest[20];
+  sha1(ns.bytes(),16,name,strlen(name),digest);
+  uint8_t* b = bytes();
+  memcpy(b,digest,16);
+  b[6] = (b[6] & 0x0F) | 0x50;              // Version 5, name based with SHA-1
+  b[8] = (b[8] & 0x3F) | 0x80;              // RFC 4122 variant
+}
+
+/**
+ *  xorshift64* generator, seeded once from the hardware random number generator on ESP8266/ESP32, or from the 
+ *  clock otherwise
+ */
+static uint64_t nextRandom() {
+  static uint64_t state = 0;
+  while( state == 0 ) {
+#if defined(ESP32)
+    state = ((uint64_t)esp_random() << 32) | esp_random();
+#elif defined(ESP8266)
+    state = ((uint64_t)RANDOM_REG32 << 32) | RANDOM_REG32;
+#else
+    state = ((uint64_t)micros() << 32) ^ (uint64_t)(uintptr_t)&state ^ millis();
+#endif
+  }
+  state ^= state >> 12;
+  state ^= state << 25;
+  state ^= state >> 27;
+  return state * 0x2545F4914F6CDD1DULL;
+}
+
+void UUID::random() {
+  _words[0] = nextRandom();
+  _words[1] = nextRandom();
+  uint8_t* b = bytes();
+  b[6] = (b[6] & 0x0F) | 0x40;              // Version 4, random
+  b[8] = (b[8] & 0x3F) | 0x80;              // RFC 4122 variant
+}
+
+} // End of namespace lsc
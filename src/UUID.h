@@ -0,0 +1,77 @@
+/**
+ * 
+ *  UPnPDevice Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+#ifndef UPNP_UUID_H
+#define UPNP_UUID_H
+
+#include <Arduino.h>
+
+/** Leelanau Software Company namespace 
+*  
+*/
+namespace lsc {
+
+#define UUID_SIZE    37
+
+/** UUID class definition
+ *  A UUID is held as 16 raw bytes (two 64 bit words), so comparison is two word compares, and is only formatted as a 
+ *  canonical string xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx on request.
+ *  Class members are as follows:
+ *    parse(s)                  := Sets this UUID from the canonical string s, with or without a "uuid:" prefix. Returns false, 
+ *                                 leaving this UUID unchanged, if s is not a valid UUID
+ *    format(buffer)            := Formats the canonical string into buffer of at least UUID_SIZE characters
+ *    nameBased(ns,name)        := Sets a version 5 (SHA-1 name based) UUID for name in namespace ns, per RFC 4122. The same
+ *                                 namespace and name always produce the same UUID.
+ *    random()                  := Sets a version 4 (random) UUID from a xorshift PRNG seeded from the hardware random 
+ *                                 number generator where available
+ *    isNull()                  := True if all bytes are 0, as for a UUID that has not been set
+ *    hash()                    := 32 bit hash of the UUID bytes
+ *    bytes()                   := The 16 bytes, in network order
+ *    isValid(s)                := True if s is a canonical UUID string
+ */
+class UUID {
+  public:
+    UUID()                                        {clear();}
+
+    boolean          parse(const char* s);
+    void             format(char buffer[]) const;
+    void             nameBased(const UUID& ns, const char* name);
+    void             random();
+    void             clear()                      {_words[0] = _words[1] = 0;}
+
+    boolean          isNull() const               {return (_words[0] | _words[1]) == 0;}
+    uint32_t         hash() const                 {uint64_t h = _words[0] ^ _words[1]; return (uint32_t)(h ^ (h >> 32));}
+    const uint8_t*   bytes() const                {return (const uint8_t*)_words;}
+    uint8_t*         bytes()                      {return (uint8_t*)_words;}
+
+    boolean          operator==(const UUID& u) const {return (_words[0] == u._words[0]) && (_words[1] == u._words[1]);}
+    boolean          operator!=(const UUID& u) const {return !(*this == u);}
+
+    static boolean   isValid(const char* s)       {UUID u; return u.parse(s);}
+
+  private:
+    uint64_t         _words[2];
+};
+
+} // End of namespace lsc
+
+#endif